@@ -0,0 +1,253 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/checkpoint.hpp>
+#include <cstring>
+#include <fstream>
+#ifdef __unix__
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace dynamo {
+  namespace {
+    const char checkpointMagic[8] = {'D','Y','N','A','M','O','C','K'};
+    const uint32_t checkpointVersion = 1;
+    const uint32_t checkpointEndianMarker = 0x01020304;
+    const size_t checkpointAlignment = 64;
+
+    /*! \brief The fixed size header at the start of a checkpoint.*/
+    struct FileHeader
+    {
+      char magic[8];
+      uint32_t version;
+      uint32_t endian;
+      uint64_t xmlOffset;
+      uint64_t xmlSize;
+      uint64_t tableOffset;
+      uint64_t arrayCount;
+      uint64_t fileSize;
+      uint64_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == checkpointAlignment, "Checkpoint header must be 64 bytes");
+
+    /*! \brief An entry in the array table of a checkpoint.*/
+    struct TableEntry
+    {
+      char name[88];
+      char type[8];
+      uint64_t count;
+      uint64_t components;
+      uint64_t offset;
+      uint64_t bytes;
+    };
+    static_assert(sizeof(TableEntry) == 2 * checkpointAlignment, "Checkpoint table entries must be 128 bytes");
+
+    size_t align(const size_t offset)
+    { return (offset + checkpointAlignment - 1) / checkpointAlignment * checkpointAlignment; }
+
+    size_t typeSize(const std::string& type)
+    {
+      if (type == "f64" || type == "u64") return 8;
+      if (type == "u8") return 1;
+      M_throw() << "Unknown checkpoint array type \"" << type << "\"";
+    }
+  }
+
+  bool
+  BinaryCheckpoint::isBinaryFile(const std::string& filename)
+  {
+    return (filename.size() >= 4) && (filename.compare(filename.size() - 4, 4, ".bin") == 0);
+  }
+
+  BinaryCheckpoint::BinaryCheckpoint():
+    _data(NULL), _size(0), _mapped(false)
+  {}
+
+  BinaryCheckpoint::BinaryCheckpoint(const std::string& filename):
+    _data(NULL), _size(0), _mapped(false)
+  {
+#ifdef __unix__
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      M_throw() << "Failed to open " << filename << " for reading.";
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+      {
+	close(fd);
+	M_throw() << "Failed to stat " << filename;
+      }
+    _size = st.st_size;
+
+    if (_size)
+      {
+	void* map = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map != MAP_FAILED)
+	  {
+	    _data = static_cast<const char*>(map);
+	    _mapped = true;
+	  }
+      }
+    close(fd);
+#endif
+
+    if (!_mapped)
+      {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in)
+	  M_throw() << "Failed to open " << filename << " for reading.";
+	in.seekg(0, std::ios::end);
+	_size = in.tellg();
+	in.seekg(0, std::ios::beg);
+	_buffer.resize((_size + sizeof(double) - 1) / sizeof(double));
+	in.read(reinterpret_cast<char*>(_buffer.data()), _size);
+	if (!in)
+	  M_throw() << "Failed while reading " << filename;
+	_data = reinterpret_cast<const char*>(_buffer.data());
+      }
+
+    FileHeader header;
+    if (_size < sizeof(header))
+      M_throw() << filename << " is too small to be a binary checkpoint";
+    std::memcpy(&header, _data, sizeof(header));
+
+    if (std::memcmp(header.magic, checkpointMagic, sizeof(checkpointMagic)))
+      M_throw() << filename << " is not a binary checkpoint file";
+
+    if (header.version != checkpointVersion)
+      M_throw() << filename << " is a version " << header.version
+		<< " binary checkpoint, this build reads version " << checkpointVersion;
+
+    if (header.endian != checkpointEndianMarker)
+      M_throw() << filename << " was written on a machine with a different byte order";
+
+    if ((header.fileSize != _size)
+	|| (header.xmlOffset + header.xmlSize > _size)
+	|| (header.tableOffset + header.arrayCount * sizeof(TableEntry) > _size))
+      M_throw() << filename << " is truncated or corrupt";
+
+    for (size_t i(0); i < header.arrayCount; ++i)
+      {
+	TableEntry entry;
+	std::memcpy(&entry, _data + header.tableOffset + i * sizeof(TableEntry), sizeof(entry));
+	entry.name[sizeof(entry.name) - 1] = '\0';
+	entry.type[sizeof(entry.type) - 1] = '\0';
+
+	Array array;
+	array.name = entry.name;
+	array.type = entry.type;
+	array.count = entry.count;
+	array.components = entry.components;
+	array.offset = entry.offset;
+
+	if ((array.bytes() != entry.bytes) || (array.offset + array.bytes() > _size))
+	  M_throw() << "Array \"" << array.name << "\" in " << filename << " is truncated or corrupt";
+
+	_arrays.push_back(array);
+      }
+
+    _doc.reset(new magnet::xml::Document(_data + header.xmlOffset, header.xmlSize));
+  }
+
+  BinaryCheckpoint::~BinaryCheckpoint()
+  {
+#ifdef __unix__
+    if (_mapped)
+      munmap(const_cast<char*>(_data), _size);
+#endif
+  }
+
+  magnet::xml::Document&
+  BinaryCheckpoint::getDocument()
+  {
+    if (!_doc)
+      M_throw() << "This checkpoint has not been loaded from a file";
+    return *_doc;
+  }
+
+  size_t
+  BinaryCheckpoint::Array::bytes() const
+  { return count * components * typeSize(type); }
+
+  const BinaryCheckpoint::Array*
+  BinaryCheckpoint::findArray(const std::string& name) const
+  {
+    for (const Array& array : _arrays)
+      if (array.name == name)
+	return &array;
+    return NULL;
+  }
+
+  void
+  BinaryCheckpoint::write(const std::string& filename, const std::string& xml) const
+  {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, checkpointMagic, sizeof(checkpointMagic));
+    header.version = checkpointVersion;
+    header.endian = checkpointEndianMarker;
+    header.xmlOffset = sizeof(FileHeader);
+    header.xmlSize = xml.size();
+    header.tableOffset = align(header.xmlOffset + header.xmlSize);
+    header.arrayCount = _arrays.size();
+
+    //Lay out the arrays after the table
+    std::vector<TableEntry> table(_arrays.size());
+    size_t offset = align(header.tableOffset + table.size() * sizeof(TableEntry));
+    for (size_t i(0); i < _arrays.size(); ++i)
+      {
+	const Array& array = _arrays[i];
+	if (array.name.size() >= sizeof(table[i].name))
+	  M_throw() << "Checkpoint array name \"" << array.name << "\" is too long";
+
+	std::memset(&table[i], 0, sizeof(TableEntry));
+	std::strncpy(table[i].name, array.name.c_str(), sizeof(table[i].name) - 1);
+	std::strncpy(table[i].type, array.type.c_str(), sizeof(table[i].type) - 1);
+	table[i].count = array.count;
+	table[i].components = array.components;
+	table[i].offset = offset;
+	table[i].bytes = array.bytes();
+	offset = align(offset + array.bytes());
+      }
+    header.fileSize = offset;
+
+    std::ofstream of(filename, std::ios::binary | std::ios::trunc);
+    if (!of)
+      M_throw() << "Failed to open " << filename << " for writing.";
+
+    const char padding[checkpointAlignment] = {};
+    size_t written = 0;
+    auto writeAt = [&](const size_t position, const char* data, const size_t bytes) {
+      of.write(padding, position - written);
+      of.write(data, bytes);
+      written = position + bytes;
+    };
+
+    writeAt(0, reinterpret_cast<const char*>(&header), sizeof(header));
+    writeAt(header.xmlOffset, xml.data(), xml.size());
+    writeAt(header.tableOffset, reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TableEntry));
+    for (size_t i(0); i < _arrays.size(); ++i)
+      writeAt(table[i].offset, reinterpret_cast<const char*>(_arrays[i].storage.data()), table[i].bytes);
+    of.write(padding, header.fileSize - written);
+
+    if (!of)
+      M_throw() << "Failed during writing of contents of " << filename << ".";
+  }
+}
@@ -0,0 +1,166 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <magnet/exception.hpp>
+#include <magnet/xmlreader.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dynamo {
+  namespace detail {
+    /*! \brief Type tags stored in the array table of a
+        BinaryCheckpoint.*/
+    template<class T> struct CheckpointType;
+    template<> struct CheckpointType<double> { static const char* name() { return "f64"; } };
+    template<> struct CheckpointType<uint64_t> { static const char* name() { return "u64"; } };
+    template<> struct CheckpointType<uint8_t> { static const char* name() { return "u8"; } };
+  }
+
+  /*! \brief The binary checkpoint format for Simulation
+      configurations.
+
+    A checkpoint is a normal configuration file where the bulk
+    per-particle data has been moved out of the XML into raw
+    arrays. The file layout is
+    - A 64 byte header (magic "DYNAMOCK", version, an endianness
+      marker, and the location of the XML and array table).
+    - The XML description of the Simulation. This is identical to
+      the XML configuration file, except the ParticleData and
+      CaptureMap tags have no children and instead name the arrays
+      holding their data.
+    - A table describing each array (name, element type, number of
+      entries and components, and offset).
+    - The arrays themselves, each aligned to 64 bytes.
+
+    The arrays are in the native byte order and may be memory mapped
+    and read in place. The format is selected by using a ".bin"
+    extension in Simulation::loadXMLfile and
+    Simulation::writeXMLfile.
+   */
+  class BinaryCheckpoint
+  {
+  public:
+    /*! \brief Returns true if the filename selects the binary
+        checkpoint format.*/
+    static bool isBinaryFile(const std::string& filename);
+
+    /*! \brief Create an empty checkpoint to be filled and
+        written.*/
+    BinaryCheckpoint();
+
+    /*! \brief Open (memory map) an existing checkpoint file.*/
+    BinaryCheckpoint(const std::string& filename);
+
+    ~BinaryCheckpoint();
+
+    /*! \brief The parsed XML description of a loaded checkpoint.*/
+    magnet::xml::Document& getDocument();
+
+    /*! \brief Add an array to a checkpoint being written.
+
+      \param name A unique name for the array.
+      \param count The number of entries (e.g., particles).
+      \param components The number of values per entry.
+      \return A pointer to the (zeroed) storage for the array.
+     */
+    template<class T>
+    T* addArray(const std::string& name, const size_t count, const size_t components = 1)
+    {
+      if (findArray(name))
+	M_throw() << "Duplicate checkpoint array \"" << name << "\"";
+
+      _arrays.push_back(Array());
+      Array& array = _arrays.back();
+      array.name = name;
+      array.type = detail::CheckpointType<T>::name();
+      array.count = count;
+      array.components = components;
+      array.offset = 0;
+      array.storage.assign((count * components * sizeof(T) + sizeof(double) - 1) / sizeof(double), 0);
+      return reinterpret_cast<T*>(array.storage.data());
+    }
+
+    /*! \brief Access an array of a loaded checkpoint.
+
+      The type, entry count and number of components must match
+      those of the stored array.
+     */
+    template<class T>
+    const T* getArray(const std::string& name, const size_t count, const size_t components = 1) const
+    {
+      const Array* array = findArray(name);
+      if (!array)
+	M_throw() << "Checkpoint array \"" << name << "\" is missing";
+
+      if ((array->type != detail::CheckpointType<T>::name())
+	  || (array->count != count) || (array->components != components))
+	M_throw() << "Checkpoint array \"" << name << "\" has type " << array->type
+		  << "[" << array->count << "x" << array->components << "], expected "
+		  << detail::CheckpointType<T>::name() << "[" << count << "x" << components << "]";
+
+      return reinterpret_cast<const T*>(_data + array->offset);
+    }
+
+    /*! \brief Test if a loaded checkpoint contains the named
+        array.*/
+    bool hasArray(const std::string& name) const { return findArray(name); }
+
+    /*! \brief Write the checkpoint to a file.
+
+      \param filename The file to write.
+      \param xml The XML description of the Simulation.
+     */
+    void write(const std::string& filename, const std::string& xml) const;
+
+  private:
+    BinaryCheckpoint(const BinaryCheckpoint&) = delete;
+    BinaryCheckpoint& operator=(const BinaryCheckpoint&) = delete;
+
+    struct Array
+    {
+      std::string name;
+      std::string type;
+      size_t count;
+      size_t components;
+      //! \brief Offset of the array data from the start of the file.
+      size_t offset;
+      //! \brief The array data, only used when writing. Stored as
+      //! doubles to guarantee the alignment of any element type.
+      std::vector<double> storage;
+
+      size_t bytes() const;
+    };
+
+    const Array* findArray(const std::string& name) const;
+
+    std::vector<Array> _arrays;
+    std::unique_ptr<magnet::xml::Document> _doc;
+
+    //! \brief The start of the loaded file.
+    const char* _data;
+    //! \brief The size of the loaded file.
+    size_t _size;
+    //! \brief If the file could not be mapped, it is read into this
+    //! buffer instead.
+    std::vector<double> _buffer;
+    bool _mapped;
+  };
+}
@@ -118,7 +118,8 @@ namespace dynamo {
       ("n-threads,N", po::value<unsigned int>(),
        "Number of threads to spawn for concurrent processing. (Only utilised by certain engine/sim configurations)")
       ("out-config-file,o", po::value<std::string>(),
-       ("Default config output file,(config.%ID.end.xml"+extension+")").c_str())
+       ("Default config output file,(config.%ID.end.xml"+extension+"). "
+	"A \".bin\" extension writes a binary checkpoint.").c_str())
       ("out-data-file", po::value<std::string>(),
        ("Default result output file (output.%ID.xml"+extension+")").c_str())
       ("config-file", po::value<std::vector<std::string> >(),
@@ -131,7 +132,9 @@ namespace dynamo {
        " Values:\n"
        "  1: \tStandard Engine\n"
        "  2: \tNVT Replica Exchange Engine\n"
-       "  3: \tCompression Engine")
+       "  3: \tCompression Engine\n"
+       "  4: \tSweep Engine (many independent simulations)\n"
+       "  5: \tDomain Decomposition Engine (parallel single simulation)")
       ;
 
     basicOpts.add(systemopts).add(engineopts);
@@ -139,6 +142,8 @@ namespace dynamo {
     Engine::getCommonOptions(detailedEngineOpts);
     EReplicaExchangeSimulation::getOptions(detailedEngineOpts);
     ECompressingSimulation::getOptions(detailedEngineOpts);
+    ESweepSimulation::getOptions(detailedEngineOpts);
+    EDomainSimulation::getOptions(detailedEngineOpts);
   
     allopts.add(basicOpts).add(detailedEngineOpts);
 
@@ -185,6 +190,12 @@ namespace dynamo {
       case (3):
 	_engine = shared_ptr<ECompressingSimulation>(new ECompressingSimulation(vm, _threads));
 	break;
+      case (4):
+	_engine = shared_ptr<ESweepSimulation>(new ESweepSimulation(vm, _threads));
+	break;
+      case (5):
+	_engine = shared_ptr<EDomainSimulation>(new EDomainSimulation(vm, _threads));
+	break;
       default:
 	M_throw() << vm["engine"].as<size_t>()
 		  <<", Unknown Engine Number Selected"; 
@@ -0,0 +1,545 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/coordinator/engine/domains.hpp>
+#include <dynamo/BC/PBC.hpp>
+#include <dynamo/dynamics/newtonian.hpp>
+#include <dynamo/interactions/captures.hpp>
+#include <dynamo/ranges/IDRangeAll.hpp>
+#include <dynamo/ranges/IDPairRangeAll.hpp>
+#include <dynamo/systems/tHalt.hpp>
+#include <dynamo/NparticleEventData.hpp>
+#include <magnet/thread/threadpool.hpp>
+#include <magnet/xmlwriter.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <streambuf>
+#include <typeinfo>
+#include <time.h>
+
+namespace dynamo {
+  namespace {
+    /*! \brief A stream buffer which discards everything written to
+      it.
+
+      Used to silence the (per window) loading output of the domain
+      Simulations.
+     */
+    struct NullBuffer: public std::streambuf
+    {
+      int overflow(int c) { return c; }
+    };
+
+    /*! \brief The CPU time consumed by the calling thread (in
+      seconds).
+
+      Used instead of the wall-clock time so that the parallel
+      efficiency is not distorted when the threads share cores.
+     */
+    double threadCPUTime()
+    {
+      timespec ts;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+      return ts.tv_sec + 1e-9 * ts.tv_nsec;
+    }
+  }
+
+  void
+  EDomainSimulation::getOptions(boost::program_options::options_description& opts)
+  {
+    boost::program_options::options_description
+      ropts("Domain Decomposition Engine Options (--engine=5)");
+
+    ropts.add_options()
+      ("domains", boost::program_options::value<size_t>()->default_value(0, "n-threads"),
+       "Number of slabs the primary image is split into along the x axis. "
+       "The trajectory is reproducible for a fixed number of domains.")
+      ("domain-halo", boost::program_options::value<double>()->default_value(0, "3x interaction range"),
+       "Width of the halo of ghost particles copied into each domain.")
+      ("domain-window", boost::program_options::value<double>()->default_value(0, "automatic"),
+       "Initial length of the time windows the domains are run for between synchronisations.")
+      ("domain-tolerance", boost::program_options::value<double>()->default_value(1e-8),
+       "Relative tolerance when comparing the states of ghost particles against their owning domain.")
+      ;
+
+    opts.add(ropts);
+  }
+
+  EDomainSimulation::EDomainSimulation(const boost::program_options::variables_map& nVm,
+				       magnet::thread::ThreadPool& tp):
+    Engine(nVm, "config.out.xml", "output.xml", tp),
+    _domains(1),
+    _halo(0),
+    _interactionRange(0),
+    _window(0),
+    _initialWindow(0),
+    _minWindow(0),
+    _tolerance(0),
+    _velocityScale(0),
+    _windows(0),
+    _rollbacks(0),
+    _serialWindows(0),
+    _executedEvents(0),
+    _busyTime(0),
+    _parallelWallTime(0),
+    _wallTime(0)
+  {}
+
+  EDomainSimulation::~EDomainSimulation()
+  {
+    if (!_templateFile.empty())
+      {
+	boost::system::error_code ec;
+	boost::filesystem::remove(_templateFile, ec);
+      }
+  }
+
+  void
+  EDomainSimulation::initialisation()
+  {
+    preSimInit();
+
+    if (!(vm.count("config-file")) ||
+	(vm["config-file"].as<std::vector<std::string> >().size() != 1))
+      M_throw() << "You must only provide one input file in domain decomposition mode";
+
+    _sim.ranGenerator.seed(std::random_device()());
+    if (vm.count("random-seed"))
+      _sim.ranGenerator.seed(vm["random-seed"].as<unsigned int>());
+
+    _sim.loadXMLfile(vm["config-file"].as<std::vector<std::string> >()[0]);
+
+    //Check that the system can be split into independent domains
+    if (typeid(*_sim.BCs) != typeid(BCPeriodic))
+      M_throw() << "The domain decomposition engine requires periodic boundary conditions";
+
+    if (typeid(*_sim.dynamics) != typeid(DynNewtonian))
+      M_throw() << "The domain decomposition engine only supports Newtonian dynamics";
+
+    if (!_sim.locals.empty() || !_sim.systems.empty() || !_sim.topology.empty())
+      M_throw() << "The domain decomposition engine does not support Local, System or Topology definitions";
+
+    if (_sim._properties.hasNamedProperties())
+      M_throw() << "The domain decomposition engine does not support per-particle properties";
+
+    for (const shared_ptr<Species>& sp : _sim.species)
+      if (!std::dynamic_pointer_cast<IDRangeAll>(sp->getRange()))
+	M_throw() << "The domain decomposition engine requires every Species to apply to all particles";
+
+    for (const shared_ptr<Interaction>& interaction : _sim.interactions)
+      {
+	if (!std::dynamic_pointer_cast<IDPairRangeAll>(interaction->getRange()))
+	  M_throw() << "The domain decomposition engine requires every Interaction to apply to all particle pairs";
+
+	//The capture maps of the domains and the global system are
+	//rebuilt from the particle positions
+	shared_ptr<ICapture> capture = std::dynamic_pointer_cast<ICapture>(interaction);
+	if (capture) capture->forgetMap();
+      }
+
+    _interactionRange = _sim.getLongestInteraction();
+
+    _halo = vm["domain-halo"].as<double>() * _sim.units.unitLength();
+    if (_halo == 0) _halo = 3 * _interactionRange;
+    if (_halo <= _interactionRange)
+      M_throw() << "The domain halo must be larger than the interaction range ("
+		<< _interactionRange / _sim.units.unitLength() << ")";
+
+    _domains = vm["domains"].as<size_t>();
+    if (_domains == 0) _domains = std::max(threads.getThreadCount(), size_t(1));
+
+    const double Lx = _sim.primaryCellSize[0];
+    if ((_domains > 1) && (Lx * (1 - 1.0 / _domains) <= 2 * _halo))
+      M_throw() << "The primary image is too small for " << _domains
+		<< " domains with a halo width of " << _halo / _sim.units.unitLength()
+		<< ", reduce --domains or --domain-halo";
+
+    for (const Particle& part : _sim.particles)
+      _velocityScale = std::max(_velocityScale, part.getVelocity().nrm());
+    if (_velocityScale == 0)
+      M_throw() << "The domain decomposition engine requires moving particles";
+
+    _initialWindow = vm["domain-window"].as<double>() * _sim.units.unitTime();
+    if (_initialWindow == 0)
+      //Allow the fastest particle to travel half the permitted distance
+      _initialWindow = 0.25 * (_halo - _interactionRange) / _velocityScale;
+    _minWindow = _initialWindow / 64;
+    _window = _initialWindow;
+    _tolerance = vm["domain-tolerance"].as<double>();
+
+    //Write out the system without any particles, this is used to
+    //build each domain
+    _templateFile = (boost::filesystem::temp_directory_path()
+		     / boost::filesystem::unique_path("dynamo-domain-%%%%-%%%%-%%%%.xml")).string();
+    {
+      std::vector<Particle> particles;
+      std::swap(particles, _sim.particles);
+      _sim.writeXMLfile(_templateFile, false);
+      std::swap(particles, _sim.particles);
+    }
+
+    //The global Simulation is only used to hold the committed state,
+    //its Scheduler is never initialised
+    _sim.endEventCount = 0;
+    _sim.initialise();
+    _sim.dynamics->updateAllParticles();
+
+    std::cout << "Domain engine running on " << _domains << " domains (slab width "
+	      << Lx / _domains / _sim.units.unitLength() << ", halo "
+	      << _halo / _sim.units.unitLength() << ") on "
+	      << threads.getThreadCount() << " threads" << std::endl;
+  }
+
+  void
+  EDomainSimulation::DomainRun::eventCallback(const NEventData& data)
+  {
+    const double t = sim->systemTime;
+
+    for (const ParticleEventData& pData : data.L1partChanges)
+      {
+	const size_t ID = pData.getParticleID();
+	path[ID] += pData.getOldVel().nrm() * (t - lastEventTime[ID]);
+	lastEventTime[ID] = t;
+      }
+
+    for (const PairEventData& pData : data.L2partChanges)
+      {
+	const size_t ID1 = pData.particle1_.getParticleID();
+	const size_t ID2 = pData.particle2_.getParticleID();
+	path[ID1] += pData.particle1_.getOldVel().nrm() * (t - lastEventTime[ID1]);
+	path[ID2] += pData.particle2_.getOldVel().nrm() * (t - lastEventTime[ID2]);
+	lastEventTime[ID1] = lastEventTime[ID2] = t;
+	++executedEvents;
+
+	const bool owned1 = ID1 < owned, owned2 = ID2 < owned;
+	if (owned1 && !owned2) touched[ID2] = true;
+	if (owned2 && !owned1) touched[ID1] = true;
+
+	//Each pair event is counted by the owner of the particle with
+	//the lowest ID
+	if ((*owner)[std::min(globalIDs[ID1], globalIDs[ID2])] == domainID)
+	  ++committedEvents;
+      }
+  }
+
+  void
+  EDomainSimulation::decompose(std::vector<DomainRun>& runs, const size_t domains)
+  {
+    runs.assign(domains, DomainRun());
+    const double Lx = _sim.primaryCellSize[0];
+    const double width = Lx / domains;
+
+    _owner.resize(_sim.N());
+    _ownerIndex.resize(_sim.N());
+    std::vector<double> x(_sim.N());
+    for (size_t ID(0); ID < _sim.N(); ++ID)
+      {
+	Vector pos = _sim.particles[ID].getPosition();
+	_sim.BCs->applyBC(pos);
+	x[ID] = pos[0];
+	const size_t d = std::min(size_t(std::max(0.0, std::floor((x[ID] + 0.5 * Lx) / width))), domains - 1);
+	_owner[ID] = d;
+	_ownerIndex[ID] = runs[d].globalIDs.size();
+	runs[d].globalIDs.push_back(ID);
+      }
+
+    for (size_t d(0); d < domains; ++d)
+      {
+	runs[d].owned = runs[d].globalIDs.size();
+	runs[d].domainID = d;
+	runs[d].owner = &_owner;
+	runs[d].committedEvents = 0;
+	runs[d].executedEvents = 0;
+	runs[d].busyTime = 0;
+      }
+
+    if (domains == 1) return;
+
+    //Add the ghosts to the domains within reach of each particle
+    const long reach = long(std::ceil(_halo / width)) + 1;
+    for (size_t ID(0); ID < _sim.N(); ++ID)
+      {
+	std::vector<size_t> added;
+	for (long offset(-reach); offset <= reach; ++offset)
+	  {
+	    const size_t d = size_t((long(_owner[ID]) + offset % long(domains) + long(domains)) % long(domains));
+	    if ((d == _owner[ID]) || (std::find(added.begin(), added.end(), d) != added.end()))
+	      continue;
+
+	    double localx = x[ID] - (-0.5 * Lx + (d + 0.5) * width);
+	    localx -= Lx * std::round(localx / Lx);
+	    if (std::abs(localx) < 0.5 * width + _halo)
+	      {
+		runs[d].globalIDs.push_back(ID);
+		added.push_back(d);
+	      }
+	  }
+      }
+  }
+
+  void
+  EDomainSimulation::runDomain(DomainRun& run, const size_t domains, const size_t domainID, const double dt)
+  {
+    const double start = threadCPUTime();
+
+    try {
+      Simulation sim;
+      sim.simID = domainID;
+      sim.ranGenerator.seed(domainID);
+      sim.loadXMLfile(_templateFile);
+
+      const double Lx = _sim.primaryCellSize[0];
+      const double width = Lx / domains;
+      const double centre = -0.5 * Lx + (domainID + 0.5) * width;
+
+      //The domain is padded with a second halo width of empty space
+      //so the ghosts do not interact with their periodic images
+      if (domains > 1)
+	sim.primaryCellSize[0] = width + 4 * _halo;
+
+      const size_t N = run.globalIDs.size();
+      std::vector<Vector> startPos(N);
+      sim.particles.reserve(N);
+      for (size_t ID(0); ID < N; ++ID)
+	{
+	  const Particle& part = _sim.particles[run.globalIDs[ID]];
+	  Vector pos = part.getPosition();
+	  if (domains > 1)
+	    {
+	      pos[0] -= centre;
+	      pos[0] -= Lx * std::round(pos[0] / Lx);
+	    }
+	  startPos[ID] = pos;
+	  sim.particles.push_back(Particle(pos, part.getVelocity(), ID));
+	}
+
+      sim.systems.push_back(shared_ptr<System>(new SystHalt(&sim, dt / sim.units.unitTime(), "DomainWindow")));
+      sim.endEventCount = std::numeric_limits<size_t>::max();
+
+      run.path.assign(N, 0);
+      run.lastEventTime.assign(N, 0);
+      run.touched.assign(N, false);
+      run.sim = &sim;
+      sim._sigParticleUpdate.connect<DomainRun, &DomainRun::eventCallback>(&run);
+
+      sim.initialise();
+      sim.runSimulation(true);
+      sim.dynamics->updateAllParticles();
+
+      run.displacement.resize(N);
+      run.velocity.resize(N);
+      for (size_t ID(0); ID < N; ++ID)
+	{
+	  const Particle& part = sim.particles[ID];
+	  Vector disp = part.getPosition() - startPos[ID];
+	  for (size_t i(0); i < NDIM; ++i)
+	    disp[i] -= sim.primaryCellSize[i] * std::round(disp[i] / sim.primaryCellSize[i]);
+	  run.displacement[ID] = disp;
+	  run.velocity[ID] = part.getVelocity();
+	  run.path[ID] += part.getVelocity().nrm() * (sim.systemTime - run.lastEventTime[ID]);
+	}
+
+      run.sim = NULL;
+    } catch (std::exception& e) {
+      run.sim = NULL;
+      run.error = e.what();
+    }
+
+    run.busyTime = threadCPUTime() - start;
+  }
+
+  std::string
+  EDomainSimulation::validate(const std::vector<DomainRun>& runs, const size_t domains) const
+  {
+    if (domains == 1) return "";
+
+    const double maxPath = 0.5 * (_halo - _interactionRange);
+    const double posTol = _tolerance * _interactionRange;
+    const double velTol = _tolerance * _velocityScale;
+
+    for (const DomainRun& run : runs)
+      {
+	for (size_t ID(0); ID < run.owned; ++ID)
+	  if (run.path[ID] > maxPath)
+	    return "particle " + boost::lexical_cast<std::string>(run.globalIDs[ID])
+	      + " travelled further than the halo allows";
+
+	for (size_t ID(run.owned); ID < run.globalIDs.size(); ++ID)
+	  if (run.touched[ID])
+	    {
+	      const size_t gID = run.globalIDs[ID];
+	      const DomainRun& ownerRun = runs[_owner[gID]];
+	      const size_t oID = _ownerIndex[gID];
+	      if (((run.displacement[ID] - ownerRun.displacement[oID]).nrm() > posTol)
+		  || ((run.velocity[ID] - ownerRun.velocity[oID]).nrm() > velTol))
+		return "ghost of particle " + boost::lexical_cast<std::string>(gID)
+		  + " in domain " + boost::lexical_cast<std::string>(run.domainID)
+		  + " diverged from its owner";
+	    }
+      }
+
+    return "";
+  }
+
+  void
+  EDomainSimulation::commit(const std::vector<DomainRun>& runs, const double dt)
+  {
+    for (const DomainRun& run : runs)
+      {
+	for (size_t ID(0); ID < run.owned; ++ID)
+	  {
+	    Particle& part = _sim.particles[run.globalIDs[ID]];
+	    part.getPosition() += run.displacement[ID];
+	    _sim.BCs->applyBC(part.getPosition());
+	    part.getVelocity() = run.velocity[ID];
+	  }
+	_sim.eventCount += run.committedEvents;
+      }
+
+    _sim.systemTime += dt;
+  }
+
+  bool
+  EDomainSimulation::runWindow(const size_t domains, const double dt)
+  {
+    std::vector<DomainRun> runs;
+    decompose(runs, domains);
+
+    const auto start = std::chrono::system_clock::now();
+    {
+      //Silence the loading output of the domain Simulations
+      NullBuffer nullBuffer;
+      std::streambuf* coutBuffer = std::cout.rdbuf(&nullBuffer);
+      for (size_t d(0); d < domains; ++d)
+	threads.queueTask(std::bind(&EDomainSimulation::runDomain, this, std::ref(runs[d]), domains, d, dt));
+      threads.wait();
+      std::cout.rdbuf(coutBuffer);
+    }
+    const double wall = std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
+
+    _parallelWallTime += wall * std::min(domains, std::max(threads.getThreadCount(), size_t(1)));
+    _wallTime += wall;
+    for (const DomainRun& run : runs)
+      {
+	if (!run.error.empty())
+	  M_throw() << "Domain " << run.domainID << " failed:\n" << run.error;
+	_busyTime += run.busyTime;
+	_executedEvents += run.executedEvents;
+      }
+
+    _lastRollback = validate(runs, domains);
+    if (!_lastRollback.empty()) return false;
+
+    commit(runs, dt);
+    ++_windows;
+    return true;
+  }
+
+  void
+  EDomainSimulation::runSimulation()
+  {
+    const size_t endEvents = vm["events"].as<size_t>();
+    const double endTime = (vm["sim-end-time"].as<double>() == std::numeric_limits<double>::max())
+      ? HUGE_VAL : vm["sim-end-time"].as<double>() * _sim.units.unitTime();
+    const double maxWindow = 64 * _initialWindow;
+
+    size_t failures = 0;
+    while ((_sim.eventCount < endEvents) && (_sim.systemTime < endTime))
+      {
+	if (_SIGINT || _SIGTERM) break;
+
+	if ((_domains == 1) || (failures >= 3) || (_window < _minWindow))
+	  {
+	    //Fall back to running the whole system in one domain
+	    runWindow(1, std::min(_initialWindow, double(endTime - _sim.systemTime)));
+	    if (_domains > 1) ++_serialWindows;
+	    failures = 0;
+	    _window = _initialWindow;
+	  }
+	else if (runWindow(_domains, std::min(_window, double(endTime - _sim.systemTime))))
+	  {
+	    _window = std::min(1.5 * _window, maxWindow);
+	    failures = 0;
+	  }
+	else
+	  {
+	    ++_rollbacks;
+	    ++failures;
+	    _window *= 0.5;
+	  }
+
+	std::cout << "\rDomains: windows " << _windows << ", rollbacks " << _rollbacks
+		  << ", events " << _sim.eventCount << ", t "
+		  << _sim.systemTime / _sim.units.unitTime() << "   ";
+	std::cout.flush();
+      }
+    std::cout << std::endl;
+  }
+
+  void
+  EDomainSimulation::outputData()
+  {
+    namespace xml = magnet::xml;
+    xml::XmlStream XML;
+    XML.setFormatXML(true);
+
+    const double parallelEfficiency = (_parallelWallTime > 0) ? _busyTime / _parallelWallTime : 0;
+    const double workEfficiency = _executedEvents ? double(_sim.eventCount) / _executedEvents : 0;
+
+    XML << std::setprecision(std::numeric_limits<double>::digits10 + 2)
+	<< xml::prolog() << xml::tag("OutputData")
+	<< xml::tag("Domains")
+	<< xml::attr("Count") << _domains
+	<< xml::attr("Threads") << threads.getThreadCount()
+	<< xml::attr("Halo") << _halo / _sim.units.unitLength()
+	<< xml::attr("Windows") << _windows
+	<< xml::attr("Rollbacks") << _rollbacks
+	<< xml::attr("SerialWindows") << _serialWindows
+	<< xml::attr("CommittedEvents") << _sim.eventCount
+	<< xml::attr("ExecutedEvents") << _executedEvents
+	<< xml::attr("SimTime") << _sim.systemTime / _sim.units.unitTime()
+	<< xml::attr("WallTime") << _wallTime
+	<< xml::attr("EventRate") << ((_wallTime > 0) ? _sim.eventCount / _wallTime : 0)
+	<< xml::attr("ParallelEfficiency") << parallelEfficiency
+	<< xml::attr("WorkEfficiency") << workEfficiency
+	<< xml::attr("ScalingEfficiency") << parallelEfficiency * workEfficiency
+	<< xml::endtag("Domains")
+	<< xml::endtag("OutputData");
+
+    XML.write_file(outputFormat);
+
+    std::cout << "Domain engine: " << _windows << " windows, " << _rollbacks << " rollbacks, "
+	      << _serialWindows << " serial windows\n"
+	      << "  Events committed/executed = " << _sim.eventCount << "/" << _executedEvents << "\n"
+	      << "  Event rate = " << ((_wallTime > 0) ? _sim.eventCount / _wallTime : 0) << " events/s\n"
+	      << "  Parallel efficiency = " << parallelEfficiency
+	      << ", work efficiency = " << workEfficiency << std::endl;
+
+    if (!_lastRollback.empty())
+      std::cout << "  Last rollback: " << _lastRollback << std::endl;
+  }
+
+  void
+  EDomainSimulation::outputConfigs()
+  {
+    _sim.writeXMLfile(configFormat, !vm.count("unwrapped"));
+  }
+}
@@ -0,0 +1,227 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file domains.hpp
+ * Contains the definition of EDomainSimulation.
+ */
+
+#pragma once
+
+#include <dynamo/coordinator/engine/engine.hpp>
+#include <dynamo/simulation.hpp>
+
+namespace dynamo {
+  /*! \brief An Engine which runs a single Simulation in parallel by
+    decomposing the primary image into slabs along the x axis.
+
+    The simulation is advanced in bounded time windows. For each
+    window, every slab (domain) is built into its own Simulation
+    (with its own Scheduler and FEL) containing the particles it owns
+    and a halo of "ghost" copies of the particles within
+    --domain-halo of its boundaries. The domains are then run
+    concurrently on the ThreadPool up to the end of the window.
+
+    The window is optimistic: a domain's result is only correct if
+    every particle which could have reached its owned particles was
+    present, and every ghost which interacted with an owned particle
+    followed the same trajectory as in its owning domain. These
+    conditions are checked after each window by
+    - limiting the distance travelled by every owned particle to
+      (halo - interaction range)/2, and
+    - comparing the final state of each ghost which took part in an
+      event with an owned particle against the state computed by its
+      owner.
+
+    If any check fails, the window is rolled back and retried with
+    half the length. If the window shrinks too far the window is
+    executed serially on the whole system. Successful windows
+    increase the window length again.
+
+    As each domain is a deterministic EDMD simulation of a
+    deterministic initial state, the trajectory is reproducible for
+    a fixed domain count (up to the usual round-off sensitivity of
+    EDMD with respect to the domain count).
+
+    Only systems where the decomposition is straightforward are
+    supported: periodic boundary conditions, Newtonian dynamics, no
+    Local, System or Topology, and Species/Interactions which apply
+    to all particles. Capture maps are regenerated each window from
+    the particle positions.
+   */
+  class EDomainSimulation: public Engine
+  {
+  public:
+    /*! \brief The only constructor.
+
+      \param vm The parsed command line options held by the Coordinator.
+      \param tp The ThreadPool for this instance of dynarun.
+     */
+    EDomainSimulation(const boost::program_options::variables_map& vm,
+		      magnet::thread::ThreadPool& tp);
+
+    /*! \brief Removes the temporary template configuration.
+     */
+    virtual ~EDomainSimulation();
+
+    /*! \brief Loads the Simulation and prepares the domain
+      decomposition.
+     */
+    virtual void initialisation();
+
+    /*! \brief Runs windows until the event or time limit is
+      reached.
+     */
+    virtual void runSimulation();
+
+    /*! \brief No finalisation is required in this engine.
+     */
+    virtual void finaliseRun() {}
+
+    /*! \brief Outputs the decomposition and scaling statistics.
+     */
+    virtual void outputData();
+
+    /*! \brief Outputs the final configuration.
+     */
+    virtual void outputConfigs();
+
+    /*! \brief Return the options for the EDomainSimulation Engine.
+     */
+    static void getOptions(boost::program_options::options_description&);
+
+  protected:
+    /*! \brief The input and results of a single domain over a
+      single window.
+     */
+    struct DomainRun
+    {
+      /*! \brief The global IDs of the particles in the domain, the
+	owned particles are listed first.*/
+      std::vector<size_t> globalIDs;
+      /*! \brief The number of owned particles in globalIDs.*/
+      size_t owned;
+      /*! \brief The displacement of each particle over the window.*/
+      std::vector<Vector> displacement;
+      /*! \brief The final velocity of each particle.*/
+      std::vector<Vector> velocity;
+      /*! \brief The path length of each particle over the window.*/
+      std::vector<double> path;
+      /*! \brief The time of the last event of each particle.*/
+      std::vector<double> lastEventTime;
+      /*! \brief Set for each ghost which took part in an event with
+	an owned particle.*/
+      std::vector<bool> touched;
+      /*! \brief The number of pair events this domain is
+	responsible for counting.*/
+      size_t committedEvents;
+      /*! \brief The total number of pair events executed in the
+	domain (including those of ghosts).*/
+      size_t executedEvents;
+      /*! \brief The CPU time spent building and running the
+	domain.*/
+      double busyTime;
+      /*! \brief Any error message raised while running the domain.*/
+      std::string error;
+
+      /*! \brief The index of this domain.*/
+      size_t domainID;
+      /*! \brief The owner domain of every particle in the global
+	Simulation.*/
+      const std::vector<size_t>* owner;
+      /*! \brief The Simulation of the domain, only valid inside
+	runDomain.*/
+      const Simulation* sim;
+
+      /*! \brief Callback connected to Simulation::_sigParticleUpdate
+	to record the path lengths and the ghosts in contact with the
+	owned particles.*/
+      void eventCallback(const NEventData&);
+    };
+
+    /*! \brief Assign the particles of the global Simulation to the
+      domains and their halos.
+     */
+    void decompose(std::vector<DomainRun>& runs, const size_t domains);
+
+    /*! \brief Build and run a single domain over a window of length
+      dt (in simulation units).
+     */
+    void runDomain(DomainRun& run, const size_t domains, const size_t domainID, const double dt);
+
+    /*! \brief Check the consistency of the results of the window.
+
+      \return An empty string if the window is valid, otherwise a
+      description of the first failure.
+     */
+    std::string validate(const std::vector<DomainRun>& runs, const size_t domains) const;
+
+    /*! \brief Copy the final states of the owned particles into the
+      global Simulation and advance its time.
+     */
+    void commit(const std::vector<DomainRun>& runs, const double dt);
+
+    /*! \brief Attempt a window on the given number of domains.
+
+      \return true if the window was valid and committed.
+     */
+    bool runWindow(const size_t domains, const double dt);
+
+    /*! \brief The global Simulation holding the committed state. */
+    Simulation _sim;
+
+    /*! \brief The path of the particle-less configuration each
+      domain Simulation is built from. */
+    std::string _templateFile;
+
+    /*! \brief The requested number of domains. */
+    size_t _domains;
+
+    /*! \brief The halo width (in simulation units). */
+    double _halo;
+
+    /*! \brief The longest interaction distance (in simulation units). */
+    double _interactionRange;
+
+    /*! \brief The current window length (in simulation units). */
+    double _window;
+
+    /*! \brief The initial and minimum window lengths (in simulation
+      units). */
+    double _initialWindow, _minWindow;
+
+    /*! \brief The relative tolerance used when comparing ghost
+      states. */
+    double _tolerance;
+
+    /*! \brief The initial maximum particle speed, used to scale the
+      velocity tolerance and the initial window (in simulation
+      units). */
+    double _velocityScale;
+
+    /*! \brief The owner domain of each particle (used during
+      validation).*/
+    std::vector<size_t> _owner;
+
+    /*! \brief The index of each particle in its owner's
+      DomainRun.*/
+    std::vector<size_t> _ownerIndex;
+
+    /*! \brief Statistics collected for the output. */
+    size_t _windows, _rollbacks, _serialWindows, _executedEvents;
+    double _busyTime, _parallelWallTime, _wallTime;
+    std::string _lastRollback;
+  };
+}
@@ -18,6 +18,7 @@
 #include <dynamo/coordinator/engine/engine.hpp>
 #include <dynamo/coordinator/engine/replexer.hpp>
 #include <dynamo/inputplugins/compression.hpp>
+#include <dynamo/outputplugins/misc.hpp>
 #include <dynamo/systems/tHalt.hpp>
 #include <limits>
 
@@ -115,8 +116,9 @@ namespace dynamo {
 	  Sim.addOutputPlugin(tmpString);
       }
   
-    if (!vm.count("equilibrate"))
-      //Just add the bare minimum outputplugin
+    if (!vm.count("equilibrate") && !Sim.getOutputPlugin<OPMisc>())
+      //Just add the bare minimum outputplugin (unless it was
+      //loaded with options above)
       Sim.addOutputPlugin("Misc");
   }
 }
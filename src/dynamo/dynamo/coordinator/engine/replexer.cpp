@@ -49,6 +49,11 @@ namespace dynamo {
        "  2: \tRandom pair per swap\n"
        "  3: \t5 * Nsim random pairs per swap\n"
        "  4: \tRandom selection of the above methods")
+      ("replex-async",
+       "Exchange replicas asynchronously. Each temperature only waits for "
+       "the neighbour it is paired with instead of all replicas waiting at "
+       "a barrier before every exchange. Neighbouring pairs are "
+       "alternated, independent of the swap-mode.")
       ;
   
     opts.add(ropts);
@@ -62,7 +67,8 @@ namespace dynamo {
     replexSwapCalls(0),
     round_trips(0),
     SeqSelect(false),
-    nSims(0)
+    nSims(0),
+    _async(false)
   {
     if (vm["events"].as<size_t>() != std::numeric_limits<size_t>::max())
       M_throw() << "You cannot use collisions to control a replica exchange simulation\n"
@@ -170,6 +176,7 @@ namespace dynamo {
     Engine::preSimInit();
 
     ReplexMode = static_cast<Replex_Mode_Type>(vm["replex-swap-mode"].as<unsigned int>());
+    _async = vm.count("replex-async");
   
     nSims = vm["config-file"].as<std::vector<std::string> >().size();
   
@@ -335,7 +342,7 @@ namespace dynamo {
   }
 
   void
-  EReplicaExchangeSimulation::outputData()
+  EReplicaExchangeSimulation::ReplexStatsOutput()
   {
     {
       std::fstream replexof("replex.dat",std::ios::out | std::ios::trunc);
@@ -346,7 +353,8 @@ namespace dynamo {
 		 << (static_cast<double>(myPair.second.swaps) 
 		     / static_cast<double>(myPair.second.attempts))  << " "
 		 << myPair.second.upSims << " "
-		 << myPair.second.downSims
+		 << myPair.second.downSims << " "
+		 << myPair.second.idleTime
 		 << "\n";
     
       replexof.close();      
@@ -355,14 +363,25 @@ namespace dynamo {
     {      
       std::fstream replexof("replex.stats", std::ios::out | std::ios::trunc);
     
+      double idle = 0;
+      for (const replexPair& myPair : temperatureList)
+	idle += myPair.second.idleTime;
       
       replexof << "Number_of_replex_cycles " << replexSwapCalls
 	       << "\nTime_spent_replexing " <<  std::chrono::duration<double>(_end_time - _start_time).count() << "s"
 	       << "\nReplex Rate " << static_cast<double>(replexSwapCalls) / std::chrono::duration<double>(_end_time - _start_time).count()
+	       << "\nTotal_idle_time " << idle << "s"
+	       << "\nAsynchronous " << (_async ? "true" : "false")
 	       << "\n";	
     
       replexof.close();
-    }    
+    }
+  }
+
+  void
+  EReplicaExchangeSimulation::outputData()
+  {
+    ReplexStatsOutput();
   
     int i = 0;
   
@@ -371,9 +390,38 @@ namespace dynamo {
       ((magnet::string::search_replace(outputFormat, "%ID", boost::lexical_cast<std::string>(i++))).c_str());
   }
 
+  double
+  EReplicaExchangeSimulation::intervalFactor(const size_t slot) const
+  {
+    return std::sqrt(temperatureList.front().second.realTemperature
+		     / temperatureList[slot].second.realTemperature);
+  }
+
+  void
+  EReplicaExchangeSimulation::ReplexErrorOutput(const std::string& msg)
+  {
+    int i = 0;
+    std::cerr << msg << std::endl;
+    std::cerr << "Attempting to write out configurations at the error." << std::endl;
+    for (replexPair p1 : temperatureList)
+      {
+	Simulations[p1.second.simID].endEventCount = vm["events"].as<size_t>();
+	Simulations[p1.second.simID].writeXMLfile(magnet::string::search_replace("config.%ID.error.xml", "%ID", 
+										 boost::lexical_cast<std::string>(i++)), 
+						  !vm.count("unwrapped"));
+      }
+    M_throw() << "Exception caught while performing simulations";
+  }
+
   void EReplicaExchangeSimulation::runSimulation()
   {
     _start_time = std::chrono::system_clock::now();
+
+    if (_async)
+      {
+	runAsyncSimulation();
+	return;
+      }
     
     while (((Simulations[temperatureList.front().second.simID].systemTime / Simulations[temperatureList.front().second.simID].units.unitTime()) < replicaEndTime)
 	   && (Simulations[0].eventCount < vm["events"].as<size_t>()))
@@ -429,31 +477,7 @@ namespace dynamo {
 
 		    }
 		  
-		  {
-		    std::fstream replexof("replex.dat",std::ios::out | std::ios::trunc);
-		    
-		    for (const replexPair& myPair : temperatureList)
-		      replexof << myPair.second.realTemperature << " " 
-			       << myPair.second.swaps << " " 
-			       << (static_cast<double>(myPair.second.swaps) 
-				   / static_cast<double>(myPair.second.attempts))  << " "
-			       << myPair.second.upSims << " "
-			       << myPair.second.downSims
-			       << "\n";
-		    
-		    replexof.close();      
-		  }
-		  
-		  {      
-		    std::fstream replexof("replex.stats", std::ios::out | std::ios::trunc);
-		    
-		    replexof << "Number_of_replex_cycles " << replexSwapCalls
-			     << "\nTime_spent_replexing " <<  std::chrono::duration<double>(_end_time - _start_time).count() << "s"
-			     << "\nReplex Rate " << static_cast<double>(replexSwapCalls) / std::chrono::duration<double>(_end_time - _start_time).count()
-			     << "\n";	
-		    
-		    replexof.close();
-		  }		  
+		  ReplexStatsOutput();
 		  break;
 		}
 	      case 'd':
@@ -519,25 +543,25 @@ namespace dynamo {
 	    std::vector<std::function<void()> > tasks;
 	    tasks.reserve(nSims);
 
+	    //Each task records when its simulation finished, so the
+	    //time spent idling at the barrier can be reported.
+	    std::vector<std::chrono::system_clock::time_point> finishTimes(nSims);
 	    for (size_t i(0); i < nSims; ++i)
-	      tasks.push_back(std::bind(&Simulation::runSimulation, &static_cast<Simulation&>(Simulations[i]), true));
+	      tasks.push_back([this, i, &finishTimes]() {
+		  Simulations[i].runSimulation(true);
+		  finishTimes[i] = std::chrono::system_clock::now();
+		});
 
 	    threads.queueTasks(tasks);
             try {
               threads.wait();//This syncs the systems for the replica exchange
             } catch (std::exception& e) {
-              int i = 0;
-              std::cerr << e.what() << std::endl;
-              std::cerr << "Attempting to write out configurations at the error." << std::endl;
-              for (replexPair p1 : temperatureList)
-                {
-                  Simulations[p1.second.simID].endEventCount = vm["events"].as<size_t>();
-                  Simulations[p1.second.simID].writeXMLfile(magnet::string::search_replace("config.%ID.error.xml", "%ID", 
-                                                                                           boost::lexical_cast<std::string>(i++)), 
-                                                            !vm.count("unwrapped"));
-                }
-              M_throw() << "Exception caught while performing simulations";
+	      ReplexErrorOutput(e.what());
             }
+
+	    const auto barrierTime = std::chrono::system_clock::now();
+	    for (replexPair& dat : temperatureList)
+	      dat.second.idleTime += std::chrono::duration<double>(barrierTime - finishTimes[dat.second.simID]).count();
 		  
 	    //Swap calculation
 	    ReplexSwap(ReplexMode);
@@ -571,6 +595,229 @@ namespace dynamo {
   _end_time = std::chrono::system_clock::now();
   }
 
+  void
+  EReplicaExchangeSimulation::queueAsyncReplica(const size_t slot)
+  {
+    Simulation& sim = Simulations[temperatureList[slot].second.simID];
+    shared_ptr<SystHalt> tmpRef = std::dynamic_pointer_cast<SystHalt>(sim.systems["ReplexHalt"]);
+
+#ifdef DYNAMO_DEBUG
+    if (!tmpRef)
+      M_throw() << "Could not find the time halt event error";
+#endif
+
+    tmpRef->increasedt(vm["replex-interval"].as<double>() * intervalFactor(slot));
+    sim.ptrScheduler->rebuildSystemEvents();
+    sim.endEventCount = vm["events"].as<size_t>();
+
+    temperatureList[slot].second.running = true;
+    threads.queueTask([this, slot, &sim]() {
+	std::string error;
+	try {
+	  sim.runSimulation(true);
+	} catch (std::exception& e) {
+	  error = e.what();
+	}
+
+	std::lock_guard<std::mutex> lock(_readyMutex);
+	if (!error.empty())
+	  _asyncErrors += "\n" + error;
+	_readySlots.push_back(std::make_pair(slot, std::chrono::system_clock::now()));
+	_readyCondition.notify_all();
+      });
+  }
+
+  void
+  EReplicaExchangeSimulation::AsyncSlotTicker(const size_t slot)
+  {
+    simData& dat = temperatureList[slot].second;
+    ++dat.exchangeStep;
+    ++(Simulations[dat.simID].replexExchangeNumber);
+
+    //The coldest temperature point is used to count the replex cycles
+    if (slot == 0)
+      ++replexSwapCalls;
+
+    if (SimDirection[dat.simID] > 0)
+      ++dat.upSims;
+    else if (SimDirection[dat.simID] < 0)
+      ++dat.downSims;
+
+    if ((slot == 0) && (SimDirection[dat.simID] == -1))
+      {
+	if (roundtrip[dat.simID])
+	  ++round_trips;
+	roundtrip[dat.simID] = true;
+      }
+
+    if ((slot + 1 == nSims) && (SimDirection[dat.simID] == 1))
+      {
+	if (roundtrip[dat.simID])
+	  ++round_trips;
+	roundtrip[dat.simID] = true;
+      }
+
+    if (slot == 0)
+      SimDirection[dat.simID] = 1; //Going up
+
+    if (slot + 1 == nSims)
+      SimDirection[dat.simID] = -1; //Going down
+  }
+
+  void
+  EReplicaExchangeSimulation::runAsyncSimulation()
+  {
+    //In zero thread mode the tasks are only run when the ThreadPool
+    //is waited on, so we must do this whenever we run out of work.
+    const bool serial = (threads.getThreadCount() == 0);
+    bool stopping = false;
+    size_t running = 0;
+
+    auto slotFinished = [&](const size_t slot) {
+      const Simulation& sim = Simulations[temperatureList[slot].second.simID];
+      return stopping 
+      || ((sim.systemTime / sim.units.unitTime()) >= replicaEndTime * intervalFactor(slot));
+    };
+
+    for (size_t slot(0); slot < nSims; ++slot)
+      if (slotFinished(slot))
+	temperatureList[slot].second.finished = true;
+      else
+	{
+	  queueAsyncReplica(slot);
+	  ++running;
+	}
+    
+    while (running)
+      {
+	if (_SIGINT || _SIGTERM)
+	  {
+	    if (!stopping)
+	      std::cerr << "\nReplica exchange shutting down once the running replicas reach their exchange point\n";
+	    stopping = true;
+	    _SIGINT = _SIGTERM = false;
+	    Coordinator::setup_signal_handler();
+	  }
+
+	std::vector<std::pair<size_t, std::chrono::system_clock::time_point> > ready;
+	if (serial)
+	  threads.wait();
+
+	{
+	  std::unique_lock<std::mutex> lock(_readyMutex);
+	  //The time limit lets us respond to signals while waiting
+	  if (_readySlots.empty())
+	    _readyCondition.wait_for(lock, std::chrono::milliseconds(250));
+	  std::swap(ready, _readySlots);
+
+	  if (!_asyncErrors.empty())
+	    {
+	      running -= ready.size();
+	      for (auto& entry : ready)
+		temperatureList[entry.first].second.running = false;
+
+	      //Let the remaining replicas finish so we can write them out
+	      while (running)
+		{
+		  while (_readySlots.empty())
+		    _readyCondition.wait(lock);
+		  running -= _readySlots.size();
+		  _readySlots.clear();
+		}
+	      lock.unlock();
+	      ReplexErrorOutput(_asyncErrors);
+	    }
+	}
+
+	if (ready.empty()) continue;
+
+	for (auto& entry : ready)
+	  {
+	    --running;
+	    simData& dat = temperatureList[entry.first].second;
+	    dat.running = false;
+	    dat.idleTime -= std::chrono::duration<double>(entry.second - _start_time).count();
+	  }
+
+	//Process all temperature points that are not running. This
+	//loop repeats until no more replicas can be advanced.
+	bool progress = true;
+	while (progress)
+	  {
+	    progress = false;
+	    for (size_t slot(0); slot < nSims; ++slot)
+	      {
+		simData& dat = temperatureList[slot].second;
+		if (dat.running || dat.finished) continue;
+
+		//Determine this points exchange partner for its current step
+		const bool up = ((slot + dat.exchangeStep) % 2) == 0;
+		const size_t partner = up ? slot + 1 : slot - 1;
+		const bool hasPartner = (up ? (slot + 1 < nSims) : (slot > 0))
+		  && (ReplexMode != NoSwapping)
+		  && !temperatureList[partner].second.finished;
+
+		if (hasPartner)
+		  {
+		    simData& pdat = temperatureList[partner].second;
+		    //Wait for the partner to reach the same exchange step
+		    if (pdat.running || (pdat.exchangeStep != dat.exchangeStep))
+		      continue;
+
+		    AttemptSwap(std::min(slot, partner), std::max(slot, partner));
+		  }
+
+		std::vector<size_t> advancing{slot};
+		if (hasPartner)
+		  advancing.push_back(partner);
+
+		const double now = std::chrono::duration<double>(std::chrono::system_clock::now() - _start_time).count();
+		for (size_t id : advancing)
+		  {
+		    simData& sdat = temperatureList[id].second;
+		    sdat.idleTime += now;
+		    AsyncSlotTicker(id);
+		    
+		    if (slotFinished(id))
+		      sdat.finished = true;
+		    else
+		      {
+			queueAsyncReplica(id);
+			++running;
+		      }
+		  }
+		progress = true;
+	      }
+	  }
+
+	double duration = std::chrono::duration<double>(std::chrono::system_clock::now() - _start_time).count();
+	//The replicas may still be running, so the progress is estimated
+	//from the exchange count of the coldest temperature point.
+	double fractionComplete = replexSwapCalls * vm["replex-interval"].as<double>() / replicaEndTime;
+	double seconds_remaining_double = duration * (1 / fractionComplete - 1);
+	size_t seconds_remaining = seconds_remaining_double;
+
+	if (seconds_remaining_double < std::numeric_limits<size_t>::max())
+	  {
+	    size_t ETA_hours = seconds_remaining / 3600;
+	    size_t ETA_mins = (seconds_remaining / 60) % 60;
+	    size_t ETA_secs = seconds_remaining % 60;
+	    
+	    std::cout << "\rAsync Replica Exchange No." << replexSwapCalls << ", ETA ";
+	    if (ETA_hours)
+	      std::cout << ETA_hours << "hr ";
+	    
+	    if (ETA_mins)
+	      std::cout << ETA_mins << "min ";
+	    
+	    std::cout << ETA_secs << "s        ";
+	    std::cout.flush();
+	  }
+      }
+
+    _end_time = std::chrono::system_clock::now();
+  }
+
   void 
   EReplicaExchangeSimulation::outputConfigs()
   {
@@ -22,7 +22,9 @@
 
 #include <dynamo/coordinator/engine/engine.hpp>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 
 namespace dynamo {
   /*! \brief The Replica Exchange/Parallel Tempering Engine.
@@ -35,6 +37,17 @@ namespace dynamo {
    
     This class uses the ThreadPool to parallelise the running of the
     simulations.
+
+    In the default (synchronous) mode every replica is run up to its
+    exchange point and the engine waits for all of them before
+    attempting any exchanges. In the asynchronous mode (--replex-async)
+    each temperature point only waits for the neighbour it is paired
+    with. Temperature point \f$i\f$ pairs with \f$i+1\f$ on its
+    exchange steps where \f$i+k\f$ is even (\f$k\f$ being the
+    exchange step count of the point), and with \f$i-1\f$
+    otherwise. The pairing is fixed in advance and never depends on
+    the state of the replicas, so the Metropolis exchange criterion
+    still satisfies detailed balance.
    */
   class EReplicaExchangeSimulation: public Engine
   {
@@ -105,7 +118,8 @@ namespace dynamo {
        */
       explicit simData(int ID, double rT):
 	simID(ID), swaps(0), attempts(0), upSims(0), downSims(0),
-	realTemperature(rT)
+	realTemperature(rT), exchangeStep(0), idleTime(0), running(false),
+	finished(false)
       {}
 
       /*! \brief compares simData by their contained simulation ID's
@@ -130,6 +144,18 @@ namespace dynamo {
       size_t downSims;
       /*! \brief The temperature of this simulation point */
       double realTemperature;
+      /*! \brief The number of exchange steps completed by this
+        temperature point (only used in the asynchronous mode).*/
+      size_t exchangeStep;
+      /*! \brief The wall-clock time (in seconds) the replicas at this
+        temperature point spent waiting for other replicas.*/
+      double idleTime;
+      /*! \brief Set while the replica at this temperature point is
+        queued/running on the ThreadPool (asynchronous mode).*/
+      bool running;
+      /*! \brief Set once this temperature point has reached its end
+        time (asynchronous mode).*/
+      bool finished;
     };
 
     typedef std::pair<double, simData> replexPair;
@@ -190,6 +216,32 @@ namespace dynamo {
      */
     unsigned int nSims;
 
+    /*! \brief If true, replicas are exchanged asynchronously without a
+      global barrier.
+     */
+    bool _async;
+
+    /*! \brief Protects _readySlots and _asyncErrors, which are written
+      by the worker threads in the asynchronous mode.
+     */
+    std::mutex _readyMutex;
+
+    /*! \brief Signalled by a worker thread once a replica has reached
+      its exchange point.
+     */
+    std::condition_variable _readyCondition;
+
+    /*! \brief The temperature points (and the wall-clock time they
+      became available) which have reached their exchange point but
+      have not yet been processed by the engine.
+     */
+    std::vector<std::pair<size_t, std::chrono::system_clock::time_point> > _readySlots;
+
+    /*! \brief Any exception messages thrown by the replicas in the
+      asynchronous mode.
+     */
+    std::string _asyncErrors;
+
     /*! \brief Initialises this class ready for the replica exchange.
      */
     virtual void preSimInit();
@@ -232,5 +284,34 @@ namespace dynamo {
       \param id2 Second Simulation to attempt to exchange.
      */
     void AttemptSwap(const unsigned int id1, const unsigned int id2);
+
+    /*! \brief The barrier-free main loop used when --replex-async is
+      set.
+     */
+    void runAsyncSimulation();
+
+    /*! \brief Reset the halt event of the replica at a temperature
+      point and queue it to run up to its next exchange point.
+     */
+    void queueAsyncReplica(const size_t slot);
+
+    /*! \brief The per-temperature-point equivalent of
+      ReplexSwapTicker() used in the asynchronous mode.
+     */
+    void AsyncSlotTicker(const size_t slot);
+
+    /*! \brief Output the replex.dat and replex.stats files.
+     */
+    void ReplexStatsOutput();
+
+    /*! \brief Write the current configurations out after an error in
+      one of the replicas and throw.
+     */
+    void ReplexErrorOutput(const std::string& msg);
+
+    /*! \brief The factor by which the exchange interval of a
+      temperature point is scaled, \f$(T_{cold}/T_i)^{1/2}\f$.
+     */
+    double intervalFactor(const size_t slot) const;
   };
 }
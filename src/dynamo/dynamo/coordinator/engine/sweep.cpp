@@ -0,0 +1,205 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/coordinator/engine/sweep.hpp>
+#include <dynamo/inputplugins/inputplugin.hpp>
+#include <dynamo/systems/andersenThermostat.hpp>
+#include <dynamo/systems/snapshot.hpp>
+#include <magnet/thread/threadpool.hpp>
+#include <magnet/string/searchreplace.hpp>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+namespace dynamo {
+  void
+  ESweepSimulation::getOptions(boost::program_options::options_description& opts)
+  {
+    boost::program_options::options_description 
+      ropts("Sweep Engine Options (--engine=4)");
+
+    ropts.add_options()
+      ("sweep-T", boost::program_options::value<std::vector<double> >()->multitoken(),
+       "Run every config file at each of these temperatures. The velocities "
+       "are rescaled and, if present, the Thermostat is set to each temperature.")
+      ("sweep-seeds", boost::program_options::value<size_t>()->default_value(1),
+       "Run every config file/temperature this many times with different "
+       "random seeds. If --random-seed is set, the seeds used are "
+       "random-seed, random-seed+1, ...")
+      ;
+  
+    opts.add(ropts);
+  }
+
+  ESweepSimulation::ESweepSimulation(const boost::program_options::variables_map& nVm,
+				     magnet::thread::ThreadPool& tp):
+    Engine(nVm, "config.%ID.end.xml", "output.%ID.xml", tp),
+    _finishedJobs(0)
+  {}
+
+  void
+  ESweepSimulation::initialisation()
+  {
+    preSimInit();
+
+    if (configFormat.find("%ID") == configFormat.npos)
+      M_throw() << "Sweep mode, but format string for config file output"
+	" doesnt contain %ID";
+  
+    if (outputFormat.find("%ID") == outputFormat.npos)
+      M_throw() << "Sweep mode, but format string for output"
+	" file doesnt contain %ID";  
+
+    if (vm["sweep-seeds"].as<size_t>() == 0)
+      M_throw() << "--sweep-seeds must be at least 1";
+
+    std::vector<double> temperatures{std::numeric_limits<double>::quiet_NaN()};
+    if (vm.count("sweep-T"))
+      temperatures = vm["sweep-T"].as<std::vector<double> >();
+
+    std::random_device rd;
+    unsigned int seed = vm.count("random-seed") ? vm["random-seed"].as<unsigned int>() : rd();
+
+    _jobs.clear();
+    for (const std::string& file : vm["config-file"].as<std::vector<std::string> >())
+      for (const double T : temperatures)
+	for (size_t i(0); i < vm["sweep-seeds"].as<size_t>(); ++i)
+	  _jobs.push_back(SweepJob(file, T, vm.count("random-seed") ? seed++ : rd()));
+
+    std::cout << "Sweep engine queuing " << _jobs.size() << " simulations on " 
+	      << threads.getThreadCount() << " threads" << std::endl;
+  }
+
+  void
+  ESweepSimulation::setTemperature(Simulation& Sim, const double T)
+  {
+    auto thermostat_it = Sim.systems.find("Thermostat");
+    if (thermostat_it != Sim.systems.end())
+      {
+	shared_ptr<SysAndersen> thermostat = std::dynamic_pointer_cast<SysAndersen>(*thermostat_it);
+	if (!thermostat)
+	  M_throw() << "Could not upcast System event named \"Thermostat\" to SysAndersen";
+	
+	thermostat->setReducedTemperature(T);
+	Sim.ensemble = dynamo::Ensemble::loadEnsemble(Sim);
+      }
+
+    InputPlugin(&Sim, "Rescaler").rescaleVels(T);
+  }
+
+  void
+  ESweepSimulation::runJob(const size_t ID)
+  {
+    SweepJob& job = _jobs[ID];
+
+    //Don't start any new simulations once a shutdown is requested
+    if (_SIGINT || _SIGTERM)
+      {
+	job.error = "Skipped due to shutdown";
+	return;
+      }
+    
+    const std::string IDstr = boost::lexical_cast<std::string>(ID);
+    const auto start = std::chrono::system_clock::now();
+    Simulation Sim;
+    Sim.simID = Sim.stateID = ID;
+
+    try {
+      setupSim(Sim, job.configFile);
+      Sim.ranGenerator.seed(job.seed);
+
+      if (!std::isnan(job.temperature))
+	setTemperature(Sim, job.temperature);
+
+      if (vm.count("snapshot"))
+	Sim.systems.push_back(shared_ptr<System>(new SysSnapshot(&Sim, vm["snapshot"].as<double>(), "SnapshotTimer", "ID%ID.%COUNT", !vm.count("unwrapped"))));
+      
+      if (vm.count("snapshot-events"))
+	Sim.systems.push_back(shared_ptr<System>(new SysSnapshot(&Sim, vm["snapshot-events"].as<size_t>(), "SnapshotEventTimer", "ID%ID.%COUNTe", !vm.count("unwrapped"))));
+
+      Sim.initialise();
+      postSimInit(Sim);
+
+      if (vm.count("ticker-period"))
+	Sim.setTickerPeriod(vm["ticker-period"].as<double>());
+
+      Sim.runSimulation(true);
+      
+      Sim.outputData(magnet::string::search_replace(outputFormat, "%ID", IDstr));
+      Sim.endEventCount = vm["events"].as<size_t>();
+      Sim.writeXMLfile(magnet::string::search_replace(configFormat, "%ID", IDstr), !vm.count("unwrapped"));
+      job.completed = true;
+    } catch (std::exception& e) {
+      job.error = e.what();
+      if (Sim.status >= INITIALISED)
+	try {
+	  Sim.writeXMLfile(magnet::string::search_replace("config.%ID.error.xml", "%ID", IDstr), !vm.count("unwrapped"));
+	} catch (...) {}
+    }
+
+    job.events = Sim.eventCount;
+    job.simTime = (Sim.status >= INITIALISED) ? Sim.systemTime / Sim.units.unitTime() : 0;
+    job.wallTime = std::chrono::duration<double>(std::chrono::system_clock::now() - start).count();
+
+    std::cout << "\rSweep: " << ++_finishedJobs << "/" << _jobs.size() << " simulations complete   ";
+    std::cout.flush();
+  }
+
+  void
+  ESweepSimulation::runSimulation()
+  {
+    //Each task loads, runs and writes out its own simulation. The
+    //tasks are pulled by the threads as they become free, which
+    //balances simulations of differing cost.
+    std::vector<std::function<void()> > tasks;
+    tasks.reserve(_jobs.size());
+    for (size_t ID(0); ID < _jobs.size(); ++ID)
+      tasks.push_back(std::bind(&ESweepSimulation::runJob, this, ID));
+
+    threads.queueTasks(tasks);
+    threads.wait();
+    std::cout << std::endl;
+  }
+
+  void
+  ESweepSimulation::outputData()
+  {
+    std::fstream sweepof("sweep.dat", std::ios::out | std::ios::trunc);
+    sweepof << "# ID ConfigFile Temperature Seed Events SimTime WallTime Status\n";
+
+    size_t failed = 0;
+    for (size_t ID(0); ID < _jobs.size(); ++ID)
+      {
+	const SweepJob& job = _jobs[ID];
+	sweepof << ID << " " << job.configFile << " " << job.temperature << " "
+		<< job.seed << " " << job.events << " " << job.simTime << " "
+		<< job.wallTime << " " << (job.completed ? "OK" : "FAILED") << "\n";
+
+	if (!job.completed)
+	  {
+	    ++failed;
+	    std::cerr << "Sweep simulation " << ID << " (" << job.configFile 
+		      << ") failed: " << job.error << "\n";
+	  }
+      }
+    sweepof.close();
+
+    if (failed)
+      M_throw() << failed << " of the " << _jobs.size() << " sweep simulations failed";
+  }
+}
@@ -0,0 +1,138 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file sweep.hpp
+ * Contains the definition of ESweepSimulation.
+ */
+
+#pragma once
+
+#include <dynamo/coordinator/engine/engine.hpp>
+#include <atomic>
+
+namespace dynamo {
+  /*! \brief An Engine which runs a batch of independent Simulations
+    concurrently in a single process.
+
+    This is intended for parameter sweeps, where many small
+    simulations are required (e.g., repeated seeds or a range of
+    temperatures). The batch is either the list of config files
+    provided on the command line, or the cartesian product of the
+    config files with the temperatures in --sweep-T and/or the
+    --sweep-seeds repeats.
+
+    Each Simulation is loaded, run and written out inside its own
+    ThreadPool task, so the pool balances the load dynamically and
+    only one Simulation per thread is held in memory at any time. The
+    output files are named using the %ID format strings, in the same
+    way as the EReplicaExchangeSimulation engine.
+   */
+  class ESweepSimulation: public Engine
+  {
+  public:
+    /*! \brief The only constructor.
+     
+      \param vm The parsed command line options held by the Coordinator.
+      \param tp The ThreadPool for this instance of dynarun.
+     */
+    ESweepSimulation(const boost::program_options::variables_map& vm, 
+		     magnet::thread::ThreadPool& tp);
+
+    /*! \brief A trivial virtual destructor. 
+     */
+    virtual ~ESweepSimulation() {}
+
+    /*! \brief Builds the list of Simulations to run.
+
+      The Simulations themselves are loaded later, by the tasks
+      running them.
+     */
+    virtual void initialisation();
+
+    /*! \brief Queue every Simulation on the ThreadPool and wait for
+      them to complete.
+     */
+    virtual void runSimulation();
+
+    /*! \brief No finalisation is required in this engine.
+     */
+    virtual void finaliseRun() {}
+
+    /*! \brief Output the summary of the sweep (sweep.dat).
+
+      The output data of each Simulation is written as soon as it
+      completes.
+     */
+    virtual void outputData();
+
+    /*! \brief Nothing to do, the configuration of each Simulation is
+      written as soon as it completes.
+     */
+    virtual void outputConfigs() {}
+
+    /*! \brief Return the options for the ESweepSimulation Engine.
+     */
+    static void getOptions(boost::program_options::options_description&);
+
+  protected:
+    /*! \brief The description and results of a single Simulation in
+      the sweep.
+     */
+    struct SweepJob
+    {
+      SweepJob(std::string file, double T, unsigned int s):
+	configFile(file), temperature(T), seed(s), events(0), 
+	simTime(0), wallTime(0), completed(false)
+      {}
+
+      /*! \brief The configuration file to load. */
+      std::string configFile;
+      /*! \brief The temperature to set (or NaN if unchanged). */
+      double temperature;
+      /*! \brief The random seed of the Simulation. */
+      unsigned int seed;
+      /*! \brief The number of events executed. */
+      size_t events;
+      /*! \brief The final simulation time (in simulation units). */
+      double simTime;
+      /*! \brief The wall-clock time taken to load, run and output
+	the Simulation.*/
+      double wallTime;
+      /*! \brief Set once the Simulation has been run and written out.*/
+      bool completed;
+      /*! \brief Any error message raised while running the Simulation.*/
+      std::string error;
+    };
+
+    /*! \brief Load, run and output the Simulation for a single job.
+
+      \param ID The index of the job in _jobs, also used for %ID.
+     */
+    void runJob(const size_t ID);
+
+    /*! \brief Sets the temperature of a loaded (but not
+      initialised) Simulation.
+     */
+    void setTemperature(Simulation& Sim, const double T);
+
+    /*! \brief The list of Simulations in this sweep. */
+    std::vector<SweepJob> _jobs;
+
+    /*! \brief The number of Simulations which have finished (used
+      for progress output). */
+    std::atomic<size_t> _finishedJobs;
+  };
+}
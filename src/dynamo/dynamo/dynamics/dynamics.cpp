@@ -20,11 +20,63 @@
 #include <dynamo/simulation.hpp>
 #include <dynamo/NparticleEventData.hpp>
 #include <dynamo/units/units.hpp>
+#include <dynamo/checkpoint.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 #include <cstring>
+#include <exception>
+#include <thread>
 
 namespace dynamo {
+  namespace {
+    /*! \brief The number of blocks the particle data is split into
+        for parallel loading and writing.
+
+      Small systems are processed in a single block on the calling
+      thread.
+     */
+    size_t particleChunkCount(const size_t N)
+    {
+      const size_t minChunk = 10000;
+      return std::max(size_t(1), std::min(size_t(std::thread::hardware_concurrency()), N / minChunk));
+    }
+
+    /*! \brief Call func(chunk, begin, end) for each of the
+        particleChunkCount(N) contiguous blocks of [0, N), with each
+        block on its own thread.
+
+      The first exception thrown by any block is rethrown on the
+      calling thread.
+     */
+    template<class Func>
+    void parallelParticleChunks(const size_t N, Func func)
+    {
+      const size_t chunks = particleChunkCount(N);
+      if (chunks == 1)
+	{
+	  func(0, 0, N);
+	  return;
+	}
+
+      std::vector<std::exception_ptr> errors(chunks);
+      std::vector<std::thread> threads;
+      for (size_t chunk(0); chunk < chunks; ++chunk)
+	threads.push_back(std::thread([&, chunk]() {
+	      try {
+		func(chunk, N * chunk / chunks, N * (chunk + 1) / chunks);
+	      } catch (...) {
+		errors[chunk] = std::current_exception();
+	      }
+	    }));
+
+      for (std::thread& thread : threads)
+	thread.join();
+
+      for (const std::exception_ptr& error : errors)
+	if (error) std::rethrow_exception(error);
+    }
+  }
+
   magnet::xml::XmlStream& operator<<(magnet::xml::XmlStream& XML, const Dynamics& g)
   {
     g.outputXML(XML);
@@ -106,19 +158,58 @@ namespace dynamo {
   {
     dout << "Loading Particle Data" << std::endl;
 
-    bool outofsequence = false;  
-  
+    if (XML.getNode("ParticleData").hasAttribute("Binary"))
+      {
+	loadParticleBinaryData(XML.getNode("ParticleData"));
+	return;
+      }
+
+    //Collect the particle nodes so they can be split between
+    //threads. Walking the sibling list is cheap compared to
+    //converting the values.
+    std::vector<magnet::xml::Node> nodes;
     for (magnet::xml::Node node = XML.getNode("ParticleData").findNode("Pt"); 
 	 node.valid(); ++node)
+      nodes.push_back(node);
+
+    const size_t N = nodes.size();
+    const bool hasOrientation = XML.getNode("ParticleData").hasAttribute("OrientationData");
+    std::vector<Vector> positions(N), velocities(N);
+    std::vector<char> dynamic(N), inSequence(N);
+    if (hasOrientation)
+      orientationData.resize(N);
+
+    parallelParticleChunks(N, [&](const size_t, const size_t begin, const size_t end) {
+	for (size_t i(begin); i < end; ++i)
+	  {
+	    const magnet::xml::Node& node = nodes[i];
+	    inSequence[i] = node.hasAttribute("ID") && (node.getAttribute("ID").as<size_t>() == i);
+	    dynamic[i] = !node.hasAttribute("Static");
+	    positions[i] << node.getNode("P");
+	    velocities[i] << node.getNode("V");
+
+	    if (hasOrientation)
+	      {
+		orientationData[i].orientation << node.getNode("U");
+		orientationData[i].angularVelocity << node.getNode("O");
+		
+		//Makes the vector a unit vector
+		orientationData[i].orientation.normalise();
+		if (orientationData[i].orientation.nrm() == 0)
+		  M_throw() << "Particle " << i << " has an invalid zero orientation quaternion";
+	      }
+	  }
+      });
+
+    bool outofsequence = false;  
+    Sim->particles.reserve(Sim->particles.size() + N);
+    for (size_t i(0); i < N; ++i)
       {
-	if (!node.hasAttribute("ID")
-	    || node.getAttribute("ID").as<size_t>() != Sim->particles.size())
-	  outofsequence = true;
-      
-	Particle part(node, Sim->particles.size());
-	part.getVelocity() *= Sim->units.unitVelocity();
-	part.getPosition() *= Sim->units.unitLength();
-	Sim->particles.push_back(part);
+	outofsequence |= !inSequence[i];
+	Sim->particles.push_back(Particle(positions[i] * Sim->units.unitLength(),
+					  velocities[i] * Sim->units.unitVelocity(),
+					  Sim->particles.size()));
+	if (!dynamic[i]) Sim->particles.back().clearState(Particle::DYNAMIC);
       }
 
     if (outofsequence)
@@ -127,17 +218,55 @@ namespace dynamo {
 	   << "Erase any capture maps in the configuration file so they are regenerated." << std::endl;
 
     dout << "Particle count " << Sim->N() << std::endl;
+  }
+
+  void 
+  Dynamics::loadParticleBinaryData(const magnet::xml::Node& XML)
+  {
+    if (!Sim->_checkpoint)
+      M_throw() << "Binary particle data can only be loaded from a binary checkpoint";
+
+    const BinaryCheckpoint& checkpoint = *Sim->_checkpoint;
+    const size_t N = XML.getAttribute("N").as<size_t>();
+    const double* pos = checkpoint.getArray<double>("Position", N, NDIM);
+    const double* vel = checkpoint.getArray<double>("Velocity", N, NDIM);
+    const uint8_t* dynamic = checkpoint.getArray<uint8_t>("Dynamic", N);
 
-    if (XML.getNode("ParticleData").hasAttribute("OrientationData"))
+    Sim->particles.reserve(N);
+    for (size_t i(0); i < N; ++i)
       {
-	orientationData.resize(Sim->N());
-	size_t i(0);
-	for (magnet::xml::Node node = XML.getNode("ParticleData").findNode("Pt"); node.valid(); ++node, ++i)
+	Vector position, velocity;
+	for (size_t j(0); j < NDIM; ++j)
 	  {
-	    orientationData[i].orientation << node.getNode("U");
-	    orientationData[i].angularVelocity << node.getNode("O");
-      
-	    //Makes the vector a unit vector
+	    position[j] = pos[NDIM * i + j] * Sim->units.unitLength();
+	    velocity[j] = vel[NDIM * i + j] * Sim->units.unitVelocity();
+	  }
+	Sim->particles.push_back(Particle(position, velocity, i));
+	if (!dynamic[i]) Sim->particles.back().clearState(Particle::DYNAMIC);
+      }
+
+    dout << "Particle count " << Sim->N() << std::endl;
+
+    //The per-particle properties were created without any values
+    for (const shared_ptr<Property>& property : Sim->_properties)
+      {
+	shared_ptr<ParticleProperty> pProperty = std::dynamic_pointer_cast<ParticleProperty>(property);
+	if (!pProperty) continue;
+	const double* values = checkpoint.getArray<double>("Property:" + pProperty->getName(), N);
+	pProperty->getValues().assign(values, values + N);
+      }
+
+    if (XML.hasAttribute("OrientationData"))
+      {
+	const double* U = checkpoint.getArray<double>("Orientation", N, 4);
+	const double* O = checkpoint.getArray<double>("AngularVelocity", N, NDIM);
+	orientationData.resize(N);
+	for (size_t i(0); i < N; ++i)
+	  {
+	    orientationData[i].orientation = Quaternion(U[4 * i], U[4 * i + 1], U[4 * i + 2], U[4 * i + 3]);
+	    for (size_t j(0); j < NDIM; ++j)
+	      orientationData[i].angularVelocity[j] = O[NDIM * i + j];
+
 	    orientationData[i].orientation.normalise();
 	    if (orientationData[i].orientation.nrm() == 0)
 	      M_throw() << "Particle " << i << " has an invalid zero orientation quaternion";
@@ -146,36 +275,139 @@ namespace dynamo {
   }
 
   void 
-  Dynamics::outputParticleXMLData(magnet::xml::XmlStream& XML, bool applyBC) const
+  Dynamics::outputParticleBinaryData(magnet::xml::XmlStream& XML, bool applyBC) const
   {
-    XML << magnet::xml::tag("ParticleData");
+    BinaryCheckpoint& checkpoint = *Sim->_checkpoint;
+    const size_t N = Sim->N();
+
+    XML << magnet::xml::tag("ParticleData")
+	<< magnet::xml::attr("N") << N
+	<< magnet::xml::attr("Binary") << "Y";
   
     if (hasOrientationData())
       XML << magnet::xml::attr("OrientationData") << "Y";
 
-    for (size_t i = 0; i < Sim->N(); ++i)
+    XML << magnet::xml::endtag("ParticleData");
+
+    double* pos = checkpoint.addArray<double>("Position", N, NDIM);
+    double* vel = checkpoint.addArray<double>("Velocity", N, NDIM);
+    uint8_t* dynamic = checkpoint.addArray<uint8_t>("Dynamic", N);
+    for (size_t i = 0; i < N; ++i)
       {
 	Particle tmp(Sim->particles[i]);
 	if (applyBC) 
 	  Sim->BCs->applyBC(tmp.getPosition(), tmp.getVelocity());
-      
-	tmp.getVelocity() *= (1.0 / Sim->units.unitVelocity());
-	tmp.getPosition() *= (1.0 / Sim->units.unitLength());
-      
-	XML << magnet::xml::tag("Pt");
-	Sim->_properties.outputParticleXMLData(XML, i);
-	XML << tmp;
-
-	if (hasOrientationData())
-	  XML << magnet::xml::tag("O")
-	      << orientationData[i].angularVelocity
-	      << magnet::xml::endtag("O")
-	      << magnet::xml::tag("U")
-	      << orientationData[i].orientation
-	      << magnet::xml::endtag("U") ;
-
-	XML << magnet::xml::endtag("Pt");
+
+	for (size_t j(0); j < NDIM; ++j)
+	  {
+	    pos[NDIM * i + j] = tmp.getPosition()[j] / Sim->units.unitLength();
+	    vel[NDIM * i + j] = tmp.getVelocity()[j] / Sim->units.unitVelocity();
+	  }
+	dynamic[i] = tmp.testState(Particle::DYNAMIC);
+      }
+
+    //The properties are already in the output units here
+    for (const shared_ptr<Property>& property : Sim->_properties)
+      {
+	shared_ptr<const ParticleProperty> pProperty = std::dynamic_pointer_cast<const ParticleProperty>(property);
+	if (!pProperty) continue;
+	double* values = checkpoint.addArray<double>("Property:" + pProperty->getName(), N);
+	std::copy(pProperty->getValues().begin(), pProperty->getValues().end(), values);
+      }
+
+    if (hasOrientationData())
+      {
+	double* U = checkpoint.addArray<double>("Orientation", N, 4);
+	double* O = checkpoint.addArray<double>("AngularVelocity", N, NDIM);
+	for (size_t i = 0; i < N; ++i)
+	  {
+	    U[4 * i] = orientationData[i].orientation.real();
+	    for (size_t j(0); j < 3; ++j)
+	      U[4 * i + 1 + j] = orientationData[i].orientation.imaginary()[j];
+	    for (size_t j(0); j < NDIM; ++j)
+	      O[NDIM * i + j] = orientationData[i].angularVelocity[j];
+	  }
+      }
+  }
+
+  void 
+  Dynamics::outputParticleXMLData(magnet::xml::XmlStream& XML, bool applyBC) const
+  {
+    if (Sim->_checkpoint)
+      {
+	outputParticleBinaryData(XML, applyBC);
+	return;
       }
+
+    outputParticleXMLData(XML, *copyParticleXMLData(applyBC));
+  }
+
+  shared_ptr<Dynamics::ParticleXMLData>
+  Dynamics::copyParticleXMLData(bool applyBC) const
+  {
+    shared_ptr<ParticleXMLData> data(new ParticleXMLData);
+    data->particles = Sim->particles;
+    data->orientationData = orientationData;
+
+    for (Particle& part : data->particles)
+      {
+	if (applyBC) 
+	  Sim->BCs->applyBC(part.getPosition(), part.getVelocity());
+	
+	part.getVelocity() *= (1.0 / Sim->units.unitVelocity());
+	part.getPosition() *= (1.0 / Sim->units.unitLength());
+      }
+
+    for (const shared_ptr<Property>& property : Sim->_properties)
+      {
+	shared_ptr<const ParticleProperty> pProperty = std::dynamic_pointer_cast<const ParticleProperty>(property);
+	if (pProperty)
+	  data->properties.push_back(std::make_pair(pProperty->getName(), pProperty->getValues()));
+      }
+
+    return data;
+  }
+
+  void 
+  Dynamics::outputParticleXMLData(magnet::xml::XmlStream& XML, const ParticleXMLData& data)
+  {
+    const size_t N = data.particles.size();
+    const bool hasOrientation = !data.orientationData.empty();
+
+    XML << magnet::xml::tag("ParticleData");
+  
+    if (hasOrientation)
+      XML << magnet::xml::attr("OrientationData") << "Y";
+
+    //Each thread formats a contiguous block of particles into its
+    //own fragment, which are then appended in order.
+    std::vector<magnet::xml::XmlStream> fragments(particleChunkCount(N));
+    for (magnet::xml::XmlStream& fragment : fragments)
+      fragment.beginFragment(XML);
+
+    parallelParticleChunks(N, [&](const size_t chunk, const size_t begin, const size_t end) {
+	magnet::xml::XmlStream& fragment = fragments[chunk];
+	for (size_t i = begin; i < end; ++i)
+	  {
+	    fragment << magnet::xml::tag("Pt");
+	    for (const auto& property : data.properties)
+	      fragment << magnet::xml::attr(property.first) << property.second[i];
+	    fragment << data.particles[i];
+	    
+	    if (hasOrientation)
+	      fragment << magnet::xml::tag("O")
+		       << data.orientationData[i].angularVelocity
+		       << magnet::xml::endtag("O")
+		       << magnet::xml::tag("U")
+		       << data.orientationData[i].orientation
+		       << magnet::xml::endtag("U") ;
+	    
+	    fragment << magnet::xml::endtag("Pt");
+	  }
+      });
+
+    for (const magnet::xml::XmlStream& fragment : fragments)
+      XML.appendFragment(fragment);
   
     XML << magnet::xml::endtag("ParticleData");
   }
@@ -94,6 +94,49 @@ namespace dynamo {
      */
     void outputParticleXMLData(magnet::xml::XmlStream& XML, bool applyBC) const;
 
+    /*! \brief A copy of the particle data in the configuration file
+      units, as written by outputParticleXMLData.
+     */
+    struct ParticleXMLData
+    {
+      std::vector<Particle> particles;
+      std::vector<rotData> orientationData;
+      //! \brief The name and values of each ParticleProperty.
+      std::vector<std::pair<std::string, std::vector<double> > > properties;
+    };
+
+    /*! \brief Take a copy of the particle data for writing.
+
+      The properties must already be scaled into the output units
+      (see Simulation::writeXMLfile).
+      \param applyBC Wether to apply the boundary conditions to the
+      particle positions.
+     */
+    shared_ptr<ParticleXMLData> copyParticleXMLData(bool applyBC) const;
+
+    /*! \brief Writes a copy of the particle data as XML.
+
+      This only accesses the copy, so it may run while the
+      simulation continues (e.g., on a background thread).
+     */
+    static void outputParticleXMLData(magnet::xml::XmlStream& XML, const ParticleXMLData& data);
+
+  protected:
+    /*! \brief Loads the particle data from the arrays of the
+      Simulation's BinaryCheckpoint.
+
+      \param XML The ParticleData xml::Node of the checkpoint.
+     */
+    void loadParticleBinaryData(const magnet::xml::Node& XML);
+
+    /*! \brief Writes the particle data into the arrays of the
+      Simulation's BinaryCheckpoint, leaving only an empty
+      ParticleData tag in the XML.
+     */
+    void outputParticleBinaryData(magnet::xml::XmlStream& XML, bool applyBC) const;
+
+  public:
+
     /*! \brief Returns the degrees of freedom of all particles.
      */
     size_t getParticleDOF() const;
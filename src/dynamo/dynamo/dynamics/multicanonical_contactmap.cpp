@@ -45,9 +45,9 @@ namespace dynamo {
 		= entry_node.getAttribute("State").as<size_t>();
 
 	    if (distance)
-	      _W.push_back(std::make_pair(map, WData(distance, Wval)));
+	      _W.push_back(std::make_pair(detail::CaptureMapKey(map), WData(distance, Wval)));
 	    else {
-	      _single_W[map] = WData(0, Wval);
+	      _single_W[detail::CaptureMapKey(map)] = WData(0, Wval);
 	    }
 	  }
       }
@@ -141,14 +141,15 @@ namespace dynamo {
     double MCDeltaKE = deltaKE;
 
     //If there are entries for the current and possible future energy, then take them into account
-    detail::CaptureMap contact_map = *_interaction;
+    const detail::CaptureMap& contact_map = *_interaction;
     
     //Add the current bias potential
-    MCDeltaKE += W(contact_map) * Sim->ensemble->getEnsembleVals()[2];
+    MCDeltaKE += W(detail::CaptureMapKey::view(contact_map)) * Sim->ensemble->getEnsembleVals()[2];
 
-    //subtract the possible bias potential in the new state
-    contact_map[detail::CaptureMap::key_type(particle1, particle2)] = newstate;
-    MCDeltaKE -= W(contact_map) * Sim->ensemble->getEnsembleVals()[2];
+    //subtract the possible bias potential in the new state (without
+    //copying the map)
+    MCDeltaKE -= W(detail::CaptureMapKey::view(contact_map, detail::CaptureMap::key_type(particle1, particle2), newstate))
+      * Sim->ensemble->getEnsembleVals()[2];
 
     //Test if the deformed energy change allows a capture event to occur
     double sqrtArg = retVal.rvdot * retVal.rvdot + 2.0 * R2 * MCDeltaKE / mu;
@@ -196,57 +197,29 @@ namespace dynamo {
   }
 
   double 
-  DynNewtonianMCCMap::W(const detail::CaptureMap& map) const
+  DynNewtonianMCCMap::W(const detail::CaptureMapKey& map) const
   {
     /*Iterate over all tether maps, finding the distance between them
       and looking if the tether applies.*/
     size_t applicable_tethers = 0;
     double accumilated_W = 0;
 
-    auto it = _single_W.find(detail::CaptureMapKey(map));
+    auto it = _single_W.find(map);
 
     if (it != _single_W.end()) {
       ++applicable_tethers;
       accumilated_W += it->second._wval;
     }
       
-    for (auto tethermap : _W)
+    for (const auto& tethermap : _W)
       {
-	auto il = tethermap.first.begin();
-	auto ir = map.begin();
-	
-	size_t distance = 0;
-	while (il != tethermap.first.end() && ir != map.end())
-	  {
-	    if ((*il).first < (*ir).first)
-	      {
-		++il;
-		++distance;
-	      }
-	    else if ((*ir).first < (*il).first)
-	      {
-		++ir;
-		++distance;
-	      }
-	    else
-	      {
-		++il;
-		++ir;
-	      }
-	  }
-
-	while (il != tethermap.first.end())
-	  {
-	    ++il;
-	    ++distance;
-	  }
-
-	while (ir != map.end())
-	  {
-	    ++ir;
-	    ++distance;
-	  }
+	//The distance is the number of pairs captured in only one of
+	//the maps
+	size_t common = 0;
+	for (const auto& entry : tethermap.first)
+	  common += (map[entry.first] != 0);
 
+	const size_t distance = tethermap.first.size() + map.size() - 2 * common;
 	if (distance <= tethermap.second._distance)
 	  {
 	    ++applicable_tethers;
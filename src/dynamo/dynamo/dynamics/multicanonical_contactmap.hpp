@@ -48,7 +48,12 @@ namespace dynamo {
     virtual void initialise();
     virtual void replicaExchange(Dynamics& oDynamics);
 
-    double W(const detail::CaptureMap& map) const;
+    /*! \brief The bias potential for a state of the contact map.
+
+      \param map The state of the map, usually a
+      detail::CaptureMapKey::view of the interaction.
+     */
+    double W(const detail::CaptureMapKey& map) const;
 
   protected:
     virtual void outputXML(magnet::xml::XmlStream& ) const;
@@ -18,6 +18,7 @@
 #pragma once
 #include <magnet/exception.hpp>
 #include <algorithm>
+#include <limits>
 #include <ostream>
 
 namespace dynamo {
@@ -24,8 +24,10 @@
 #include <dynamo/BC/LEBC.hpp>
 #include <dynamo/ranges/IDRangeList.hpp>
 #include <dynamo/dynamics/compression.hpp>
+#include <dynamo/locals/local.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
+#include <cmath>
 #include <cstdio>
 #include <set>
 #include <algorithm>
@@ -105,7 +107,14 @@ namespace dynamo {
     newCellCoord[cellDirection] += _ordering.getDimensions()[cellDirection] + ((cellDirectionInt > 0) ? 1 : -1);
     newCellCoord[cellDirection] %= _ordering.getDimensions()[cellDirection];
 
-    _cellData.moveTo(oldCellIndex, _ordering.toIndex(newCellCoord), part.getID());
+    const size_t newCellIndex = _ordering.toIndex(newCellCoord);
+    _cellData.moveTo(oldCellIndex, newCellIndex, part.getID());
+
+    //Any Locals which were not in the old cell are new neighbours
+    const std::vector<size_t>& oldLocals = _cellLocals[oldCellIndex];
+    for (const size_t& id : _cellLocals[newCellIndex])
+      if (!std::binary_search(oldLocals.begin(), oldLocals.end(), id))
+	_sigNewLocalNeighbour(part, id);
 
     //Particle has just arrived into a new cell, check the new
     //neighbours for particles
@@ -240,6 +249,71 @@ namespace dynamo {
 	Particle& p = Sim->particles[pid];
 	_cellData.add(_ordering.toIndex(getCellCoords(p.getPosition())), pid);
       }
+
+    addLocalsToCells();
+  }
+
+  void GCells::addLocalsToCells()
+  {
+    _cellLocals.clear();
+    _cellLocals.resize(_ordering.length());
+    _unboundedLocals.clear();
+
+    //The cells of a sheared system move relative to each other, and
+    //the particles of a compressing system grow, so in both cases the
+    //Locals are added to every cell
+    const bool unboundedOnly = std::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs) || std::dynamic_pointer_cast<DynCompression>(Sim->dynamics);
+
+    size_t cellEntries = 0;
+    for (size_t id(0); id < Sim->locals.size(); ++id)
+      {
+	const std::pair<Vector, Vector> bounds = Sim->locals[id]->getBounds();
+
+	//Find the range of cells overlapping the bounds in each
+	//dimension, wrapping around the periodic cell lattice
+	std::array<std::vector<size_t>, 3> coords;
+	bool unbounded = true;
+	for (size_t iDim = 0; iDim < NDIM; iDim++)
+	  {
+	    const long count = _ordering.getDimensions()[iDim];
+	    long first = 0, last = count - 1;
+	    if (!unboundedOnly && std::isfinite(bounds.first[iDim]) && std::isfinite(bounds.second[iDim]))
+	      {
+		const double origin = -0.5 * Sim->primaryCellSize[iDim] + _cellOffset[iDim];
+		first = std::ceil((bounds.first[iDim] - origin - _cellDimension[iDim]) / _cellLatticeWidth[iDim]);
+		last = std::floor((bounds.second[iDim] - origin) / _cellLatticeWidth[iDim]);
+		if (last - first + 1 >= count)
+		  {
+		    first = 0;
+		    last = count - 1;
+		  }
+		else
+		  unbounded = false;
+	      }
+
+	    for (long coord = first; coord <= last; ++coord)
+	      coords[iDim].push_back(((coord % count) + count) % count);
+	  }
+
+	if (unbounded)
+	  {
+	    _unboundedLocals.push_back(id);
+	    continue;
+	  }
+
+	for (const size_t& z : coords[2])
+	  for (const size_t& y : coords[1])
+	    for (const size_t& x : coords[0])
+	      {
+		_cellLocals[_ordering.toIndex(std::array<size_t, 3>{{x, y, z}})].push_back(id);
+		++cellEntries;
+	      }
+      }
+
+    dout << "Locals in every cell " << _unboundedLocals.size()
+	 << "\nLocals in a subset of cells " << Sim->locals.size() - _unboundedLocals.size()
+	 << "\nAverage Locals per cell " << double(cellEntries) / _ordering.length()
+	 << std::endl;
   }
 
   std::array<size_t, 3>
@@ -280,6 +354,13 @@ namespace dynamo {
     return getParticleNeighbours(getCellCoords(vec), retlist);
   }
 
+  void
+  GCells::getLocalNeighbours(const Particle& part, std::vector<size_t>& retlist) const {
+    retlist.insert(retlist.end(), _unboundedLocals.begin(), _unboundedLocals.end());
+    const std::vector<size_t>& locals = _cellLocals[_cellData.getCellID(part.getID())];
+    retlist.insert(retlist.end(), locals.begin(), locals.end());
+  }
+
   double 
   GCells::getMaxSupportedInteractionLength() const
   {
@@ -126,6 +126,8 @@ namespace dynamo {
 
     void getParticleNeighbours(const Particle&, std::vector<size_t>&) const;
     void getParticleNeighbours(const Vector&, std::vector<size_t>&) const;
+
+    void getLocalNeighbours(const Particle&, std::vector<size_t>&) const;
     
     virtual void operator<<(const magnet::xml::Node&);
 
@@ -156,6 +158,12 @@ namespace dynamo {
     detail::CellParticleList<magnet::containers::Vector_Multimap<magnet::containers::VectorSet<size_t>>, 
 			     std::unordered_map<size_t, size_t> > _cellData;
 #endif
+    /*! \brief The Locals in each cell, sorted by ID. Locals which
+        are in every cell are only stored in _unboundedLocals.
+     */
+    std::vector<std::vector<size_t> > _cellLocals;
+    std::vector<size_t> _unboundedLocals;
+
     GCells(const GCells&);
 
     virtual void outputXML(magnet::xml::XmlStream&) const;
@@ -164,6 +172,7 @@ namespace dynamo {
 
     void addCells(std::array<size_t, 3> cellCount);
     void buildCells();
+    void addLocalsToCells();
 
     Vector calcPosition(const size_t cellIndex, const Particle& part) const { return calcPosition(_ordering.toCoord(cellIndex), part);}
     Vector calcPosition(const std::array<size_t, 3>& coords, const Particle& part) const ;
@@ -47,6 +47,11 @@ namespace dynamo {
     virtual void getParticleNeighbours(const Particle&, std::vector<size_t>&) const = 0;
     virtual void getParticleNeighbours(const Vector&, std::vector<size_t>&) const = 0;
 
+    /*! \brief Appends the IDs of the \ref Local "Locals" a particle
+        may have events with before it next changes neighbourhood.
+     */
+    virtual void getLocalNeighbours(const Particle&, std::vector<size_t>&) const = 0;
+
     /*! \brief This returns the maximum interaction length this
       neighbourlist supports.
       
@@ -85,6 +90,7 @@ namespace dynamo {
     { return _maxInteractionRange; }
 
     mutable magnet::Signal<void(const Particle&, const size_t&)> _sigNewNeighbour;
+    mutable magnet::Signal<void(const Particle&, const size_t&)> _sigNewLocalNeighbour;
     mutable magnet::Signal<void(const Particle&, const size_t&)> _sigCellChange;
     mutable magnet::Signal<void()> _sigReInitialise;
 
@@ -19,6 +19,7 @@
 #include <dynamo/particle.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
 #include <dynamo/simulation.hpp>
+#include <dynamo/checkpoint.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
 
@@ -60,6 +61,18 @@ namespace dynamo {
 	_mapUninitialised = false;
 	clear();
 
+	if (XML.getNode("CaptureMap").hasAttribute("Array"))
+	  {
+	    if (!Sim->_checkpoint)
+	      M_throw() << "Binary capture maps can only be loaded from a binary checkpoint";
+	    
+	    const size_t count = XML.getNode("CaptureMap").getAttribute("Count").as<size_t>();
+	    const uint64_t* data = Sim->_checkpoint->getArray<uint64_t>(XML.getNode("CaptureMap").getAttribute("Array"), count, 3);
+	    for (size_t i(0); i < count; ++i)
+	      Map::operator[](Map::key_type(data[3 * i], data[3 * i + 1])) = data[3 * i + 2];
+	    return;
+	  }
+
 	for (magnet::xml::Node node = XML.getNode("CaptureMap").findNode("Pair"); node.valid(); ++node)
 	  Map::operator[](Map::key_type(node.getAttribute("ID1").as<size_t>(), node.getAttribute("ID2").as<size_t>()))
 	    = node.getAttribute("val").as<size_t>();
@@ -72,6 +85,23 @@ namespace dynamo {
     if (_mapUninitialised) return;
     XML << magnet::xml::tag("CaptureMap");
 
+    if (Sim->_checkpoint)
+      {
+	const std::string name = "CaptureMap:" + intName;
+	uint64_t* data = Sim->_checkpoint->addArray<uint64_t>(name, size(), 3);
+	for (const Map::value_type& IDs : *this)
+	  {
+	    *data++ = IDs.first.first;
+	    *data++ = IDs.first.second;
+	    *data++ = IDs.second;
+	  }
+
+	XML << magnet::xml::attr("Array") << name
+	    << magnet::xml::attr("Count") << size()
+	    << magnet::xml::endtag("CaptureMap");
+	return;
+      }
+
     for (const Map::value_type& IDs : *this)
       XML << magnet::xml::tag("Pair")
 	  << magnet::xml::attr("ID1") << IDs.first.first
@@ -25,8 +25,10 @@
 #else
 # include <unordered_map>
 #endif
+#include <algorithm>
 #include <map>
 #include <unordered_set>
+#include <vector>
 
 namespace dynamo { 
   namespace detail { 
@@ -69,23 +71,14 @@ namespace std
 
 namespace dynamo {
   namespace detail {
-    namespace {
-      ::std::size_t
-      hash_combine(const ::std::size_t hash1, const ::std::size_t hash2)
-      {
-	return hash1 ^ (hash2 + 0x9e3779b9 + (hash1 << 6) + (hash1 >> 2));
-      }
-    }
-    
     /*!\brief This is a container that stores a single size_t
       identified by a pair of particles.
        
       To efficiently store the state of all possible particle
       pairings, a map is used and entries are only stored if the
-      state is non-zero. Although an unordered_map may be slightly
-      faster, a map is used to allow comparison of CaptureMaps and a
-      rapid hashing if CaptureMaps are to be used as an index of the
-      simulation state.
+      state is non-zero. An incrementally maintained hash allows
+      CaptureMaps to be used as an index of the simulation state (see
+      CaptureMapKey).
        
       To facilitate the storage only if non-zero behaviour, the array
       access operator is overloaded to automatically return a size_t
@@ -102,34 +95,44 @@ namespace dynamo {
     {
       typedef CaptureMapContainer Container;
     public:
+      CaptureMap(): _hash(0) {}
+
       /*!\brief This proxy is used to double check if an assignment of
-	zero is done, and delete the entry if it is. */
+	zero is done, and delete the entry if it is. It also keeps
+	the hash of the map up to date. */
       struct EntryProxy {
       public:
-	EntryProxy(Container& container, const PairKey& key):
-	  _container(container), _key(key) {}
+	EntryProxy(CaptureMap& map, const PairKey& key):
+	  _map(map), _key(key) {}
 
 	operator const size_t() const {
-	  const auto it (_container.find(_key));
-	  return (it == _container.end()) ? 0 : (it->second);
+	  const auto it (_map.Container::find(_key));
+	  return (it == _map.Container::end()) ? 0 : (it->second);
 	}
 	
 	EntryProxy& operator=(size_t newval) {
+	  _map._hash ^= entryHash(_key, *this) ^ entryHash(_key, newval);
+
 	  if (newval == 0)
-	    _container.erase(_key);
+	    _map.Container::erase(_key);
 	  else
-	    _container[_key] = newval;
+	    _map.Container::operator[](_key) = newval;
 
 	  return *this;
 	}
 	
       private:
-	Container& _container;
+	CaptureMap& _map;
 	const PairKey _key;
       };
       
       /*! \brief This non-const array access operator uses EntryProxy
-	to check if any values assigned are zero so they may be deleted. */
+	to check if any values assigned are zero so they may be
+	deleted.
+
+	All changes to the map must be made through this operator (or
+	clear()) so that the hash is maintained.
+      */
       EntryProxy operator[](const PairKey& key) {
 	return EntryProxy(*this, key); 
       }
@@ -140,20 +143,133 @@ namespace dynamo {
 	Container::const_iterator it = Container::find(key);
 	return (it == Container::end()) ? 0 : (it->second);
       }
+
+      void clear() {
+	Container::clear();
+	_hash = 0;
+      }
+
+      /*! \brief A hash of the contents of the map.
+	
+	This is the XOR of the entryHash of every entry (a Zobrist
+	hash), so it is independent of the order of the entries and is
+	updated in O(1) time as entries change.
+      */
+      std::size_t hash() const { return _hash; }
+
+      /*! \brief The contribution of a single entry to the hash, zero
+	for missing entries. */
+      static std::size_t entryHash(const PairKey& key, const size_t value) {
+	return value ? mix(uint64_t(key) ^ mix(value)) : 0;
+      }
+
+    private:
+      //! \brief The splitmix64 finaliser.
+      static uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+      }
+
+      std::size_t _hash;
     };
 
-    struct CaptureMapKey: public std::vector<CaptureMap::value_type>
+    /*! \brief A key representing the state of a CaptureMap, for use
+      in unordered containers.
+
+      Keys made using the constructor hold a copy of the entries of
+      the map (sorted by pair), these are the keys which are stored
+      in containers. A search for a CaptureMap should use a key made
+      by view(), which only refers to the map (optionally with a
+      single entry changed). As the hash of the map is maintained
+      incrementally, creating and hashing a view is O(1), and the
+      entries are only compared if the hashes match.
+     */
+    class CaptureMapKey
     {
-      typedef std::vector<CaptureMap::value_type> Container;
-      CaptureMapKey(const CaptureMap& map):
-      Container(map.begin(), map.end()) {}
-
-      std::size_t hash() const {
-	std::size_t hash(0);
-	for (const Container::value_type& val : *this)
-	  hash = hash_combine(hash, hash_combine(size_t(val.first), size_t(val.second)));
-	return hash;
+    public:
+      typedef std::pair<PairKey, size_t> value_type;
+      typedef std::vector<value_type>::const_iterator const_iterator;
+
+      explicit CaptureMapKey(const CaptureMap& map):
+	_map(NULL), _key(uint64_t(0)), _value(0), _hash(map.hash()),
+	_entries(map.begin(), map.end())
+      {
+	std::sort(_entries.begin(), _entries.end(),
+		  [](const value_type& a, const value_type& b) { return uint64_t(a.first) < uint64_t(b.first); });
       }
+
+      //! \brief A key which refers to a CaptureMap.
+      static CaptureMapKey view(const CaptureMap& map) {
+	return CaptureMapKey(map, PairKey(uint64_t(0)), map[PairKey(uint64_t(0))]);
+      }
+
+      /*! \brief A key which refers to a CaptureMap, as if the entry
+	  for the pair key had the passed value. */
+      static CaptureMapKey view(const CaptureMap& map, const PairKey& key, const size_t value) {
+	return CaptureMapKey(map, key, value);
+      }
+
+      std::size_t hash() const { return _hash; }
+
+      //! \brief The number of non-zero entries.
+      size_t size() const {
+	return _map ? (_map->size() - ((*_map)[_key] != 0) + (_value != 0)) : _entries.size();
+      }
+
+      //! \brief The value of an entry (0 if it is missing).
+      size_t operator[](const PairKey& key) const {
+	if (_map)
+	  return (uint64_t(key) == uint64_t(_key)) ? _value : (*_map)[key];
+
+	auto it = std::lower_bound(_entries.begin(), _entries.end(), uint64_t(key),
+				   [](const value_type& a, const uint64_t b) { return uint64_t(a.first) < b; });
+	return ((it != _entries.end()) && (uint64_t(it->first) == uint64_t(key))) ? it->second : 0;
+      }
+
+      //! \brief Iteration over the entries of keys holding a copy.
+      const_iterator begin() const { return _entries.begin(); }
+      const_iterator end() const { return _entries.end(); }
+
+      bool operator==(const CaptureMapKey& other) const {
+	if ((_hash != other._hash) || (size() != other.size()))
+	  return false;
+
+	if (_map && other._map)
+	  return CaptureMapKey(*_map).withEntry(_key, _value) == other;
+
+	const CaptureMapKey& copy = _map ? other : *this;
+	const CaptureMapKey& test = _map ? *this : other;
+	for (const value_type& entry : copy)
+	  if (test[entry.first] != entry.second)
+	    return false;
+	return true;
+      }
+
+    private:
+      CaptureMapKey(const CaptureMap& map, const PairKey& key, const size_t value):
+	_map(&map), _key(key), _value(value),
+	_hash(map.hash() ^ CaptureMap::entryHash(key, map[key]) ^ CaptureMap::entryHash(key, value))
+      {}
+
+      //! \brief Apply the change of a view to a copy.
+      CaptureMapKey& withEntry(const PairKey& key, const size_t value) {
+	auto it = std::lower_bound(_entries.begin(), _entries.end(), uint64_t(key),
+				   [](const value_type& a, const uint64_t b) { return uint64_t(a.first) < b; });
+	const bool found = (it != _entries.end()) && (uint64_t(it->first) == uint64_t(key));
+	_hash ^= CaptureMap::entryHash(key, found ? it->second : 0) ^ CaptureMap::entryHash(key, value);
+	if (found && value) it->second = value;
+	else if (found) _entries.erase(it);
+	else if (value) _entries.insert(it, value_type(key, value));
+	return *this;
+      }
+
+      const CaptureMap* _map;
+      PairKey _key;
+      size_t _value;
+      std::size_t _hash;
+      std::vector<value_type> _entries;
     };
 
     /*! \brief A functor to allow the storage of CaptureMapKey types
@@ -48,6 +48,25 @@ namespace dynamo {
     return Event(part, Sim->dynamics->getCylinderWallCollision(part, vPosition, vAxis, colldist), LOCAL, WALL, ID);
   }
 
+  std::pair<Vector, Vector>
+  LCylinder::getBounds() const
+  {
+    //Only a cylinder aligned with the axes has a finite width
+    std::pair<Vector, Vector> retval = Local::getBounds();
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (vAxis[(iDim + 1) % NDIM] == 0 && vAxis[(iDim + 2) % NDIM] == 0)
+	{
+	  const double colldist = std::abs(_cyl_radius) + 0.5 * _diameter->getMaxValue();
+	  for (size_t jDim(0); jDim < NDIM; ++jDim)
+	    if (jDim != iDim)
+	      {
+		retval.first[jDim] = vPosition[jDim] - colldist;
+		retval.second[jDim] = vPosition[jDim] + colldist;
+	      }
+	}
+    return retval;
+  }
+
   ParticleEventData
   LCylinder::runEvent(Particle& part, const Event& iEvent) const
   {
@@ -22,7 +22,9 @@
 #include <dynamo/1particleEventData.hpp>
 #include <dynamo/ranges/IDRange.hpp>
 #include <magnet/math/vector.hpp>
+#include <limits>
 #include <string>
+#include <utility>
 
 namespace magnet { namespace xml { class Node; } }
 namespace xml { class XmlStream; }
@@ -35,8 +37,8 @@ namespace dynamo {
     events, which are localized in space, to be inserted into a
     neighbor list for efficiency.
     
-    To do this, the Local class provides the isInCell method, used by a
-    GNeighbourList to check if this Local is in a certain cell.
+    To do this, the Local class provides the getBounds method, used by
+    a GNeighbourList to find which of its cells this Local is in.
    */
   class Local: public dynamo::SimBase
   {
@@ -76,6 +78,19 @@ namespace dynamo {
      */
     virtual bool validateState(const Particle& part, bool textoutput = true) const = 0;
 
+    /*! \brief The lowest and highest corners of the box a particle
+        centre must be inside of to have an event with this Local.
+
+	Neighbour lists only test a Local against the particles in the
+	cells overlapping this box. A dimension may be infinite, and
+	the default is all of space.
+     */
+    virtual std::pair<Vector, Vector> getBounds() const
+    {
+      const double inf = std::numeric_limits<double>::infinity();
+      return std::make_pair(Vector{-inf, -inf, -inf}, Vector{inf, inf, inf});
+    }
+
     virtual void outputData(magnet::xml::XmlStream&) const {}
 
   protected:
@@ -65,6 +65,20 @@ namespace dynamo {
     return Event(part, Sim->dynamics->getPlaneEvent(part, vPosition, vNorm, r), LOCAL, WALL, ID);
   }
 
+  std::pair<Vector, Vector>
+  LRoughWall::getBounds() const
+  {
+    //Only a wall aligned with the axes has a finite thickness
+    std::pair<Vector, Vector> retval = Local::getBounds();
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (vNorm[(iDim + 1) % NDIM] == 0 && vNorm[(iDim + 2) % NDIM] == 0)
+	{
+	  retval.first[iDim] = vPosition[iDim] - r;
+	  retval.second[iDim] = vPosition[iDim] + r;
+	}
+    return retval;
+  }
+
   ParticleEventData
   LRoughWall::runEvent(Particle& part, const Event& iEvent) const
   {
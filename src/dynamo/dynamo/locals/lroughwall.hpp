@@ -38,6 +38,8 @@ namespace dynamo {
 
     virtual bool validateState(const Particle& part, bool textoutput = true) const;
 
+    virtual std::pair<Vector, Vector> getBounds() const;
+
   protected:
     virtual void outputXML(magnet::xml::XmlStream&) const;
 
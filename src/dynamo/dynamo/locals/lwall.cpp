@@ -44,6 +44,21 @@ namespace dynamo {
     return Event(part, Sim->dynamics->getPlaneEvent(part, vPosition, vNorm, colldist), LOCAL, WALL, ID);
   }
 
+  std::pair<Vector, Vector>
+  LWall::getBounds() const
+  {
+    //Only a wall aligned with the axes has a finite thickness
+    std::pair<Vector, Vector> retval = Local::getBounds();
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (vNorm[(iDim + 1) % NDIM] == 0 && vNorm[(iDim + 2) % NDIM] == 0)
+	{
+	  const double colldist = 0.5 * _diameter->getMaxValue();
+	  retval.first[iDim] = vPosition[iDim] - colldist;
+	  retval.second[iDim] = vPosition[iDim] + colldist;
+	}
+    return retval;
+  }
+
   ParticleEventData
   LWall::runEvent(Particle& part, const Event& iEvent) const
   {
@@ -17,11 +17,16 @@
 
 #include <dynamo/locals/trianglemesh.hpp>
 #include <dynamo/BC/BC.hpp>
+#include <dynamo/BC/None.hpp>
+#include <dynamo/BC/PBC.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
 #include <dynamo/NparticleEventData.hpp>
 #include <dynamo/units/units.hpp>
 #include <dynamo/schedulers/scheduler.hpp>
 #include <dynamo/outputplugins/outputplugin.hpp>
+#include <cmath>
+#include <functional>
+#include <typeinfo>
 
 
 namespace dynamo {
@@ -29,6 +34,223 @@ namespace dynamo {
     Local(tmp, "LocalWall")
   { operator<<(XML); }
 
+  void 
+  LTriangleMesh::initialise(size_t nID)
+  {
+    Local::initialise(nID);
+    buildGrid();
+  }
+
+  void 
+  LTriangleMesh::buildGrid()
+  {
+    _cellStart.clear();
+    _cellTriangles.clear();
+    _particleCell.clear();
+
+    if (_elements.empty()) return;
+
+    if (typeid(*Sim->BCs) == typeid(BCPeriodic))
+      _gridPeriodic = true;
+    else if (typeid(*Sim->BCs) == typeid(BCNone))
+      _gridPeriodic = false;
+    else
+      {
+	dout << "Triangle grid is not supported by the boundary conditions, testing every triangle" << std::endl;
+	return;
+      }
+
+    //The furthest a particle centre can be from a triangle it touches
+    const double reach = 0.5 * _diameter->getMaxValue();
+
+    //Find the bounds of each triangle, and of the whole mesh
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<std::pair<Vector, Vector> > bounds;
+    bounds.reserve(_elements.size());
+    Vector meshMin{inf, inf, inf}, meshMax{-inf, -inf, -inf};
+    double meanSize = 0;
+    for (const TriangleElements& elem : _elements)
+      {
+	const std::array<Vector, 3> corners{{_vertices[std::get<0>(elem)], _vertices[std::get<1>(elem)], _vertices[std::get<2>(elem)]}};
+	Vector low = corners[0], high = corners[0];
+	for (const Vector& corner : corners)
+	  for (size_t iDim(0); iDim < NDIM; ++iDim)
+	    {
+	      low[iDim] = std::min(low[iDim], corner[iDim]);
+	      high[iDim] = std::max(high[iDim], corner[iDim]);
+	    }
+
+	double size = 0;
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  {
+	    meshMin[iDim] = std::min(meshMin[iDim], low[iDim]);
+	    meshMax[iDim] = std::max(meshMax[iDim], high[iDim]);
+	    size = std::max(size, high[iDim] - low[iDim]);
+	  }
+	meanSize += size / _elements.size();
+	bounds.push_back(std::make_pair(low, high));
+      }
+
+    //The grid covers the primary image if periodic, otherwise just
+    //the region where particles can touch the mesh.
+    Vector extent;
+    if (_gridPeriodic)
+      {
+	_gridOrigin = -0.5 * Sim->primaryCellSize;
+	extent = Sim->primaryCellSize;
+      }
+    else
+      {
+	_gridOrigin = meshMin - Vector{reach, reach, reach};
+	extent = meshMax - meshMin + 2 * Vector{reach, reach, reach};
+      }
+
+    //Cells are roughly the size of a triangle, but no smaller than a
+    //particle, and their total number is capped
+    double width = std::max(2 * reach, meanSize);
+    const double maxCells = 1 << 22;
+    double cells = 1;
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      cells *= std::max(1.0, extent[iDim] / width);
+    if (cells > maxCells)
+      width *= std::cbrt(cells / maxCells);
+
+    size_t cellCount = 1;
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	_gridCount[iDim] = std::max(size_t(1), static_cast<size_t>(extent[iDim] / width));
+	//Periodic cells must be narrower than half the box for the
+	//cell transitions to be found
+	if (_gridPeriodic && (_gridCount[iDim] < 3))
+	  {
+	    dout << "Triangle grid is too coarse for the periodic box, testing every triangle" << std::endl;
+	    return;
+	  }
+	_gridWidth[iDim] = extent[iDim] / _gridCount[iDim];
+	_gridMargin[iDim] = 0.05 * _gridWidth[iDim];
+	cellCount *= _gridCount[iDim];
+      }
+
+    //Each triangle is added to every enlarged cell that a particle
+    //touching it could be in. This is done twice, once to count the
+    //triangles of each cell and then to store them.
+    _cellStart.assign(cellCount + 1, 0);
+    auto forEachCell = [&](const size_t triangle, const std::function<void(size_t)>& func) {
+      std::array<long, 3> first, last;
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	{
+	  const long count = _gridCount[iDim];
+	  const double pad = reach + _gridMargin[iDim];
+	  first[iDim] = static_cast<long>(std::floor((bounds[triangle].first[iDim] - pad - _gridOrigin[iDim]) / _gridWidth[iDim]));
+	  last[iDim] = static_cast<long>(std::floor((bounds[triangle].second[iDim] + pad - _gridOrigin[iDim]) / _gridWidth[iDim]));
+	  if (!_gridPeriodic)
+	    {
+	      first[iDim] = std::max(first[iDim], 0l);
+	      last[iDim] = std::min(last[iDim], count - 1);
+	    }
+	  else if (last[iDim] - first[iDim] >= count)
+	    {
+	      first[iDim] = 0;
+	      last[iDim] = count - 1;
+	    }
+	}
+
+      for (long z(first[2]); z <= last[2]; ++z)
+	for (long y(first[1]); y <= last[1]; ++y)
+	  for (long x(first[0]); x <= last[0]; ++x)
+	    {
+	      const std::array<long, 3> coords{{x, y, z}};
+	      size_t cell = 0;
+	      for (size_t iDim(NDIM); iDim-- > 0;)
+		{
+		  const long count = _gridCount[iDim];
+		  cell = cell * count + ((coords[iDim] % count) + count) % count;
+		}
+	      func(cell);
+	    }
+    };
+
+    for (size_t triangle(0); triangle < _elements.size(); ++triangle)
+      forEachCell(triangle, [&](const size_t cell) { ++_cellStart[cell + 1]; });
+
+    for (size_t cell(0); cell < cellCount; ++cell)
+      _cellStart[cell + 1] += _cellStart[cell];
+
+    _cellTriangles.resize(_cellStart.back());
+    std::vector<size_t> filled(_cellStart.begin(), _cellStart.end() - 1);
+    for (size_t triangle(0); triangle < _elements.size(); ++triangle)
+      forEachCell(triangle, [&](const size_t cell) { _cellTriangles[filled[cell]++] = triangle; });
+
+    //The cells of the particles are found when their events are
+    _particleCell.assign(Sim->N(), _cellStart.size());
+
+    dout << "Triangle grid of " << _gridCount[0] << "x" << _gridCount[1] << "x" << _gridCount[2]
+	 << " cells, with " << double(_cellTriangles.size()) / cellCount << " triangles per cell" << std::endl;
+  }
+
+  size_t
+  LTriangleMesh::findCell(const Particle& part) const
+  {
+    Vector pos = part.getPosition();
+    Sim->BCs->applyBC(pos);
+
+    size_t cell = 0;
+    for (size_t iDim(NDIM); iDim-- > 0;)
+      {
+	const long count = _gridCount[iDim];
+	long coord = static_cast<long>(std::floor((pos[iDim] - _gridOrigin[iDim]) / _gridWidth[iDim]));
+	if (_gridPeriodic)
+	  coord = ((coord % count) + count) % count;
+	else if ((coord < 0) || (coord >= count))
+	  return _cellStart.size();
+	cell = cell * count + coord;
+      }
+
+    return cell;
+  }
+
+  void
+  LTriangleMesh::getCellBounds(size_t cell, Vector& origin, Vector& width) const
+  {
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	const size_t coord = cell % _gridCount[iDim];
+	cell /= _gridCount[iDim];
+	origin[iDim] = _gridOrigin[iDim] + coord * _gridWidth[iDim] - _gridMargin[iDim];
+	width[iDim] = _gridWidth[iDim] + 2 * _gridMargin[iDim];
+      }
+  }
+
+  bool
+  LTriangleMesh::cellContains(const Particle& part, const size_t cell) const
+  {
+    Vector origin, width;
+    getCellBounds(cell, origin, width);
+    Vector rpos = part.getPosition() - origin - 0.5 * width;
+    Sim->BCs->applyBC(rpos);
+
+    //Allow for the rounding error in the position at the cell
+    //transition
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      if (std::abs(rpos[iDim]) > 0.5 * width[iDim] + 1e-9 * _gridWidth[iDim])
+	return false;
+
+    return true;
+  }
+
+  std::pair<double, size_t>
+  LTriangleMesh::getTriangleEvent(const Particle& part, const size_t triangle, const double diameter) const
+  {
+    const TriangleElements& elem = _elements[triangle];
+    const std::pair<double, size_t> t
+      = Sim->dynamics->getSphereTriangleEvent(part,
+					      _vertices[std::get<0>(elem)],
+					      _vertices[std::get<1>(elem)],
+					      _vertices[std::get<2>(elem)],
+					      diameter);
+    return std::make_pair(t.first, Dynamics::T_COUNT * triangle + t.second);
+  }
+
   Event 
   LTriangleMesh::getEvent(const Particle& part) const
   {
@@ -37,28 +259,69 @@ namespace dynamo {
       M_throw() << "Particle is not up to date";
 #endif
 
-    size_t triangleid = 0; //The id of the triangle for which the event is for
     double diam = 0.5 * _diameter->getProperty(part);
 
     std::pair<double, size_t> tmin(std::numeric_limits<float>::infinity(), 0); //Default to no collision
 
-    for (size_t id(0); id < _elements.size(); ++id)
+    if (!_cellStart.empty())
       {
-	std::pair<double, size_t> t 
-	  = Sim->dynamics->getSphereTriangleEvent(part,
-						  _vertices[std::get<0>(_elements[id])],
-						  _vertices[std::get<1>(_elements[id])],
-						  _vertices[std::get<2>(_elements[id])],
-						  diam);
-	if (t < tmin) { tmin = t; triangleid = id; }
+	//A particle keeps its cell until a virtual event moves it on,
+	//so that the event is found again if it is recalculated
+	size_t& cell = _particleCell[part.getID()];
+	if ((cell == _cellStart.size()) || !cellContains(part, cell))
+	  cell = findCell(part);
+
+	if (cell != _cellStart.size())
+	  {
+	    for (size_t i(_cellStart[cell]); i < _cellStart[cell + 1]; ++i)
+	      tmin = std::min(tmin, getTriangleEvent(part, _cellTriangles[i], diam));
+
+	    //Only the triangles of this cell can be hit until the
+	    //particle leaves it, after which it must look again
+	    Vector origin, width;
+	    getCellBounds(cell, origin, width);
+	    const double horizon = Sim->dynamics->getSquareCellCollision2(part, origin, width);
+	    if (tmin.first > horizon)
+	      return Event(part, horizon, LOCAL, VIRTUAL, ID);
+
+	    return Event(part, tmin.first, LOCAL, WALL, ID, tmin.second);
+	  }
       }
 
-    return Event(part, tmin.first, LOCAL, WALL, ID, 8 * triangleid + tmin.second);
+    for (size_t id(0); id < _elements.size(); ++id)
+      tmin = std::min(tmin, getTriangleEvent(part, id, diam));
+
+    return Event(part, tmin.first, LOCAL, WALL, ID, tmin.second);
+  }
+
+  std::pair<Vector, Vector>
+  LTriangleMesh::getBounds() const
+  {
+    if (_vertices.empty())
+      return Local::getBounds();
+
+    const double reach = 0.5 * _diameter->getMaxValue();
+    std::pair<Vector, Vector> retval(_vertices.front(), _vertices.front());
+    for (const Vector& vertex : _vertices)
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	{
+	  retval.first[iDim] = std::min(retval.first[iDim], vertex[iDim] - reach);
+	  retval.second[iDim] = std::max(retval.second[iDim], vertex[iDim] + reach);
+	}
+    return retval;
   }
 
   ParticleEventData
   LTriangleMesh::runEvent(Particle& part, const Event& iEvent) const
   { 
+    if (iEvent._type == VIRTUAL)
+      {
+	//The particle is leaving its cell, so move it into the next
+	Sim->dynamics->updateParticle(part);
+	_particleCell[part.getID()] = findCell(part);
+	return ParticleEventData(part, *Sim->species(part), VIRTUAL);
+      }
+
     ++Sim->eventCount;
   
     const size_t triangleID = iEvent._additionalData1 / Dynamics::T_COUNT;
@@ -19,6 +19,7 @@
 #include <dynamo/locals/local.hpp>
 #include <dynamo/coilRenderObj.hpp>
 #include <dynamo/simulation.hpp>
+#include <array>
 #include <tuple>
 #include <vector>
 
@@ -27,20 +28,43 @@
 #endif
 
 namespace dynamo {
+  /*! \brief A wall made from a mesh of triangles.
+
+    To avoid testing every triangle for every particle, the triangles
+    are sorted into a uniform grid of cells over the mesh (or over
+    the primary image, if the boundary conditions are periodic). A
+    particle only tests the triangles which overlap its current cell,
+    and if none of them are hit before it leaves the cell, a virtual
+    event is scheduled at the cell transition to look again. The
+    cells are enlarged slightly so that a particle leaving one cell
+    is always some distance inside the next, and each particle keeps
+    its cell until that virtual event so its events are the same when
+    they are recalculated.
+
+    Particles outside of the grid, or simulations with other boundary
+    conditions, fall back to testing every triangle.
+   */
   class LTriangleMesh: public Local, public CoilRenderObj
   {
   public:
+    typedef std::tuple<size_t, size_t, size_t> TriangleElements;
+
     LTriangleMesh(const magnet::xml::Node&, dynamo::Simulation*);
 
     template<class T1, class T2>
-    LTriangleMesh(dynamo::Simulation* nSim, T1 e, T2 d, std::string name, IDRange* nRange):
+    LTriangleMesh(dynamo::Simulation* nSim, T1 e, T2 d, std::string name, IDRange* nRange,
+		  const std::vector<Vector>& vertices, const std::vector<TriangleElements>& elements):
       Local(nRange, nSim, "LocalWall"),
+      _vertices(vertices),
+      _elements(elements),
       _e(Sim->_properties.getProperty(e, Property::Units::Dimensionless())),
       _diameter(Sim->_properties.getProperty(d, Property::Units::Length()))
     { localName = name; }
 
     virtual ~LTriangleMesh() {}
 
+    virtual void initialise(size_t);
+
     virtual Event getEvent(const Particle&) const;
 
     virtual ParticleEventData runEvent(Particle&, const Event&) const;
@@ -49,6 +73,8 @@ namespace dynamo {
 
     virtual bool validateState(const Particle& part, bool textoutput = true) const { return false; }
 
+    virtual std::pair<Vector, Vector> getBounds() const;
+
 #ifdef DYNAMO_visualizer
     virtual shared_ptr<coil::RenderObj> getCoilRenderObj() const;
     virtual void updateRenderData() const {}
@@ -61,12 +87,46 @@ namespace dynamo {
 
     virtual void outputXML(magnet::xml::XmlStream&) const;
 
-    std::vector<Vector> _vertices;
+    /*! \brief The time of a collision with a triangle, and the
+        event data which identifies the triangle and the part of it
+        hit.
+     */
+    std::pair<double, size_t> getTriangleEvent(const Particle&, size_t triangle, double diameter) const;
 
-    typedef std::tuple<size_t, size_t, size_t> TriangleElements;
+    void buildGrid();
+
+    /*! \brief The cell containing the particle, or _cellStart.size()
+        if it is outside of the grid.
+     */
+    size_t findCell(const Particle&) const;
+
+    //! \brief The lowest corner and size of an enlarged cell.
+    void getCellBounds(size_t cell, Vector& origin, Vector& width) const;
+
+    bool cellContains(const Particle&, size_t cell) const;
+
+    std::vector<Vector> _vertices;
     std::vector<TriangleElements> _elements;
 
     shared_ptr<Property> _e;
     shared_ptr<Property> _diameter;
+
+    //! \brief The lowest corner of the grid.
+    Vector _gridOrigin;
+    //! \brief The width of the grid cells.
+    Vector _gridWidth;
+    //! \brief The distance each cell is enlarged by on every side.
+    Vector _gridMargin;
+    std::array<size_t, 3> _gridCount;
+    bool _gridPeriodic;
+    /*! \brief The triangles of each cell, the triangles of cell i
+        are stored in _cellTriangles[_cellStart[i]] to
+        _cellTriangles[_cellStart[i+1]]. This is empty if the grid is
+        not in use.
+     */
+    std::vector<size_t> _cellStart;
+    std::vector<size_t> _cellTriangles;
+    //! \brief The cell each particle was last placed in.
+    mutable std::vector<size_t> _particleCell;
   };
 }
@@ -55,7 +55,7 @@ namespace dynamo {
   {
     if (lastEvent[part].second.first.second != NOSOURCE)
       {
-	counterData& refCount = counters[counterKey(eventKey(ck,etype), lastEvent[part].second)];
+	counterData& refCount = counters[eventKey(ck,etype)][lastEvent[part].second];
       
 	refCount.totalTime += Sim->systemTime - lastEvent[part].first;
 	++(refCount.count);
@@ -77,35 +77,33 @@ namespace dynamo {
   
     std::map<eventKey, std::pair<size_t, double> > totmap;
   
-    typedef std::pair<const counterKey, counterData> locPair;
-  
-  
     size_t initialsum(0);
   
-    typedef std::pair<eventKey,size_t> npair;
-    for (const npair& n : initialCounter)
-      initialsum += n.second;
+    for (const auto& n : initialCounter.entries())
+      initialsum += *n.second;
   
-    for (const locPair& ele : counters)
-      {
-	XML << magnet::xml::tag("Count")
-	    << magnet::xml::attr("Event") << ele.first.first.second
-	    << magnet::xml::attr("Name") << getName(ele.first.first.first, Sim)
-	    << magnet::xml::attr("lastEvent") << ele.first.second.second
-	    << magnet::xml::attr("lastName") << getName(ele.first.second.first, Sim)
-	    << magnet::xml::attr("Percent") << 100.0 * ((double) ele.second.count) 
-	  / ((double) totalCount)
-	    << magnet::xml::attr("mft") << ele.second.totalTime
-	  / (Sim->units.unitTime() * ((double) ele.second.count))
-	    << magnet::xml::endtag("Count");
+    for (const auto& event : counters.entries())
+      for (const auto& last : event.second->entries())
+	{
+	  const counterData& data = *last.second;
+	  XML << magnet::xml::tag("Count")
+	      << magnet::xml::attr("Event") << event.first.second
+	      << magnet::xml::attr("Name") << getName(event.first.first, Sim)
+	      << magnet::xml::attr("lastEvent") << last.first.second
+	      << magnet::xml::attr("lastName") << getName(last.first.first, Sim)
+	      << magnet::xml::attr("Percent") << 100.0 * ((double) data.count) 
+	    / ((double) totalCount)
+	      << magnet::xml::attr("mft") << data.totalTime
+	    / (Sim->units.unitTime() * ((double) data.count))
+	      << magnet::xml::endtag("Count");
       
-	//Add the total count
-	totmap[ele.first.first].first += ele.second.count;
+	  //Add the total count
+	  totmap[event.first].first += data.count;
       
-	//Add the rate
-	totmap[ele.first.first].second += ((double) ele.second.count) 
-	  / ele.second.totalTime;
-      }
+	  //Add the rate
+	  totmap[event.first].second += ((double) data.count) 
+	    / data.totalTime;
+	}
   
     XML << magnet::xml::endtag("TransitionMatrix")
 	<< magnet::xml::tag("Totals");
@@ -56,11 +56,11 @@ namespace dynamo {
 
     typedef std::pair<classKey, EEventType> eventKey;
 
-    typedef std::pair<eventKey, eventKey> counterKey;
+    /*! \brief The transition counters, indexed by the event and then
+        the previous event of the particle.*/
+    EventKeyArray<EventKeyArray<counterData> > counters;
   
-    std::map<counterKey, counterData> counters;
-  
-    std::map<eventKey, size_t> initialCounter;
+    EventKeyArray<size_t> initialCounter;
 
     typedef std::pair<double, eventKey> lastEventData;
 
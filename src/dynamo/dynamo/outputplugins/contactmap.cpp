@@ -57,7 +57,7 @@ namespace dynamo {
     if (!_interaction)
       M_throw() << "Could not cast \"" << _interaction_name << "\" to an ICapture type to build the contact map";
     
-    _current_map = _collected_maps.insert(CollectedMapType::value_type(*_interaction, MapData(Sim->systemTime, Sim->calcInternalEnergy(), _next_map_id++))).first;
+    _current_map = _collected_maps.insert(CollectedMapType::value_type(detail::CaptureMapKey(*_interaction), MapData(Sim->systemTime, Sim->calcInternalEnergy(), _next_map_id++))).first;
   }
 
   void OPContactMap::stream(double dt) { _weight += dt; }
@@ -96,11 +96,12 @@ namespace dynamo {
     flush();
     size_t oldMapID(_current_map->second._id);
     
-    //Try and find the current map in the collected maps
-    _current_map = _collected_maps.find(*_interaction);
+    //Try and find the current map in the collected maps, this does
+    //not copy the map
+    _current_map = _collected_maps.find(detail::CaptureMapKey::view(*_interaction));
     if (_current_map == _collected_maps.end())
       //Insert the new map
-      _current_map = _collected_maps.insert(CollectedMapType::value_type(*_interaction, MapData(Sim->systemTime, Sim->getOutputPlugin<OPMisc>()->getConfigurationalU(), _next_map_id++))).first;
+      _current_map = _collected_maps.insert(CollectedMapType::value_type(detail::CaptureMapKey(*_interaction), MapData(Sim->systemTime, Sim->getOutputPlugin<OPMisc>()->getConfigurationalU(), _next_map_id++))).first;
     
     //Add the link	    
     if (addLink)
@@ -150,7 +151,7 @@ namespace dynamo {
 	    << xml::attr("Energy") << entry.second._energy / Sim->units.unitEnergy()
 	    << xml::attr("Weight") << entry.second._weight / _total_weight;
 	
-	for (const ICapture::value_type& ids : entry.first)
+	for (const detail::CaptureMapKey::value_type& ids : entry.first)
 	  XML << xml::tag("Contact")
 	      << xml::attr("ID1") << ids.first.first
 	      << xml::attr("ID2") << ids.first.second
@@ -76,8 +76,8 @@ namespace dynamo {
     /*! \brief A hash table storing the histogram of the contact maps.
       
       The key of this map is a sorted list of the captured pairs in
-      the system. This sorting is implicitly carried out by the
-      _current_map.
+      the system. The current map of the interaction is found using
+      its incrementally maintained hash (see detail::CaptureMapKey).
      */
     CollectedMapType _collected_maps;
     CollectedMapType::iterator _current_map;
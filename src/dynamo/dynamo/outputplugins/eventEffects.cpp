@@ -37,58 +37,47 @@ namespace dynamo {
   void 
   OPEventEffects::eventUpdate(const Event& localEvent, const NEventData& SDat)
   {
+    if (SDat.L1partChanges.empty() && SDat.L2partChanges.empty())
+      return;
+
+    counterData& ref(counters[eventKey(getClassKey(localEvent), localEvent._type)]);
+
     for (const ParticleEventData& pData : SDat.L1partChanges)
       {
 	const Particle& p1 = Sim->particles[pData.getParticleID()];
-	const double m1 = Sim->species[p1]->getMass(p1.getID());
-	const Vector dP = m1 * (p1.getVelocity() - pData.getOldVel());
-	
-	newEvent(localEvent._type, getClassKey(localEvent), 0.5 * m1 * (p1.getVelocity().nrm2() - pData.getOldVel().nrm2()), dP);
+	const double m1 = Sim->species[pData.getSpeciesID()]->getMass(p1.getID());
+	ref.energyLoss += 0.5 * m1 * (p1.getVelocity().nrm2() - pData.getOldVel().nrm2());
+	ref.momentumChange += m1 * (p1.getVelocity() - pData.getOldVel());
       }
   
     for (const PairEventData& pData : SDat.L2partChanges)
       {
 	const Particle& p1 = Sim->particles[pData.particle1_.getParticleID()];
 	const Particle& p2 = Sim->particles[pData.particle2_.getParticleID()];
-	const double m1 = Sim->species[p1]->getMass(p1.getID());
-	const double m2 = Sim->species[p2]->getMass(p2.getID());
+	const double m1 = Sim->species[pData.particle1_.getSpeciesID()]->getMass(p1.getID());
+	const double m2 = Sim->species[pData.particle2_.getSpeciesID()]->getMass(p2.getID());
 
-	newEvent(localEvent._type, getClassKey(localEvent),
-		 0.5 * m1 * (p1.getVelocity().nrm2() - pData.particle1_.getOldVel().nrm2()),
-		 -pData.impulse);
-      
-	newEvent(localEvent._type, getClassKey(localEvent),
-		 0.5 * m2 * (p2.getVelocity().nrm2() - pData.particle2_.getOldVel().nrm2()),
-		 pData.impulse);
+	//The momentum changes of the pair cancel
+	ref.energyLoss += 0.5 * m1 * (p1.getVelocity().nrm2() - pData.particle1_.getOldVel().nrm2())
+	  + 0.5 * m2 * (p2.getVelocity().nrm2() - pData.particle2_.getOldVel().nrm2());
       }
   }
 
-  void 
-  OPEventEffects::newEvent(const EEventType& eType, const classKey& ck, 
-			   const double& deltaKE, const Vector & delP)
-  {
-    counterData& ref(counters[eventKey(ck, eType)]);
-    ref.energyLoss += deltaKE;
-    ref.momentumChange += delP;
-  }
-
   void
   OPEventEffects::output(magnet::xml::XmlStream &XML)
   {
     XML << magnet::xml::tag("EventEffects");
 
-    typedef std::pair<const eventKey, counterData> locPair;  
-  
-    for (const locPair& ele : counters)
+    for (const auto& ele : counters.entries())
       {
 	XML << magnet::xml::tag("Count")
 	    << magnet::xml::attr("Name") << getName(ele.first.first, Sim)
 	    << magnet::xml::attr("Event") << ele.first.second
 	    << magnet::xml::attr("EnergyLossRate") 
-	    << ele.second.energyLoss * Sim->units.unitTime()
+	    << ele.second->energyLoss * Sim->units.unitTime()
 	  / (Sim->systemTime * Sim->units.unitEnergy())
 	    << magnet::xml::tag("MomentumChangeRate") 
-	    << ele.second.momentumChange * Sim->units.unitTime()
+	    << ele.second->momentumChange * Sim->units.unitTime()
 	  / (Sim->systemTime * Sim->units.unitMomentum())
 	    << magnet::xml::endtag("MomentumChangeRate") 
 	    << magnet::xml::endtag("Count");
@@ -0,0 +1,306 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/outputplugins/eventtape.hpp>
+#include <dynamo/units/units.hpp>
+#include <dynamo/NparticleEventData.hpp>
+#include <dynamo/species/species.hpp>
+#include <dynamo/BC/BC.hpp>
+#include <magnet/xmlreader.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+
+namespace dynamo {
+  namespace {
+    static_assert(NDIM == 3, "The event tape layout assumes three dimensions");
+    static_assert(sizeof(EventTapeRecord) == 136, "The event tape record layout has changed");
+    static_assert(sizeof(EventTapeHeader) == 32, "The event tape header layout has changed");
+
+    const uint32_t tapeVersion = 1;
+    const uint32_t byteOrderMark = 0x01020304;
+    const size_t bufferRecords = 8192;
+
+    void store(double* dest, const Vector& vec)
+    { for (size_t i(0); i < 3; ++i) dest[i] = vec[i]; }
+
+    Vector load(const double* src)
+    { return Vector{src[0], src[1], src[2]}; }
+  }
+
+  EventTapeReader::EventTapeReader(const std::string& filename):
+    _file(filename, std::ios::in | std::ios::binary),
+    _records(0),
+    _position(0)
+  {
+    if (!_file)
+      M_throw() << "Could not open the event tape " << filename;
+
+    if (!_file.read(reinterpret_cast<char*>(&_header), sizeof(_header))
+	|| std::strncmp(_header.magic, "DYNTAPE", sizeof(_header.magic)))
+      M_throw() << filename << " is not an event tape";
+
+    if (_header.byteOrder != byteOrderMark)
+      M_throw() << "The event tape " << filename << " was written on a machine with a different byte order";
+
+    if ((_header.version != tapeVersion) || (_header.recordSize != sizeof(EventTapeRecord)))
+      M_throw() << "The event tape " << filename << " is version " << _header.version
+		<< " with records of " << _header.recordSize << " bytes, only version "
+		<< tapeVersion << " is supported";
+
+    _file.seekg(0, std::ios::end);
+    _records = (uint64_t(_file.tellg()) - sizeof(_header)) / sizeof(EventTapeRecord);
+    _file.seekg(sizeof(_header));
+
+    //The index is optional, only entries for complete records are
+    //used
+    std::ifstream index(filename + ".idx", std::ios::in | std::ios::binary);
+    EventTapeIndexEntry entry;
+    while (index.read(reinterpret_cast<char*>(&entry), sizeof(entry)) && (entry.record < _records))
+      _index.push_back(entry);
+  }
+
+  void
+  EventTapeReader::seekRecord(uint64_t record)
+  {
+    _position = std::min(record, _records);
+    _file.clear();
+    _file.seekg(sizeof(_header) + _position * sizeof(EventTapeRecord));
+  }
+
+  void
+  EventTapeReader::seekEvent(uint64_t eventCount)
+  {
+    //Start from the last indexed event before the requested event
+    auto it = std::upper_bound(_index.begin(), _index.end(), eventCount,
+			       [](uint64_t count, const EventTapeIndexEntry& entry)
+			       { return count < entry.eventCount; });
+    seekRecord((it == _index.begin()) ? 0 : (it - 1)->record);
+
+    EventTapeRecord record;
+    while (read(record))
+      if (record.eventCount >= eventCount)
+	{
+	  seekRecord(_position - 1);
+	  return;
+	}
+  }
+
+  bool
+  EventTapeReader::read(EventTapeRecord& record)
+  {
+    if (_position >= _records)
+      return false;
+
+    if (!_file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+      M_throw() << "Failed to read record " << _position << " of the event tape";
+
+    ++_position;
+    return true;
+  }
+
+  bool
+  EventTapeReader::readEvent(std::vector<EventTapeRecord>& records)
+  {
+    records.clear();
+    EventTapeRecord record;
+    while (read(record))
+      {
+	if (!records.empty() && (record.eventCount != records.front().eventCount))
+	  {
+	    seekRecord(_position - 1);
+	    break;
+	  }
+	records.push_back(record);
+      }
+    return !records.empty();
+  }
+
+  void
+  EventTapeReader::writeText(std::ostream& os, const std::vector<EventTapeRecord>& records)
+  {
+    if (records.empty()) return;
+
+    const EventTapeRecord& event = records.front();
+    os.precision(4);
+    os.setf(std::ios::fixed, std::ios::floatfield);
+    os << std::setw(8) << std::setfill('0') << event.eventCount
+       << ", Source=" << EventSource(event.source)
+       << ", SourceID=" << event.sourceID
+       << ", Event Type=" << EEventType(event.type)
+       << ", t=" << event.time
+       << ", dt=" << event.dt;
+
+    for (const EventTapeRecord& record : records)
+      if (record.kind == EventTapeRecord::SINGLE)
+	os << "\n   1PEvent: p1=" << record.p1 << ", Type=" << EEventType(record.particleType)
+	   << ", delP1=" << load(record.impulse).toString() << ", pos=" << load(record.r).toString()
+	   << ", vel=" << load(record.v1).toString() << ", oldvel=" << load(record.v2).toString() << "\n";
+
+    for (const EventTapeRecord& record : records)
+      if (record.kind == EventTapeRecord::PAIR)
+	{
+	  const Vector rij = load(record.r);
+	  const Vector vij = load(record.v1) - load(record.v2);
+	  os << "\n   2PEvent:"
+	     << " p1=" << std::setw(5) << record.p1
+	     << ", p2=" << std::setw(5) << record.p2
+	     << ", delP1=" << load(record.impulse).toString()
+	     << ", |r12|=" << std::setw(5) << rij.nrm()
+	     << ", post-r12=" << rij.toString()
+	     << ", post-v12=" << vij.toString()
+	     << ", post-rvdot=" << (vij | rij);
+	}
+    os << "\n";
+  }
+
+  OPEventTape::OPEventTape(const dynamo::Simulation* t1, const magnet::xml::Node& XML):
+    OutputPlugin(t1, "EventTape"),
+    _filename("eventtape.bin"),
+    _records(0),
+    _nextIndex(0)
+  {
+    if (XML.hasAttribute("FileName"))
+      _filename = XML.getAttribute("FileName").getValue();
+  }
+
+  OPEventTape::~OPEventTape()
+  {
+    try {
+      if (_tape.is_open())
+	flush();
+    } catch (std::exception& err) {
+      std::cerr << "\nFailed to flush the event tape:-" << err.what() << std::endl;
+    }
+  }
+
+  void
+  OPEventTape::initialise()
+  {
+    if (_tape.is_open())
+      flush();
+    _tape.close();
+    _indexFile.close();
+
+    _tape.open(_filename, std::ios::out | std::ios::trunc | std::ios::binary);
+    _indexFile.open(_filename + ".idx", std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!_tape || !_indexFile)
+      M_throw() << "Could not open the event tape " << _filename;
+
+    EventTapeHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::strcpy(header.magic, "DYNTAPE");
+    header.version = tapeVersion;
+    header.recordSize = sizeof(EventTapeRecord);
+    header.indexInterval = indexInterval;
+    header.byteOrder = byteOrderMark;
+    header.particles = Sim->N();
+    _tape.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    _buffer.clear();
+    _buffer.reserve(bufferRecords);
+    _indexBuffer.clear();
+    _records = 0;
+    _nextIndex = 0;
+  }
+
+  void
+  OPEventTape::eventUpdate(const Event& eevent, const NEventData& SDat)
+  {
+    if (_records + _buffer.size() >= _nextIndex)
+      {
+	_indexBuffer.push_back(EventTapeIndexEntry{Sim->eventCount, Sim->systemTime / Sim->units.unitTime(),
+	      _records + _buffer.size()});
+	_nextIndex += indexInterval;
+      }
+
+    EventTapeRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.eventCount = Sim->eventCount;
+    record.time = Sim->systemTime / Sim->units.unitTime();
+    record.dt = eevent._dt / Sim->units.unitTime();
+    record.sourceID = eevent._sourceID;
+    record.p1 = record.p2 = EventTapeRecord::noParticle;
+    record.source = eevent._source;
+    record.type = eevent._type;
+    record.particleType = eevent._type;
+    record.kind = EventTapeRecord::NONE;
+
+    if (SDat.L1partChanges.empty() && SDat.L2partChanges.empty())
+      _buffer.push_back(record);
+
+    for (const ParticleEventData& pData : SDat.L1partChanges)
+      {
+	const Particle& part = Sim->particles[pData.getParticleID()];
+	record.kind = EventTapeRecord::SINGLE;
+	record.p1 = part.getID();
+	record.p2 = EventTapeRecord::noParticle;
+	record.particleType = pData.getType();
+	const double mass = Sim->species[pData.getSpeciesID()]->getMass(part.getID());
+	store(record.impulse, mass * (part.getVelocity() - pData.getOldVel()) / Sim->units.unitMomentum());
+	store(record.v1, part.getVelocity() / Sim->units.unitVelocity());
+	store(record.v2, pData.getOldVel() / Sim->units.unitVelocity());
+	store(record.r, part.getPosition() / Sim->units.unitLength());
+	_buffer.push_back(record);
+      }
+
+    for (const PairEventData& pData : SDat.L2partChanges)
+      {
+	const size_t id1 = std::min(pData.particle1_.getParticleID(), pData.particle2_.getParticleID());
+	const size_t id2 = std::max(pData.particle1_.getParticleID(), pData.particle2_.getParticleID());
+	Vector rij = Sim->particles[id1].getPosition() - Sim->particles[id2].getPosition();
+	Sim->BCs->applyBC(rij);
+
+	record.kind = EventTapeRecord::PAIR;
+	record.p1 = id1;
+	record.p2 = id2;
+	record.particleType = pData.getType();
+	store(record.impulse, ((id1 == pData.particle1_.getParticleID()) ? pData.impulse : -pData.impulse)
+	      / Sim->units.unitMomentum());
+	store(record.v1, Sim->particles[id1].getVelocity() / Sim->units.unitVelocity());
+	store(record.v2, Sim->particles[id2].getVelocity() / Sim->units.unitVelocity());
+	store(record.r, rij / Sim->units.unitLength());
+	_buffer.push_back(record);
+      }
+
+    if (_buffer.size() >= bufferRecords)
+      flush();
+  }
+
+  void
+  OPEventTape::flush()
+  {
+    _tape.write(reinterpret_cast<const char*>(_buffer.data()), _buffer.size() * sizeof(EventTapeRecord));
+    _indexFile.write(reinterpret_cast<const char*>(_indexBuffer.data()),
+		     _indexBuffer.size() * sizeof(EventTapeIndexEntry));
+    _tape.flush();
+    _indexFile.flush();
+    if (!_tape || !_indexFile)
+      M_throw() << "Failed while writing the event tape " << _filename;
+
+    _records += _buffer.size();
+    _buffer.clear();
+    _indexBuffer.clear();
+  }
+
+  void
+  OPEventTape::output(magnet::xml::XmlStream&)
+  {
+    flush();
+    dout << "Wrote " << _records << " records to the event tape " << _filename << std::endl;
+  }
+}
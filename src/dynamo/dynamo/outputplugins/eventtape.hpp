@@ -0,0 +1,167 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/outputplugins/outputplugin.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace dynamo {
+  /*! \brief A single fixed-width record of the binary event tape.
+
+    Every particle change of an event is stored as one record, so an
+    event has as many records as it has particle changes (or a single
+    record with kind == NONE if it changed no particles). All records
+    of an event share the same eventCount. All quantities are in
+    simulation (reduced) units.
+   */
+  struct EventTapeRecord
+  {
+    enum : uint8_t { NONE = 0, SINGLE = 1, PAIR = 2 };
+    static const uint32_t noParticle = 0xFFFFFFFF;
+
+    uint64_t eventCount;
+    double time; //!< The system time after the event.
+    double dt; //!< The time step to the event.
+    uint32_t sourceID;
+    uint32_t p1; //!< The lower particle ID of a pair.
+    uint32_t p2; //!< noParticle for single particle records.
+    uint8_t source; //!< The EventSource of the event.
+    uint8_t type; //!< The EEventType of the event.
+    uint8_t particleType; //!< The EEventType of this particle change.
+    uint8_t kind; //!< NONE, SINGLE or PAIR.
+    double impulse[3]; //!< The momentum change of p1.
+    double v1[3]; //!< The post-event velocity of p1.
+    /*! \brief The post-event velocity of p2, or the pre-event
+        velocity of p1 for SINGLE records.*/
+    double v2[3];
+    /*! \brief The post-event separation (p1 - p2, boundary
+        conditions applied) for PAIR records, or the position of p1
+        for SINGLE records.*/
+    double r[3];
+  };
+
+  /*! \brief The header at the start of an event tape file.*/
+  struct EventTapeHeader
+  {
+    char magic[8]; //!< "DYNTAPE" and a terminating zero.
+    uint32_t version;
+    uint32_t recordSize; //!< sizeof(EventTapeRecord)
+    uint32_t indexInterval; //!< The number of records between index entries.
+    uint32_t byteOrder; //!< 0x01020304 in the byte order of the writer.
+    uint64_t particles; //!< The number of particles in the simulation.
+  };
+
+  /*! \brief An entry of the event tape index file.
+
+    An entry is written for the first event to start at or after
+    every indexInterval records, which allows a reader to seek to an
+    event without scanning the tape.
+   */
+  struct EventTapeIndexEntry
+  {
+    uint64_t eventCount;
+    double time;
+    uint64_t record; //!< The record number of the first record of the event.
+  };
+
+  /*! \brief Reads the binary event tape written by OPEventTape.
+
+    The tape may be read record by record, or one event at a
+    time. The index file (the tape filename with ".idx" appended) is
+    used to seek to an event if it is present.
+   */
+  class EventTapeReader
+  {
+  public:
+    EventTapeReader(const std::string& filename);
+
+    const EventTapeHeader& getHeader() const { return _header; }
+
+    //! \brief The number of records on the tape.
+    uint64_t records() const { return _records; }
+
+    //! \brief Move to the passed record number.
+    void seekRecord(uint64_t record);
+
+    /*! \brief Move to the first record of the first event with an
+        event count of at least eventCount.*/
+    void seekEvent(uint64_t eventCount);
+
+    //! \brief Read the next record, returns false at the end of the tape.
+    bool read(EventTapeRecord& record);
+
+    /*! \brief Read all records of the next event, returns false at
+        the end of the tape.*/
+    bool readEvent(std::vector<EventTapeRecord>& records);
+
+    /*! \brief Write the records of a single event in the text format
+        of the Trajectory output plugin.*/
+    static void writeText(std::ostream& os, const std::vector<EventTapeRecord>& records);
+
+  private:
+    std::ifstream _file;
+    EventTapeHeader _header;
+    uint64_t _records;
+    uint64_t _position;
+    std::vector<EventTapeIndexEntry> _index;
+  };
+
+  /*! \brief Records every event to a compact binary file.
+
+    This is a much faster replacement for OPTrajectory. The records
+    (see EventTapeRecord) are collected in a buffer and written in
+    blocks to the tape file (FileName, by default
+    "eventtape.bin"). An index to the tape is written alongside it to
+    FileName.idx. The dynatape program converts a tape into the text
+    format of OPTrajectory.
+   */
+  class OPEventTape: public OutputPlugin
+  {
+  public:
+    OPEventTape(const dynamo::Simulation*, const magnet::xml::Node&);
+
+    ~OPEventTape();
+
+    void eventUpdate(const Event&, const NEventData&);
+
+    virtual void replicaExchange(OutputPlugin&)
+    { M_throw() << "This output plugin hasn't been prepared for changes of system"; }
+
+    virtual void initialise();
+
+    virtual void output(magnet::xml::XmlStream&);
+
+    //! \brief Write any buffered records to the tape.
+    void flush();
+
+    static const uint32_t indexInterval = 1024;
+
+  private:
+    OPEventTape(const OPEventTape&) = delete;
+
+    std::string _filename;
+    std::ofstream _tape;
+    std::ofstream _indexFile;
+    std::vector<EventTapeRecord> _buffer;
+    std::vector<EventTapeIndexEntry> _indexBuffer;
+    uint64_t _records;
+    uint64_t _nextIndex;
+  };
+}
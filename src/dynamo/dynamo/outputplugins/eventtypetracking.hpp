@@ -17,8 +17,11 @@
 
 #pragma once
 #include <dynamo/eventtypes.hpp>
+#include <algorithm>
+#include <map>
 #include <utility>
 #include <string>
+#include <vector>
 
 namespace dynamo
 {
@@ -35,5 +38,72 @@ namespace dynamo
     std::string getClass(const classKey&);
 
     classKey getClassKey(const Event&);
+
+    /*! \brief A container of values for each event key (the source,
+      source ID and type of an event) with O(1) access.
+
+      This replaces a std::map keyed on the event key in the output
+      plugins which are updated on every event. The events of the
+      interactions, locals, globals and systems are stored in dense
+      arrays indexed by the source ID and event type, which are grown
+      as required. Events of any other source (or with an unexpectedly
+      large source ID) are stored in a map.
+     */
+    template<class T>
+    class EventKeyArray
+    {
+    public:
+      typedef std::pair<classKey, EEventType> key_type;
+
+      /*! \brief Access (and create) the entry of a key. */
+      T& operator[](const key_type& key)
+      {
+	const size_t source = key.first.second;
+	if ((source < denseSources) && (key.first.first < maxDenseID))
+	  {
+	    std::vector<std::pair<bool, T> >& data = _dense[source];
+	    const size_t index = key.first.first * FINAL_ENUM_TO_CATCH_THE_COMMA + key.second;
+	    if (index >= data.size())
+	      data.resize(index + 1, std::pair<bool, T>(false, T()));
+	    data[index].first = true;
+	    return data[index].second;
+	  }
+	return _overflow[key];
+      }
+
+      /*! \brief The entries which have been accessed, sorted by key
+          (the order of a std::map).*/
+      std::vector<std::pair<key_type, const T*> > entries() const
+      {
+	std::vector<std::pair<key_type, const T*> > retval;
+	for (size_t source(0); source < denseSources; ++source)
+	  for (size_t index(0); index < _dense[source].size(); ++index)
+	    if (_dense[source][index].first)
+	      retval.push_back(std::make_pair(key_type(classKey(index / FINAL_ENUM_TO_CATCH_THE_COMMA, EventSource(source)),
+						       EEventType(index % FINAL_ENUM_TO_CATCH_THE_COMMA)),
+					      &_dense[source][index].second));
+
+	for (const auto& entry : _overflow)
+	  retval.push_back(std::make_pair(entry.first, &entry.second));
+
+	std::sort(retval.begin(), retval.end(),
+		  [](const std::pair<key_type, const T*>& a, const std::pair<key_type, const T*>& b)
+		  { return a.first < b.first; });
+	return retval;
+      }
+
+      void clear()
+      {
+	for (auto& data : _dense) data.clear();
+	_overflow.clear();
+      }
+
+    private:
+      static const size_t denseSources = SCHEDULER;
+      static const size_t maxDenseID = 4096;
+
+      std::vector<std::pair<bool, T> > _dense[denseSources];
+      std::map<key_type, T> _overflow;
+    };
   }
 }
@@ -26,13 +26,17 @@
 #include <ctime>
 
 namespace dynamo {
-  OPMisc::OPMisc(const dynamo::Simulation* tmp, const magnet::xml::Node&):
+  OPMisc::OPMisc(const dynamo::Simulation* tmp, const magnet::xml::Node& XML):
     OutputPlugin(tmp,"Misc",0),//ContactMap must be after this
     _dualEvents(0),
     _singleEvents(0),
     _virtualEvents(0),
-    _reverseEvents(0)
-  {}
+    _reverseEvents(0),
+    _transport(true)
+  {
+    if (XML.hasAttribute("NoTransport"))
+      _transport = false;
+  }
 
   void
   OPMisc::replicaExchange(OutputPlugin& misc2)
@@ -168,6 +172,11 @@ namespace dynamo {
     _kineticP.init(kineticP);
     _sysMomentum.init(sysMomentum);
 
+    //The transport correlators are not written out for sheared
+    //systems, so they are not collected either
+    if (std::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs))
+      _transport = false;
+
     //Set up the correlators
     double correlator_dt = Sim->lastRunMFT / 8;
     if (correlator_dt == 0.0)
@@ -215,7 +224,7 @@ namespace dynamo {
       {
 
 	const Particle& part = Sim->particles[PDat.getParticleID()];
-	const Species& species = *Sim->species(part);
+	const Species& species = *Sim->species[PDat.getSpeciesID()];
 	const double mass = species.getMass(part.getID());
 	const double deltaKE = species.getParticleKineticEnergy(part) - PDat.getOldKE();
 	
@@ -283,22 +292,26 @@ namespace dynamo {
 	  + mass2 * (Dyadic(part2.getVelocity(), part2.getVelocity())
 		     - Dyadic(PDat.particle2_.getOldVel(), PDat.particle2_.getOldVel()));
 
-	_viscosity.addImpulse(magnet::math::Dyadic(PDat.rij, delP));
-
 	_speciesMomenta[sp1.getID()] += delP;
 	_speciesMomenta[sp2.getID()] -= delP;
 
-	const Vector thermalImpulse = PDat.rij * p1deltaE;
+	if (_transport)
+	  {
+	    _viscosity.addImpulse(magnet::math::Dyadic(PDat.rij, delP));
 
-	_thermalConductivity.addImpulse(thermalImpulse);
+	    const Vector thermalImpulse = PDat.rij * p1deltaE;
+	    _thermalConductivity.addImpulse(thermalImpulse);
 
-	for (size_t spid1(0); spid1 < Sim->species.size(); ++spid1)
-	  _thermalDiffusion[spid1].addImpulse(thermalImpulse, Vector{0,0,0});
+	    for (size_t spid1(0); spid1 < Sim->species.size(); ++spid1)
+	      _thermalDiffusion[spid1].addImpulse(thermalImpulse, Vector{0,0,0});
+	  }
 
 	thermalDel += part1.getVelocity() * p1E + part2.getVelocity() * p2E
 	  - PDat.particle1_.getOldVel() * (p1E - p1deltaE) - PDat.particle2_.getOldVel() * (p2E - p2deltaE);
       }
 
+    if (!_transport) return;
+
     _thermalConductivity.setFreeStreamValue
       (_thermalConductivity.getFreeStreamValue() + thermalDel);
 
@@ -325,6 +338,9 @@ namespace dynamo {
     _internalE.stream(dt);
     _kineticP.stream(dt);
     _sysMomentum.stream(dt);
+
+    if (!_transport) return;
+
     _thermalConductivity.freeStream(dt);
     _viscosity.freeStream(dt);
     for (size_t spid1(0); spid1 < Sim->species.size(); ++spid1)
@@ -475,21 +491,20 @@ namespace dynamo {
 
 	<< tag("EventCounters");
   
-    typedef std::pair<CounterKey, CounterData> mappair;
-    for (const mappair& mp1 : _counters)
+    for (const auto& mp1 : _counters.entries())
       XML << tag("Entry")
 	  << attr("Type") << getClass(mp1.first.first)
 	  << attr("Name") << getName(mp1.first.first, Sim)
 	  << attr("Event") << mp1.first.second
-	  << attr("Count") << mp1.second.count
+	  << attr("Count") << mp1.second->count
 	  << tag("NetImpulse") 
-	  << mp1.second.netimpulse / Sim->units.unitMomentum()
+	  << mp1.second->netimpulse / Sim->units.unitMomentum()
 	  << endtag("NetImpulse")
 	  << tag("NetKEChange")
-	  << attr("Value") << mp1.second.netKEchange / Sim->units.unitEnergy()
+	  << attr("Value") << mp1.second->netKEchange / Sim->units.unitEnergy()
 	  << endtag("NetKEChange")
 	  << tag("NetUChange")
-	  << attr("Value") << mp1.second.netUchange / Sim->units.unitEnergy()
+	  << attr("Value") << mp1.second->netUchange / Sim->units.unitEnergy()
 	  << endtag("NetUChange")
 	  << endtag("Entry");
     
@@ -512,7 +527,7 @@ namespace dynamo {
 	<< attr("MaxKiloBytes") << magnet::process_mem_usage()
 	<< endtag("Memusage");
 
-    if (!std::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs)) {
+    if (_transport) {
       XML	<< tag("ThermalConductivity")
 		<< tag("Correlator")
 		<< chardata();
@@ -80,7 +80,7 @@ namespace dynamo {
       double netUchange;
     };
 
-    std::map<CounterKey, CounterData> _counters;
+    EventKeyArray<CounterData> _counters;
     std::chrono::system_clock::time_point _starttime;
     unsigned long _dualEvents;
     unsigned long _singleEvents;
@@ -94,6 +94,8 @@ namespace dynamo {
     magnet::math::LogarithmicTimeCorrelator<Matrix> _viscosity;
     std::vector<magnet::math::LogarithmicTimeCorrelator<Vector> > _thermalDiffusion;
     std::vector<magnet::math::LogarithmicTimeCorrelator<Vector> > _mutualDiffusion;
+    //! \brief If the transport correlators are collected (disabled by the NoTransport option).
+    bool _transport;
     std::vector<double> _internalEnergy;
     std::vector<double> _speciesMasses;
     std::vector<Vector> _speciesMomenta;
@@ -134,6 +134,8 @@ namespace dynamo {
       return testGeneratePlugin<OPChainBondAngles>(Sim, XML);
     else if (!Name.compare("Trajectory"))
       return testGeneratePlugin<OPTrajectory>(Sim, XML);
+    else if (!Name.compare("EventTape"))
+      return testGeneratePlugin<OPEventTape>(Sim, XML);
     else if (!Name.compare("ChainBondLength"))
       return testGeneratePlugin<OPChainBondLength>(Sim, XML);
     else if (!Name.compare("VelDist"))
@@ -146,6 +148,8 @@ namespace dynamo {
       return testGeneratePlugin<OPMSDCorrelator>(Sim, XML);
     else if (!Name.compare("VACF"))
       return testGeneratePlugin<OPVACF>(Sim, XML);
+    else if (!Name.compare("MSDMultipleTau"))
+      return testGeneratePlugin<OPMSDMultipleTau>(Sim, XML);
     else if (!Name.compare("KEnergyTicker"))
       return testGeneratePlugin<OPKEnergyTicker>(Sim, XML);
     else if (!Name.compare("StructureImage"))
@@ -15,25 +15,59 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <boost/math/special_functions/spherical_harmonic.hpp>
 #include <dynamo/outputplugins/tickerproperty/SHcrystal.hpp>
-#include <dynamo/schedulers/scheduler.hpp>
+#include <dynamo/include.hpp>
 #include <dynamo/globals/neighbourList.hpp>
-#include <dynamo/units/units.hpp>
-#include <dynamo/BC/BC.hpp>
-#include <boost/math/special_functions/spherical_harmonic.hpp>
+#include <dynamo/BC/LEBC.hpp>
+#include <magnet/math/spherical_harmonics.hpp>
 #include <magnet/math/wigner3J.hpp>
+#include <magnet/thread/threadpool.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
-#include <fstream>
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
 namespace dynamo {
+  namespace {
+    //! \brief The number of degrees evaluated, the local order needs l=6
+    size_t harmonicDegrees(size_t maxl) { return std::max(maxl, size_t(7)); }
+
+    /*! \brief The sum over all m of the product of a harmonic of
+        degree l and the conjugate of another, where only m >= 0 is
+        stored (see magnet::math::SphericalHarmonics).
+     */
+    double productSum(const std::complex<double>* a, const std::complex<double>* b, const size_t l)
+    {
+      double sum = (a[0] * std::conj(b[0])).real();
+      for (size_t m(1); m <= l; ++m)
+	sum += 2 * (a[m] * std::conj(b[m])).real();
+      return sum;
+    }
+
+    //! \brief A harmonic of any m, where only m >= 0 is stored.
+    std::complex<double> harmonic(const std::complex<double>* a, const int m)
+    {
+      if (m >= 0) return a[m];
+      return (m % 2) ? -std::conj(a[-m]) : std::conj(a[-m]);
+    }
+
+    //! \brief Find the root of a set in a union-find forest.
+    size_t findRoot(std::vector<size_t>& parent, size_t i)
+    {
+      while (parent[i] != i)
+	i = parent[i] = parent[parent[i]];
+      return i;
+    }
+  }
+
   OPSHCrystal::OPSHCrystal(const dynamo::Simulation* tmp, const magnet::xml::Node& XML):
     OPTicker(tmp,"SHCrystal"), rg(1.2), maxl(7),
     nblistID(std::numeric_limits<size_t>::max()),
-    count(0)
+    count(0),
+    bondThreshold(0.7),
+    solidBonds(7),
+    perParticle(false)
   {
     operator<<(XML);
   }
@@ -47,6 +81,18 @@ namespace dynamo {
     if (XML.hasAttribute("MaxL"))
       maxl = XML.getAttribute("MaxL").as<size_t>();
 
+    if (XML.hasAttribute("BondThreshold"))
+      bondThreshold = XML.getAttribute("BondThreshold").as<double>();
+
+    if (XML.hasAttribute("SolidBonds"))
+      solidBonds = XML.getAttribute("SolidBonds").as<size_t>();
+
+    if (XML.hasAttribute("PerParticle"))
+      perParticle = true;
+
+    if (XML.hasAttribute("Background"))
+      background = true;
+
     rg *= Sim->units.unitLength();
 
 
@@ -76,34 +122,217 @@ namespace dynamo {
       M_throw() << "There is not a suitable neighbourlist for the cut-off radius selected."
 	"\nR_g = " << rg / Sim->units.unitLength();
 
+    //The Lees-Edwards images depend on the current time, which the
+    //worker thread cannot read
+    if (background && std::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs))
+      M_throw() << "SHCrystal cannot be run in the background with Lees-Edwards boundary conditions";
+
     globalcoeff.resize(maxl);
     for (size_t l=0; l < maxl; ++l)
       globalcoeff[l].resize(2*l+1,std::complex<double>(0,0));
 
+    w6Coeffs.clear();
+    for (int m1(-6); m1 <= 6; ++m1)
+      for (int m2(-6); m2 <= 6; ++m2)
+	if (std::abs(m1 + m2) <= 6)
+	  w6Coeffs.push_back(std::make_pair(std::make_pair(m1, m2), magnet::math::wignerThreej(6, 6, 6, m1, m2, -(m1 + m2))));
+
+    samples = 0;
+    q4Sum = q6Sum = W6Sum = 0;
+    bondedCount = solidCount = largestClusterSum = 0;
+    clusterSizes.clear();
+
     ticker();
   }
 
   void 
   OPSHCrystal::ticker()
   {
-    sphericalsum ssum(Sim, rg, maxl);
-  
+    const std::function<void()> task = prepareTicker(takeSnapshot(Sim, false));
+    if (task) task();
+  }
+
+  OPTicker::SnapshotNeeds
+  OPSHCrystal::snapshotNeeds() const
+  { return background ? PARTICLES : NO_SNAPSHOT; }
+
+  std::function<void()>
+  OPSHCrystal::prepareTicker(const shared_ptr<const TickerSnapshot>& snapshot)
+  {
+    //Copy the candidate neighbours out of the neighbour list, a
+    //single list is filled to avoid allocating for each particle
+    shared_ptr<Neighbours> neighbours(new Neighbours);
+    neighbours->start.reserve(Sim->N() + 1);
+    const GNeighbourList& nblist = static_cast<const GNeighbourList&>(*Sim->globals[nblistID]);
     for (const Particle& part : Sim->particles)
       {
-	std::unique_ptr<IDRange> ids(Sim->ptrScheduler->getParticleNeighbours(part));
-	for (const size_t& id1 : *ids)
-	  ssum(part, id1);
-      
-	for (size_t l(0); l < maxl; ++l)
-	  for (int m(-l); m <= static_cast<int>(l); ++m)
-	    globalcoeff[l][m+l] += ssum.coeffsum[l][m+l];
-      
-	count += ssum.count;
+	neighbours->start.push_back(neighbours->IDs.size());
+	nblist.getParticleNeighbours(part, neighbours->IDs);
+      }
+    neighbours->start.push_back(neighbours->IDs.size());
+
+    const shared_ptr<const BoundaryCondition> BCs = Sim->BCs;
+    return [this, snapshot, neighbours, BCs]() { sample(*snapshot, *neighbours, *BCs); };
+  }
+
+  void
+  OPSHCrystal::sample(const TickerSnapshot& snapshot, const Neighbours& neighbours, const BoundaryCondition& BCs)
+  {
+    typedef magnet::math::SphericalHarmonics Harmonics;
+    const size_t N = snapshot.positions.size();
+    const size_t L = harmonicDegrees(maxl);
+    const size_t harmonics = Harmonics::size(L);
+
+    //The averaged harmonics of each particle and which of its
+    //candidate neighbours are bonded
+    std::vector<std::complex<double> > qlm(N * harmonics);
+    std::vector<char> bonded(neighbours.IDs.size(), false);
+    local.assign(N, LocalOrder());
+
+    const size_t threads = samplingThreads(N);
+    const size_t tasks = std::max(size_t(1), threads);
+    std::vector<std::vector<std::complex<double> > > taskSums(tasks, std::vector<std::complex<double> >(harmonics));
+    std::vector<size_t> taskBonds(tasks, 0);
+
+    magnet::thread::ThreadPool pool;
+    pool.setThreadCount(threads);
+    for (size_t task(0); task < tasks; ++task)
+      pool.queueTask([&, task]() {
+	  Harmonics Y(L);
+	  std::vector<std::complex<double> >& sum = taskSums[task];
+	  for (size_t p1(task * N / tasks); p1 < (task + 1) * N / tasks; ++p1)
+	    {
+	      std::complex<double>* q = &qlm[p1 * harmonics];
+	      LocalOrder& order = local[p1];
+	      for (size_t n(neighbours.start[p1]); n < neighbours.start[p1 + 1]; ++n)
+		{
+		  const size_t p2 = neighbours.IDs[n];
+		  if (p1 == p2) continue;
+		  Vector rij = snapshot.positions[p1] - snapshot.positions[p2];
+		  BCs.applyBC(rij);
+		  const double norm = rij.nrm();
+		  if (norm > rg) continue;
+
+		  bonded[n] = true;
+		  ++order.bonds;
+		  Y.evaluate(rij / norm);
+		  for (size_t i(0); i < harmonics; ++i)
+		    q[i] += Y.values()[i];
+		}
+
+	      for (size_t i(0); i < harmonics; ++i)
+		sum[i] += q[i];
+	      taskBonds[task] += order.bonds;
+
+	      if (!order.bonds) continue;
+	      for (size_t i(0); i < harmonics; ++i)
+		q[i] /= double(order.bonds);
+
+	      const std::complex<double>* q4 = q + Harmonics::index(4, 0);
+	      const std::complex<double>* q6 = q + Harmonics::index(6, 0);
+	      const double q4norm = productSum(q4, q4, 4);
+	      const double q6norm = productSum(q6, q6, 6);
+	      order.q4 = std::sqrt(q4norm * 4 * M_PI / 9);
+	      order.q6 = std::sqrt(q6norm * 4 * M_PI / 13);
+
+	      double W6 = 0;
+	      for (const std::pair<std::pair<int, int>, double>& coeff : w6Coeffs)
+		{
+		  const int m1 = coeff.first.first, m2 = coeff.first.second;
+		  W6 += coeff.second * (harmonic(q6, m1) * harmonic(q6, m2) * harmonic(q6, -(m1 + m2))).real();
+		}
+	      order.W6 = q6norm ? W6 * std::pow(q6norm, -1.5) : 0;
+	    }
+	});
+    pool.wait();
 
-	ssum.clear();
+    //Count the connections of each particle, which needs the
+    //harmonics of all of its neighbours
+    std::vector<char> solid(N, false);
+    for (size_t task(0); task < tasks; ++task)
+      pool.queueTask([&, task]() {
+	  for (size_t p1(task * N / tasks); p1 < (task + 1) * N / tasks; ++p1)
+	    {
+	      const std::complex<double>* q1 = &qlm[p1 * harmonics + Harmonics::index(6, 0)];
+	      const double norm1 = productSum(q1, q1, 6);
+	      size_t connections = 0;
+	      for (size_t n(neighbours.start[p1]); n < neighbours.start[p1 + 1]; ++n)
+		if (bonded[n])
+		  {
+		    const std::complex<double>* q2 = &qlm[neighbours.IDs[n] * harmonics + Harmonics::index(6, 0)];
+		    const double norm = std::sqrt(norm1 * productSum(q2, q2, 6));
+		    connections += norm && (productSum(q1, q2, 6) > bondThreshold * norm);
+		  }
+	      solid[p1] = (connections >= solidBonds);
+	    }
+	});
+    pool.wait();
+
+    //Join the bonded solid-like particles into clusters
+    std::vector<size_t> parent(N);
+    for (size_t p(0); p < N; ++p)
+      parent[p] = p;
+
+    for (size_t p1(0); p1 < N; ++p1)
+      if (solid[p1])
+	for (size_t n(neighbours.start[p1]); n < neighbours.start[p1 + 1]; ++n)
+	  if (bonded[n] && solid[neighbours.IDs[n]])
+	    parent[findRoot(parent, p1)] = findRoot(parent, neighbours.IDs[n]);
+
+    std::vector<size_t> size(N, 0);
+    for (size_t p(0); p < N; ++p)
+      if (solid[p])
+	++size[findRoot(parent, p)];
+
+    size_t largest = 0;
+    for (size_t p(0); p < N; ++p)
+      {
+	if (size[p])
+	  {
+	    ++clusterSizes[size[p]];
+	    largest = std::max(largest, size[p]);
+	  }
+
+	if (solid[p])
+	  local[p].cluster = size[findRoot(parent, p)];
+
+	if (local[p].bonds)
+	  {
+	    q4Sum += local[p].q4;
+	    q6Sum += local[p].q6;
+	    W6Sum += local[p].W6;
+	    ++bondedCount;
+	  }
+      }
+
+    ++samples;
+    solidCount += std::count(solid.begin(), solid.end(), true);
+    largestClusterSum += largest;
+
+    //Add the bonds to the global harmonics, those with m < 0 are
+    //given by symmetry
+    for (size_t task(0); task < tasks; ++task)
+      {
+	count += taskBonds[task];
+	for (size_t l(0); l < maxl; ++l)
+	  for (size_t m(0); m <= l; ++m)
+	    {
+	      const std::complex<double> val = taskSums[task][Harmonics::index(l, m)];
+	      globalcoeff[l][l + m] += val;
+	      if (m) globalcoeff[l][l - m] += (m % 2) ? -std::conj(val) : std::conj(val);
+	    }
       }
   }
 
+  double
+  OPSHCrystal::getQ(size_t l) const
+  {
+    double Qsum(0);
+    for (int m(-int(l)); m <= int(l); ++m)
+      Qsum += std::norm(globalcoeff[l][m+l] / std::complex<double>(count, 0));
+    return std::sqrt(Qsum * 4.0 * M_PI / (2.0 * l + 1.0));
+  }
+
   void 
   OPSHCrystal::output(magnet::xml::XmlStream& XML)
   {
@@ -119,7 +348,7 @@ namespace dynamo {
 	  Qsum += std::norm(globalcoeff[l][m+l] / std::complex<double>(count, 0));
       
 	XML << magnet::xml::attr("val")
-	    << std::sqrt(Qsum * 4.0 * M_PI / (2.0 * l + 1.0))
+	    << getQ(l)
 	    << magnet::xml::endtag("Q");
       
 	XML << magnet::xml::tag("W")
@@ -144,57 +373,30 @@ namespace dynamo {
 	    << magnet::xml::endtag("W");
       }
 
-    XML << magnet::xml::endtag("SHCrystal");
-  }
+    XML << magnet::xml::tag("LocalOrder")
+	<< magnet::xml::attr("Samples") << samples
+	<< magnet::xml::attr("q4") << q4Sum / bondedCount
+	<< magnet::xml::attr("q6") << q6Sum / bondedCount
+	<< magnet::xml::attr("W6") << W6Sum / bondedCount
+	<< magnet::xml::attr("SolidFraction") << double(solidCount) / (samples * Sim->N())
+	<< magnet::xml::attr("MeanLargestCluster") << double(largestClusterSum) / samples;
 
-  OPSHCrystal::sphericalsum::sphericalsum
-  (const dynamo::Simulation * const nSim, const double& nrg, const size_t& nl):
-    Sim(nSim), rg(nrg), maxl(nl), count(0)
-  {
-    coeffsum.resize(maxl);
-    for (size_t l=0; l < maxl; ++l)
-      coeffsum[l].resize(2*l+1,std::complex<double>(0,0));
-  }
+    XML << magnet::xml::tag("ClusterSizes")
+	<< magnet::xml::chardata();
+    for (const std::pair<const size_t, size_t>& entry : clusterSizes)
+      XML << entry.first << " " << double(entry.second) / samples << "\n";
+    XML << magnet::xml::endtag("ClusterSizes");
 
-  void 
-  OPSHCrystal::sphericalsum::operator()
-    (const Particle& part, const size_t& ID) const
-  {
-    if (part.getID() == ID) return;
-    Vector rij = part.getPosition() - Sim->particles[ID].getPosition();
-    Sim->BCs->applyBC(rij);
-  
-    double norm = rij.nrm();
-    if (norm <= rg)
+    if (perParticle)
       {
-	++count;
-	rij /= norm;
-	double theta = std::acos(rij[0]);
-	double sintheta = std::sin(theta);
-	double phi = rij[1] / sintheta;
-      
-	if (fabs(phi) > 1.0)
-	  phi = (phi > 0) ? 0.5 * M_PI : 1.5 * M_PI;
-	else
-	  phi = std::asin(phi);
-
-	if (std::sin(theta) == 0) phi = 0;
-      
-	if (phi < 0) phi += 2.0 * M_PI;
-
-	for (size_t l(0); l < maxl; ++l)
-	  for (int m(-l); m <= static_cast<int>(l); ++m)
-	    coeffsum[l][m+l] += boost::math::spherical_harmonic(l,m,theta,phi);
+	XML << magnet::xml::tag("Particles")
+	    << magnet::xml::chardata();
+	for (const LocalOrder& order : local)
+	  XML << order.q4 << " " << order.q6 << " " << order.W6 << " " << order.cluster << "\n";
+	XML << magnet::xml::endtag("Particles");
       }
-  }
-
-  void
-  OPSHCrystal::sphericalsum::clear()
-  {
-    count = 0;
 
-    for (size_t l(0); l < maxl; ++l)
-      for (int m(-l); m <= static_cast<int>(l); ++m)
-	coeffsum[l][m+l] = std::complex<double>(0,0);
+    XML << magnet::xml::endtag("LocalOrder")
+	<< magnet::xml::endtag("SHCrystal");
   }
 }
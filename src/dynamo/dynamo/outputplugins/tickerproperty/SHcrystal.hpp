@@ -19,9 +19,39 @@
 #include <dynamo/outputplugins/tickerproperty/ticker.hpp>
 #include <vector>
 #include <complex>
+#include <map>
 
 namespace dynamo {
-  class Particle;
+  class BoundaryCondition;
+
+  /*! \brief Spherical harmonic bond order parameters.
+
+    Every pair of particles closer than the cut-off radius is a
+    bond. The global \f$Q_l\f$ and \f$W_l\f$ of Steinhardt, Nelson
+    and Ronchetti (Phys. Rev. B 28, 784, 1983) average the spherical
+    harmonics of every bond over every tick.
+
+    The local order of each particle is calculated from the average
+    harmonics of its own bonds, \f$q_{lm}(i)\f$, giving the local
+    \f$q_4\f$, \f$q_6\f$ and \f$W_6\f$. As in ten Wolde, Ruiz-Montero
+    and Frenkel (J. Chem. Phys. 104, 9932, 1996), two bonded
+    particles are connected if the normalised product of their
+    \f$q_{6m}\f$ exceeds a threshold, a particle with enough
+    connections is solid-like, and bonded solid-like particles form
+    clusters.
+
+    The particles are processed in parallel, and the plugin may be
+    run in the background (see OPTicker::snapshotNeeds()). The
+    options are:
+    - CutOffR: The bond length (default 1.2).
+    - MaxL: The number of degrees of the global parameters (default 7).
+    - BondThreshold: The threshold of a connection (default 0.7).
+    - SolidBonds: The connections required for a particle to be
+      solid-like (default 7).
+    - PerParticle: If present, the local order of each particle at
+      the last tick is output.
+    - Background: If present, the plugin is run in the background.
+   */
   class OPSHCrystal: public OPTicker
   {
   public:
@@ -32,37 +62,70 @@ namespace dynamo {
     virtual void stream(double) {}
 
     virtual void ticker();
+
+    virtual SnapshotNeeds snapshotNeeds() const;
+
+    virtual std::function<void()> prepareTicker(const shared_ptr<const TickerSnapshot>&);
   
     virtual void output(magnet::xml::XmlStream&);
 
     virtual void operator<<(const magnet::xml::Node&);
 
+    //! \brief The local order of a particle.
+    struct LocalOrder
+    {
+      double q4;
+      double q6;
+      double W6;
+      //! \brief The number of bonds.
+      size_t bonds;
+      //! \brief The size of the cluster of a solid-like particle, otherwise zero.
+      size_t cluster;
+    };
+
+    //! \brief The local order of each particle at the last tick.
+    const std::vector<LocalOrder>& getLocalOrder() const { return local; }
+
+    //! \brief The global \f$Q_l\f$, averaged over all ticks.
+    double getQ(size_t l) const;
+
   protected:
+    /*! \brief The candidate neighbours of each particle (from the
+        neighbour list), stored as [start[ID], start[ID + 1]).
+     */
+    struct Neighbours
+    {
+      std::vector<size_t> start;
+      std::vector<size_t> IDs;
+    };
 
-    std::complex<double> localq(const Particle& part, int l, int m);
+    //! \brief Calculate the order parameters of a snapshot.
+    void sample(const TickerSnapshot&, const Neighbours&, const BoundaryCondition&);
 
     //! Cut-off radius 
     double rg;
     size_t maxl;
     size_t nblistID;
     long count;
+    double bondThreshold;
+    size_t solidBonds;
+    bool perParticle;
   
     std::vector<std::vector<std::complex<double> > > globalcoeff;
 
-    struct sphericalsum
-    {
-      sphericalsum(const dynamo::Simulation * const, 
-		   const double&, const size_t&);
-    
-      void operator()(const Particle&, const size_t&) const;
-    
-      void clear();
-
-      const dynamo::Simulation* const Sim;
-      const double rg;
-      const size_t maxl;
-      mutable size_t count;
-      mutable std::vector<std::vector<std::complex<double> > > coeffsum;
-    };
+    //! \brief The Wigner 3j symbols of \f$W_6\f$, as \f$(m_1, m_2, \text{coefficient})\f$.
+    std::vector<std::pair<std::pair<int, int>, double> > w6Coeffs;
+
+    std::vector<LocalOrder> local;
+    size_t samples;
+    //! \brief The sums of the local order of all bonded particles, over all ticks.
+    double q4Sum;
+    double q6Sum;
+    double W6Sum;
+    size_t bondedCount;
+    size_t solidCount;
+    size_t largestClusterSum;
+    //! \brief The number of clusters of each size, over all ticks.
+    std::map<size_t, size_t> clusterSizes;
   };
 }
@@ -26,6 +26,7 @@
 #include <dynamo/outputplugins/tickerproperty/radialdist.hpp>
 #include <dynamo/outputplugins/tickerproperty/velprof.hpp>
 #include <dynamo/outputplugins/tickerproperty/msdcorrelator.hpp>
+#include <dynamo/outputplugins/tickerproperty/msdmultipletau.hpp>
 #include <dynamo/outputplugins/tickerproperty/kenergyticker.hpp>
 #include <dynamo/outputplugins/tickerproperty/structureImage.hpp>
 #include <dynamo/outputplugins/tickerproperty/SHcrystal.hpp>
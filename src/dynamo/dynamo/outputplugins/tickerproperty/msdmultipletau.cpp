@@ -0,0 +1,214 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <dynamo/outputplugins/tickerproperty/msdmultipletau.hpp>
+#include <dynamo/include.hpp>
+#include <dynamo/simulation.hpp>
+#include <magnet/thread/threadpool.hpp>
+#include <magnet/xmlwriter.hpp>
+#include <magnet/xmlreader.hpp>
+#include <algorithm>
+
+namespace dynamo {
+  OPMSDMultipleTau::OPMSDMultipleTau(const dynamo::Simulation* tmp,
+				     const magnet::xml::Node& XML):
+    OPTicker(tmp,"MSDMultipleTau"),
+    _length(16),
+    _perSpecies(false),
+    _vacf(true)
+  {
+    operator<<(XML);
+  }
+
+  void
+  OPMSDMultipleTau::operator<<(const magnet::xml::Node& XML)
+  {
+    if (XML.hasAttribute("Length"))
+      _length = XML.getAttribute("Length").as<size_t>();
+
+    if (_length < 2)
+      M_throw() << "The MSDMultipleTau Length must be at least 2";
+
+    if (XML.hasAttribute("PerSpecies"))
+      _perSpecies = true;
+
+    if (XML.hasAttribute("NoVACF"))
+      _vacf = false;
+  }
+
+  void
+  OPMSDMultipleTau::initialise()
+  {
+    dout << "The multiple-tau correlator stores " << _length << " samples per level" << std::endl;
+
+    _levels.clear();
+    _group.assign(Sim->N(), 0);
+    _groupCount.assign(_perSpecies ? Sim->species.size() : 1, 0);
+
+    for (size_t sp(0); sp < Sim->species.size(); ++sp)
+      for (const size_t ID : *Sim->species[sp]->getRange())
+	{
+	  _group[ID] = _perSpecies ? sp : 0;
+	  ++_groupCount[_group[ID]];
+	}
+
+    addSample(0);
+  }
+
+  void
+  OPMSDMultipleTau::ticker()
+  {
+    addSample(0);
+
+    //Whenever a level has been filled with a new block of samples,
+    //the next level is sampled from it
+    for (size_t level(0); (level < _levels.size()) && !(_levels[level].samples % _length); ++level)
+      addSample(level + 1);
+  }
+
+  void
+  OPMSDMultipleTau::addSample(const size_t level)
+  {
+    const size_t N = Sim->N();
+    const size_t groups = _groupCount.size();
+
+    if (level == _levels.size())
+      {
+	_levels.push_back(Level());
+	Level& newLevel = _levels.back();
+	newLevel.positions.resize(N * _length);
+	if (_vacf) newLevel.velocities.resize(N * _length);
+	newLevel.samples = 0;
+	newLevel.msd.resize(groups * _length, 0.0);
+	newLevel.vacf.resize(groups * _length, 0.0);
+	newLevel.origins.resize(_length, 0);
+      }
+
+    Level& current = _levels[level];
+    const Level* source = level ? &_levels[level - 1] : NULL;
+    const size_t slot = current.samples % _length;
+    const size_t filled = std::min(current.samples + 1, _length);
+    const size_t sourceSlot = source ? (source->samples - 1) % _length : 0;
+
+    const size_t threads = samplingThreads(N);
+    const size_t tasks = std::max(size_t(1), threads);
+    std::vector<std::vector<double> > msdSums(tasks, std::vector<double>(groups * _length, 0.0));
+    std::vector<std::vector<double> > vacfSums(tasks, std::vector<double>(groups * _length, 0.0));
+
+    magnet::thread::ThreadPool pool;
+    pool.setThreadCount(threads);
+    for (size_t task(0); task < tasks; ++task)
+      pool.queueTask([&, task]() {
+	  std::vector<double>& msd = msdSums[task];
+	  std::vector<double>& vacf = vacfSums[task];
+	  for (size_t ID(task * N / tasks); ID < (task + 1) * N / tasks; ++ID)
+	    {
+	      const size_t offset = _group[ID] * _length;
+	      Vector* pos = &current.positions[ID * _length];
+	      pos[slot] = source ? source->positions[ID * _length + sourceSlot] : Sim->particles[ID].getPosition();
+
+	      for (size_t lag(0); lag < filled; ++lag)
+		msd[offset + lag] += (pos[slot] - pos[(slot + _length - lag) % _length]).nrm2();
+
+	      if (!_vacf) continue;
+
+	      Vector* vel = &current.velocities[ID * _length];
+	      if (source)
+		{
+		  //The source level holds exactly one block of samples
+		  Vector sum({0, 0, 0});
+		  for (size_t i(0); i < _length; ++i)
+		    sum += source->velocities[ID * _length + i];
+		  vel[slot] = sum / double(_length);
+		}
+	      else
+		vel[slot] = Sim->particles[ID].getVelocity();
+
+	      for (size_t lag(0); lag < filled; ++lag)
+		vacf[offset + lag] += vel[slot] | vel[(slot + _length - lag) % _length];
+	    }
+	});
+    pool.wait();
+
+    for (size_t task(0); task < tasks; ++task)
+      for (size_t i(0); i < groups * _length; ++i)
+	{
+	  current.msd[i] += msdSums[task][i];
+	  current.vacf[i] += vacfSums[task][i];
+	}
+
+    for (size_t lag(0); lag < filled; ++lag)
+      ++current.origins[lag];
+
+    ++current.samples;
+  }
+
+  std::vector<std::array<double, 3> >
+  OPMSDMultipleTau::getCorrelators(const size_t group) const
+  {
+    const double dt = getTickerTime();
+
+    //Each level after the first only adds the lags longer than those
+    //of the level below
+    std::vector<std::array<double, 3> > retval;
+    double blockLength = 1;
+    for (size_t level(0); level < _levels.size(); ++level, blockLength *= _length)
+      {
+	const Level& current = _levels[level];
+	for (size_t lag(level ? 1 : 0); lag < _length; ++lag)
+	  {
+	    if (!current.origins[lag]) continue;
+	    const double norm = double(current.origins[lag]) * double(_groupCount[group]);
+	    retval.push_back(std::array<double, 3>{{dt * lag * blockLength,
+		    current.msd[group * _length + lag] / norm,
+		    current.vacf[group * _length + lag] / norm}});
+	  }
+      }
+    return retval;
+  }
+
+  void
+  OPMSDMultipleTau::output(magnet::xml::XmlStream &XML)
+  {
+    XML << magnet::xml::tag("MSDMultipleTau")
+	<< magnet::xml::attr("Length") << _length
+	<< magnet::xml::attr("Levels") << _levels.size();
+
+    const std::string groupTag = _perSpecies ? "Species" : "Particles";
+    for (size_t group(0); group < _groupCount.size(); ++group)
+      {
+	if (!_groupCount[group]) continue;
+
+	XML << magnet::xml::tag(groupTag);
+	if (_perSpecies)
+	  XML << magnet::xml::attr("Name") << Sim->species[group]->getName();
+	XML << magnet::xml::chardata();
+
+	for (const std::array<double, 3>& row : getCorrelators(group))
+	  {
+	    XML << row[0] / Sim->units.unitTime() << " " << row[1] / Sim->units.unitArea();
+	    if (_vacf)
+	      XML << " " << row[2] / (Sim->units.unitVelocity() * Sim->units.unitVelocity());
+	    XML << "\n";
+	  }
+
+	XML << magnet::xml::endtag(groupTag);
+      }
+
+    XML << magnet::xml::endtag("MSDMultipleTau");
+  }
+}
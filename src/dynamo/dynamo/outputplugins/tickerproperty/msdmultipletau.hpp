@@ -0,0 +1,106 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <dynamo/outputplugins/tickerproperty/ticker.hpp>
+#include <magnet/math/vector.hpp>
+#include <array>
+#include <vector>
+
+namespace dynamo {
+  /*! \brief A multiple-tau correlator for the mean square
+      displacement and velocity autocorrelation function.
+
+    Unlike OPMSDCorrelator and OPVACF, which store a fixed length of
+    history for every particle, the samples are stored in a hierarchy
+    of levels. Level \f$k\f$ holds the last \f$p\f$ samples (where
+    \f$p\f$ is the Length option) taken every \f$p^k\f$ ticks, and a
+    new level is added whenever the previous one has been filled. The
+    memory is therefore \f$O(N\,p\log_p T)\f$ for a run of \f$T\f$
+    ticks, and the correlators cover many decades of lag time.
+
+    The positions stored at each level are the positions at the end
+    of each block, so the mean square displacement is exact at every
+    lag (only the number of time origins decreases with the lag). The
+    velocities stored are the block averages of the previous level,
+    as in the multiple-tau correlators of Ramirez et al. (J. Chem.
+    Phys. 133, 154103, 2010), so the VACF at long lags is smoothed
+    over the block length.
+
+    The options are:
+    - Length: The number of samples stored at each level (default 16).
+    - PerSpecies: If present, the correlators are collected separately
+      for each species.
+    - NoVACF: If present, the VACF is not collected, halving the memory.
+   */
+  class OPMSDMultipleTau: public OPTicker
+  {
+  public:
+    OPMSDMultipleTau(const dynamo::Simulation*, const magnet::xml::Node&);
+
+    virtual void initialise();
+
+    void output(magnet::xml::XmlStream &);
+
+    virtual void operator<<(const magnet::xml::Node&);
+
+    /*! \brief Returns the averaged correlators of a group (a species
+        if PerSpecies is set, otherwise zero for all particles).
+
+	Each entry holds the lag time, the mean square displacement
+	and the VACF, in simulation units.
+     */
+    std::vector<std::array<double, 3> > getCorrelators(const size_t group) const;
+
+  protected:
+    virtual void stream(double) {}
+    virtual void ticker();
+
+    /*! \brief The samples and accumulated correlations of a single
+        level of the correlator.
+     */
+    struct Level
+    {
+      //! \brief The sample history, stored as [ID * _length + slot].
+      std::vector<Vector> positions;
+      std::vector<Vector> velocities;
+      //! \brief The number of samples added to this level.
+      size_t samples;
+      //! \brief The correlations summed over the particles of each group, stored as [group * _length + lag].
+      std::vector<double> msd;
+      std::vector<double> vacf;
+      //! \brief The number of time origins sampled for each lag.
+      std::vector<size_t> origins;
+    };
+
+    /*! \brief Add a sample to a level and correlate it against the
+        stored history.
+
+	Level zero is sampled from the particles, higher levels are
+	sampled from the level beneath them.
+     */
+    void addSample(const size_t level);
+
+    std::vector<Level> _levels;
+    //! \brief The group (species or zero) of each particle.
+    std::vector<size_t> _group;
+    std::vector<size_t> _groupCount;
+    size_t _length;
+    bool _perSpecies;
+    bool _vacf;
+  };
+}
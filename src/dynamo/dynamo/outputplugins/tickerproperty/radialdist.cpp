@@ -18,8 +18,13 @@
 #include <dynamo/outputplugins/tickerproperty/radialdist.hpp>
 #include <dynamo/outputplugins/misc.hpp>
 #include <dynamo/include.hpp>
+#include <dynamo/BC/LEBC.hpp>
 #include <magnet/xmlwriter.hpp>
 #include <magnet/xmlreader.hpp>
+#include <magnet/thread/threadpool.hpp>
+#include <array>
+#include <cmath>
+#include <typeinfo>
 
 namespace dynamo {
   OPRadialDistribution::OPRadialDistribution(const dynamo::Simulation* tmp, 
@@ -64,6 +69,10 @@ namespace dynamo {
 	  if (XML.hasAttribute("SampleEnergyWidth"))
 	    sample_energy_bin_width = XML.getAttribute("SampleEnergyWidth").as<double>() * Sim->units.unitEnergy();
 	}
+
+      //Bin the pairs on the worker thread of the SysTicker
+      if (XML.hasAttribute("Background"))
+	background = true;
       
       dout << "BinWidth = " << binWidth / Sim->units.unitLength()
 	   << "\nLength = " << length << std::endl;
@@ -83,11 +92,39 @@ namespace dynamo {
     if (!(Sim->getOutputPlugin<OPMisc>()))
       M_throw() << "Radial Distribution requires the Misc output plugin";
 
+    //The Lees-Edwards images depend on the current time, which the
+    //worker thread cannot read
+    if (background && std::dynamic_pointer_cast<BCLeesEdwards>(Sim->BCs))
+      M_throw() << "The RadialDistribution cannot be run in the background with Lees-Edwards boundary conditions";
+
+    //Every ordered pair of particles (including each particle with
+    //itself) is sampled, in the species of each particle. The species
+    //of particles without a species is set to the number of species.
+    sampledParticles.clear();
+    speciesOf.assign(Sim->N(), Sim->species.size());
+    for (const shared_ptr<Species>& sp : Sim->species)
+      for (const size_t& p : *sp->getRange())
+	{
+	  speciesOf[p] = sp->getID();
+	  sampledParticles.push_back(p);
+	}
+
     ticker();
   }
 
   void 
   OPRadialDistribution::ticker()
+  {
+    const std::function<void()> task = prepareTicker(takeSnapshot(Sim, false));
+    if (task) task();
+  }
+
+  OPTicker::SnapshotNeeds
+  OPRadialDistribution::snapshotNeeds() const
+  { return background ? PARTICLES : NO_SNAPSHOT; }
+
+  std::function<void()>
+  OPRadialDistribution::prepareTicker(const shared_ptr<const TickerSnapshot>& snapshot)
   {
     //A test to ensure we only sample at a target energy (if
     //specified)
@@ -95,7 +132,7 @@ namespace dynamo {
       {
 	if (std::abs(sample_energy - Sim->getOutputPlugin<OPMisc>()->getConfigurationalU())
 	    > sample_energy_bin_width * 0.5)
-	  return;
+	  return std::function<void()>();
 	else
 	  dout << "Sampling radial distribution as configurational energy is" 
 	       << Sim->getOutputPlugin<OPMisc>()->getConfigurationalU()
@@ -108,17 +145,148 @@ namespace dynamo {
       }
     
     ++sampleCount;
-  
-    for (const shared_ptr<Species>& sp1 : Sim->species)
-      for (const shared_ptr<Species>& sp2 : Sim->species)
-	for (const size_t& p1 : *sp1->getRange())
-	  for (const size_t& p2 : *sp2->getRange())
+
+    //The binning only reads the snapshot and these copies
+    const Vector cellSize = Sim->primaryCellSize;
+    const shared_ptr<const BoundaryCondition> BCs = Sim->BCs;
+    return [this, snapshot, cellSize, BCs]() { bin(*snapshot, cellSize, *BCs); };
+  }
+
+  void
+  OPRadialDistribution::bin(const TickerSnapshot& snapshot, const Vector& cellSize, const BoundaryCondition& BCs)
+  {
+    const size_t NSpecies = data.size();
+
+    //Pairs are only binned if they are closer than this
+    const double maxDistance = (length - 0.5) * binWidth;
+
+    //A cell list is only used for plain periodic boundary conditions
+    //and if there are at least three cells in each dimension (so
+    //that the neighbouring cells are distinct and only the minimum
+    //image of each pair is found).
+    std::array<size_t, NDIM> cellCount;
+    bool useCells = (typeid(BCs) == typeid(BCPeriodic));
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	//The cells may be larger than maxDistance, this limits the
+	//number of cells for very short distributions
+	cellCount[iDim] = std::min(static_cast<size_t>(cellSize[iDim] / maxDistance),
+				   std::max(size_t(3), 1 + static_cast<size_t>(std::cbrt(sampledParticles.size()))));
+	useCells &= (cellCount[iDim] >= 3);
+      }
+
+    //The offsets to the 3^NDIM neighbouring cells (including the cell itself)
+    std::vector<std::array<int, NDIM> > neighbourOffsets(1, std::array<int, NDIM>());
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      {
+	std::vector<std::array<int, NDIM> > next;
+	for (std::array<int, NDIM> offset : neighbourOffsets)
+	  for (int o(-1); o <= 1; ++o)
+	    {
+	      offset[iDim] = o;
+	      next.push_back(offset);
+	    }
+	std::swap(next, neighbourOffsets);
+      }
+
+    std::vector<size_t> cellStart, cellParticles;
+    if (useCells)
+      {
+	size_t totalCells = 1;
+	for (size_t iDim(0); iDim < NDIM; ++iDim)
+	  totalCells *= cellCount[iDim];
+
+	//Sort the particles into the cells (a counting sort)
+	std::vector<size_t> particleCell(sampledParticles.size());
+	cellStart.assign(totalCells + 1, 0);
+	for (size_t i(0); i < sampledParticles.size(); ++i)
+	  {
+	    Vector pos = snapshot.positions[sampledParticles[i]];
+	    size_t cell = 0;
+	    for (size_t iDim(NDIM); iDim-- > 0;)
+	      {
+		const double L = cellSize[iDim];
+		const double x = std::remainder(pos[iDim], L) / L + 0.5;
+		const size_t c = std::min(cellCount[iDim] - 1, static_cast<size_t>(std::max(0.0, x * cellCount[iDim])));
+		cell = cell * cellCount[iDim] + c;
+	      }
+	    particleCell[i] = cell;
+	    ++cellStart[cell + 1];
+	  }
+
+	for (size_t cell(0); cell < totalCells; ++cell)
+	  cellStart[cell + 1] += cellStart[cell];
+
+	cellParticles.resize(sampledParticles.size());
+	std::vector<size_t> fill(cellStart.begin(), cellStart.end() - 1);
+	for (size_t i(0); i < sampledParticles.size(); ++i)
+	  cellParticles[fill[particleCell[i]]++] = sampledParticles[i];
+      }
+
+    //Each task bins into its own histogram, these are summed at the end
+    const size_t threads = samplingThreads(sampledParticles.size());
+    const size_t tasks = std::max(size_t(1), threads);
+    const size_t histSize = NSpecies * NSpecies * length;
+    std::vector<std::vector<unsigned long> > histograms(tasks, std::vector<unsigned long>(histSize, 0));
+
+    const auto binPair = [&](std::vector<unsigned long>& hist, const size_t p1, const size_t p2, const Vector& rij) {
+      const size_t i = static_cast<size_t>(rij.nrm() / binWidth + 0.5);
+      if (i < length) ++hist[(speciesOf[p1] * NSpecies + speciesOf[p2]) * length + i];
+    };
+
+    magnet::thread::ThreadPool pool;
+    pool.setThreadCount(threads);
+    for (size_t task(0); task < tasks; ++task)
+      pool.queueTask([&, task]() {
+	  std::vector<unsigned long>& hist = histograms[task];
+	  if (useCells)
 	    {
-	      Vector  rij = Sim->particles[p1].getPosition() - Sim->particles[p2].getPosition();
-	      Sim->BCs->applyBC(rij);
-	      const size_t i = static_cast<size_t>(rij.nrm() / binWidth + 0.5);
-	      if (i < length) ++data[sp1->getID()][sp2->getID()][i];
+	      const size_t totalCells = cellStart.size() - 1;
+	      for (size_t cell(task * totalCells / tasks); cell < (task + 1) * totalCells / tasks; ++cell)
+		{
+		  std::array<size_t, NDIM> coords;
+		  for (size_t iDim(0), c(cell); iDim < NDIM; c /= cellCount[iDim], ++iDim)
+		    coords[iDim] = c % cellCount[iDim];
+
+		  for (const std::array<int, NDIM>& offset : neighbourOffsets)
+		    {
+		      size_t other = 0;
+		      for (size_t iDim(NDIM); iDim-- > 0;)
+			other = other * cellCount[iDim] + (coords[iDim] + cellCount[iDim] + offset[iDim]) % cellCount[iDim];
+
+		      for (size_t i(cellStart[cell]); i < cellStart[cell + 1]; ++i)
+			{
+			  const size_t p1 = cellParticles[i];
+			  const Vector& pos1 = snapshot.positions[p1];
+			  for (size_t j(cellStart[other]); j < cellStart[other + 1]; ++j)
+			    {
+			      const size_t p2 = cellParticles[j];
+			      Vector rij = pos1 - snapshot.positions[p2];
+			      for (size_t iDim(0); iDim < NDIM; ++iDim)
+				rij[iDim] = std::remainder(rij[iDim], cellSize[iDim]);
+			      binPair(hist, p1, p2, rij);
+			    }
+			}
+		    }
+		}
 	    }
+	  else
+	    for (size_t i(task * sampledParticles.size() / tasks); i < (task + 1) * sampledParticles.size() / tasks; ++i)
+	      for (const size_t p2 : sampledParticles)
+		{
+		  const size_t p1 = sampledParticles[i];
+		  Vector rij = snapshot.positions[p1] - snapshot.positions[p2];
+		  BCs.applyBC(rij);
+		  binPair(hist, p1, p2, rij);
+		}
+	});
+    pool.wait();
+
+    for (const std::vector<unsigned long>& hist : histograms)
+      for (size_t s1(0); s1 < NSpecies; ++s1)
+	for (size_t s2(0); s2 < NSpecies; ++s2)
+	  for (size_t i(0); i < length; ++i)
+	    data[s1][s2][i] += hist[(s1 * NSpecies + s2) * length + i];
   }
 
   std::vector<std::pair<double, double> > 
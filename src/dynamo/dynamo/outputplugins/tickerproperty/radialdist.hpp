@@ -22,6 +22,8 @@
 #include <vector>
 
 namespace dynamo {
+  class BoundaryCondition;
+
   class OPRadialDistribution: public OPTicker
   {
   public:
@@ -33,6 +35,10 @@ namespace dynamo {
     virtual void stream(double) {}
 
     virtual void ticker();
+
+    virtual SnapshotNeeds snapshotNeeds() const;
+
+    virtual std::function<void()> prepareTicker(const shared_ptr<const TickerSnapshot>&);
   
     virtual void output(magnet::xml::XmlStream&);
 
@@ -41,11 +47,17 @@ namespace dynamo {
     std::vector<std::pair<double, double> > getgrdata(size_t species1ID, size_t species2ID) const;
     double getBinWidth() const { return binWidth; }
   protected:
+    //! \brief Bin every pair of particles in a snapshot.
+    void bin(const TickerSnapshot&, const Vector& cellSize, const BoundaryCondition&);
+
     double binWidth;
     size_t length;
     unsigned long sampleCount;
     double sample_energy; 
     double sample_energy_bin_width;
     std::vector<std::vector<std::vector<unsigned long> > > data;
+    //! \brief The particles which have a species, and the species of every particle.
+    std::vector<size_t> sampledParticles;
+    std::vector<size_t> speciesOf;
   };
 }
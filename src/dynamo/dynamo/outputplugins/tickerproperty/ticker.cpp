@@ -19,10 +19,14 @@
 #include <dynamo/outputplugins/tickerproperty/ticker.hpp>
 #include <dynamo/include.hpp>
 #include <dynamo/systems/sysTicker.hpp>
+#include <dynamo/schedulers/scheduler.hpp>
+#include <dynamo/ranges/IDRange.hpp>
+#include <thread>
 
 namespace dynamo {
   OPTicker::OPTicker(const dynamo::Simulation* t1,const char *t2):
-    OutputPlugin(t1,t2)
+    OutputPlugin(t1,t2),
+    background(false)
   {}
 
   double 
@@ -35,4 +39,37 @@ namespace dynamo {
 	M_throw() << "Could not upcast the SystemTicker system event to SysTicker, have you named a system as SystemTicker?";
       }
   }
+
+  shared_ptr<TickerSnapshot>
+  OPTicker::takeSnapshot(const dynamo::Simulation* Sim, bool neighbours)
+  {
+    shared_ptr<TickerSnapshot> snapshot(new TickerSnapshot);
+    snapshot->positions.reserve(Sim->N());
+    snapshot->velocities.reserve(Sim->N());
+    for (const Particle& part : Sim->particles)
+      {
+	snapshot->positions.push_back(part.getPosition());
+	snapshot->velocities.push_back(part.getVelocity());
+      }
+
+    if (neighbours)
+      {
+	snapshot->neighbours.resize(Sim->N());
+	for (const Particle& part : Sim->particles)
+	  {
+	    std::unique_ptr<IDRange> ids(Sim->ptrScheduler->getParticleNeighbours(part));
+	    for (const size_t& id : *ids)
+	      snapshot->neighbours[part.getID()].push_back(id);
+	  }
+      }
+
+    return snapshot;
+  }
+
+  size_t
+  OPTicker::samplingThreads(const size_t N)
+  {
+    const size_t threads = std::thread::hardware_concurrency();
+    return ((threads > 1) && (N > 1000)) ? threads : 0;
+  }
 }
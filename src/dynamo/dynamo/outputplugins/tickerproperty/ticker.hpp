@@ -17,8 +17,26 @@
 
 #pragma once
 #include <dynamo/outputplugins/outputplugin.hpp>
+#include <magnet/math/vector.hpp>
+#include <functional>
+#include <vector>
 
 namespace dynamo {
+  /*! \brief A copy of the particle state at a tick, which is
+      processed by background tickers while the simulation continues.
+   */
+  struct TickerSnapshot
+  {
+    //! \brief The positions and velocities of the particles, indexed by ID.
+    std::vector<Vector> positions;
+    std::vector<Vector> velocities;
+    /*! \brief The neighbours of each particle (see
+        Scheduler::getParticleNeighbours), only collected if a
+        background ticker requires them.
+     */
+    std::vector<std::vector<size_t> > neighbours;
+  };
+
   /*! \brief An output plugin marker class for periodically 'ticked'
    * plugins, ticked by the SysTicker class.
    *
@@ -37,6 +55,36 @@ namespace dynamo {
     virtual void output(magnet::xml::XmlStream&) {}
 
     virtual void ticker() = 0;
+
+    //! \brief The state a ticker requires in a TickerSnapshot.
+    enum SnapshotNeeds { NO_SNAPSHOT, PARTICLES, NEIGHBOURS };
+
+    /*! \brief The state this ticker requires to be run in the
+        background.
+
+	If this is NO_SNAPSHOT (the default), ticker() is called
+	synchronously by the SysTicker. Otherwise prepareTicker() is
+	called with a snapshot of the state, and the work it returns is
+	queued on the worker thread of the SysTicker.
+     */
+    virtual SnapshotNeeds snapshotNeeds() const { return NO_SNAPSHOT; }
+
+    /*! \brief Prepare a tick from a snapshot of the particles.
+
+	Anything else read from the simulation must be read (or
+	copied) here. The returned function completes the tick on the
+	worker thread, while the simulation continues, so it must only
+	access the snapshot, the values it captures and the data of
+	this plugin. An empty function may be returned if there is no
+	work to do for this tick.
+     */
+    virtual std::function<void()> prepareTicker(const shared_ptr<const TickerSnapshot>&)
+    { M_throw() << "This ticker cannot be run in the background"; }
+
+    /*! \brief Copy the current state of the particles (the
+        particles must have been updated to the current time).
+     */
+    static shared_ptr<TickerSnapshot> takeSnapshot(const dynamo::Simulation*, bool neighbours);
   
     virtual void periodicOutput() {}
 
@@ -46,5 +94,16 @@ namespace dynamo {
   protected:
 
     double getTickerTime() const;
+
+    /*! \brief The number of worker threads to use when sampling N
+        particles in a tick, zero means the calling thread does all
+        the work.
+     */
+    static size_t samplingThreads(const size_t N);
+
+    /*! \brief If the plugin should be run in the background, set by
+        the Background option of the plugins which support it.
+     */
+    bool background;
   };
 }
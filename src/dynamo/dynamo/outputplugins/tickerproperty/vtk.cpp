@@ -19,15 +19,145 @@
 #include <dynamo/include.hpp>
 #include <dynamo/simulation.hpp>
 #include <dynamo/dynamics/dynamics.hpp>
+#include <magnet/thread/threadpool.hpp>
 #include <magnet/xmlwriter.hpp>
+#include <magnet/xmlreader.hpp>
+#ifdef DYNAMO_zlib_support
+# include <zlib.h>
+#endif
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 
 namespace dynamo {
+  namespace {
+    /*! \brief The appended data section of a VTK XML file.
+
+      Each array is converted to Float32 and stored as a UInt64 byte
+      count followed by the data. If compressed, the data is split
+      into blocks which are compressed independently (and in
+      parallel) with zlib, and the byte count is replaced by the
+      block count, the block size, the size of the last partial block
+      and the compressed size of each block.
+     */
+    class AppendedData
+    {
+    public:
+      AppendedData(bool compress, size_t threads): _compress(compress), _threads(threads) {}
+
+      //! \brief Add an array, returning its offset in the appended data.
+      size_t add(const std::vector<double>& values)
+      {
+	const size_t offset = _data.size();
+	const std::vector<float> data(values.begin(), values.end());
+	const char* bytes = reinterpret_cast<const char*>(data.data());
+	const uint64_t size = data.size() * sizeof(float);
+
+	if (!_compress)
+	  {
+	    append(size);
+	    _data.append(bytes, size);
+	    return offset;
+	  }
+
+#ifdef DYNAMO_zlib_support
+	const uint64_t blockSize = 32768;
+	const size_t blocks = (size + blockSize - 1) / blockSize;
+	std::vector<std::string> compressed(blocks);
+	std::vector<int> errors(blocks, Z_OK);
+
+	magnet::thread::ThreadPool pool;
+	pool.setThreadCount(std::min(blocks, _threads));
+	for (size_t i(0); i < blocks; ++i)
+	  pool.queueTask([&, i]() {
+	      const uLong length = std::min(blockSize, size - i * blockSize);
+	      uLongf destLength = compressBound(length);
+	      compressed[i].resize(destLength);
+	      errors[i] = compress2(reinterpret_cast<Bytef*>(&compressed[i][0]), &destLength,
+				    reinterpret_cast<const Bytef*>(bytes + i * blockSize), length, Z_DEFAULT_COMPRESSION);
+	      compressed[i].resize(destLength);
+	    });
+	pool.wait();
+
+	append(blocks);
+	append(blockSize);
+	append(size % blockSize);
+	for (size_t i(0); i < blocks; ++i)
+	  {
+	    if (errors[i] != Z_OK)
+	      M_throw() << "zlib compression failed (error=" << errors[i] << ")";
+	    append(compressed[i].size());
+	  }
+
+	for (const std::string& block : compressed)
+	  _data.append(block);
+#endif
+	return offset;
+      }
+
+      //! \brief Write the AppendedData element.
+      void write(magnet::xml::XmlStream& XML) const
+      {
+	XML << magnet::xml::tag("AppendedData")
+	    << magnet::xml::attr("encoding") << "raw"
+	    << magnet::xml::chardata()
+	    << "_";
+	XML.getUnderlyingStream().write(_data.data(), _data.size());
+	XML << "\n" << magnet::xml::endtag("AppendedData");
+      }
+
+    private:
+      void append(const uint64_t val)
+      { _data.append(reinterpret_cast<const char*>(&val), sizeof(val)); }
+
+      bool _compress;
+      size_t _threads;
+      std::string _data;
+    };
+
+    /*! \brief Write a Float32 DataArray element, either inline as
+        ASCII or (if appended is not NULL) into the appended data.
+     */
+    void dataArray(magnet::xml::XmlStream& XML, AppendedData* appended, const std::string& name,
+		   const size_t components, const std::vector<double>& values)
+    {
+      XML << magnet::xml::tag("DataArray")
+	  << magnet::xml::attr("type") << "Float32";
+
+      if (!name.empty())
+	XML << magnet::xml::attr("Name") << name;
+      
+      if (components > 1)
+	XML << magnet::xml::attr("NumberOfComponents") << components;
+
+      if (appended)
+	{
+	  XML << magnet::xml::attr("format") << "appended"
+	      << magnet::xml::attr("offset") << appended->add(values)
+	      << magnet::xml::endtag("DataArray");
+	  return;
+	}
+
+      XML << magnet::xml::attr("format") << "ascii"
+	  << magnet::xml::chardata();
+
+      for (size_t i(0); i < values.size(); ++i)
+	XML << values[i] << (((i + 1) % components) ? " " : "\n");
+
+      XML << magnet::xml::endtag("DataArray");
+    }
+  }
+
   OPVTK::OPVTK(const dynamo::Simulation* tmp, const magnet::xml::Node& XML):
     OPTicker(tmp,"VTK"),
     imageCount(0),
-    _fields(true)
+    _fields(true),
+    _cic(false),
+    _fieldInterval(1),
+    _fieldSamples(0),
+    _fieldCount(0),
+    _format(ASCII)
   {
     operator<<(XML);
   }
@@ -36,12 +166,39 @@ namespace dynamo {
   OPVTK::operator<<(const magnet::xml::Node& XML) {
     double minBinWidth = 1;
     if (XML.hasAttribute("MinBinWidth"))
-      minBinWidth = XML.getAttribute("MinBinWidth").as<size_t>();
+      minBinWidth = XML.getAttribute("MinBinWidth").as<double>();
     
     _binWidths = Vector{minBinWidth, minBinWidth, minBinWidth};
 
     if (XML.hasAttribute("NoFields"))
       _fields = false;
+
+    if (XML.hasAttribute("CIC"))
+      _cic = true;
+
+    if (XML.hasAttribute("FieldInterval"))
+      _fieldInterval = XML.getAttribute("FieldInterval").as<size_t>();
+
+    if (_fieldInterval == 0)
+      M_throw() << "The VTK FieldInterval must be at least 1";
+
+    if (XML.hasAttribute("Format"))
+      {
+	const std::string format = XML.getAttribute("Format");
+	if (format == "ascii")
+	  _format = ASCII;
+	else if (format == "binary")
+	  _format = BINARY;
+	else if (format == "zlib")
+	  {
+#ifndef DYNAMO_zlib_support
+	    M_throw() << "zlib compressed VTK output was not built in!";
+#endif
+	    _format = ZLIB;
+	  }
+	else
+	  M_throw() << "Unknown VTK Format \"" << format << "\", the options are ascii, binary or zlib";
+      }
   }
 
 
@@ -83,35 +240,58 @@ namespace dynamo {
 
   void 
   OPVTK::ticker()
+  {
+    writeParticles();
+
+    if (_fields)
+      {
+	sampleFields();
+	if (++_fieldSamples == _fieldInterval)
+	  writeFields();
+      }
+
+    ++imageCount;
+  }
+
+  void 
+  OPVTK::writeParticles()
   {
     using namespace magnet::xml;
+
+    std::unique_ptr<AppendedData> appended;
+    if (_format != ASCII)
+      appended.reset(new AppendedData(_format == ZLIB, samplingThreads(Sim->N())));
+
     XmlStream XML;
-    
     XML << prolog()
 	<< tag("VTKFile")
 	<< attr("type") << "UnstructuredGrid"
 	<< attr("version") << "0.1"
 	<< attr("byte_order") << "LittleEndian"
-	<< tag("UnstructuredGrid")
+	<< attr("header_type") << "UInt64";
+
+    if (_format == ZLIB)
+      XML << attr("compressor") << "vtkZLibDataCompressor";
+
+    XML << tag("UnstructuredGrid")
 	<< tag("Piece") 
 	<< attr("NumberOfPoints") << Sim->particles.size()
 	<< attr("NumberOfCells") << 0
-	<< tag("Points")
-	<< tag("DataArray")
-	<< attr("type") << "Float32"
-	<< attr("format") << "ascii"
-	<< attr("NumberOfComponents") << "3"
-	<< chardata();
-    
+	<< tag("Points");
+
+    std::vector<double> values;
+    values.reserve(NDIM * Sim->N());
     for (const Particle& part: Sim->particles) {
       Vector r = part.getPosition();
       Sim->BCs->applyBC(r);
       r = r / Sim->units.unitLength();
-      XML << r[0]  << " " << r[1] << " " << r[2] << "\n";
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	values.push_back(r[iDim]);
     }
+
+    dataArray(XML, appended.get(), "", NDIM, values);
       
-    XML << endtag("DataArray")
-	<< endtag("Points")
+    XML << endtag("Points")
 	<< tag("Cells") 
 
 	<< tag("DataArray")
@@ -138,159 +318,219 @@ namespace dynamo {
 	<< tag("PointData"); 
 
     //Velocity data    
-    XML << tag("DataArray")
-	<< attr("type") << "Float32"
-	<< attr("Name") << "Velocities"
-	<< attr("NumberOfComponents") << "3"
-	<< attr("format") << "ascii"
-	<< chardata();
-    
+    values.clear();
     for (const Particle& part: Sim->particles)
-      XML << part.getVelocity()[0] / Sim->units.unitVelocity() << " "
-	  << part.getVelocity()[1] / Sim->units.unitVelocity() << " "
-	  << part.getVelocity()[2] / Sim->units.unitVelocity() << "\n";
-    
-    XML << endtag("DataArray");
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	values.push_back(part.getVelocity()[iDim] / Sim->units.unitVelocity());
+
+    dataArray(XML, appended.get(), "Velocities", NDIM, values);
     
     XML << endtag("PointData")
 	<< endtag("Piece")
-	<< endtag("UnstructuredGrid")
-	<< endtag("VTKFile");
+	<< endtag("UnstructuredGrid");
+
+    if (appended)
+      appended->write(XML);
+
+    XML << endtag("VTKFile");
 
     std::ostringstream filename_oss;
     filename_oss << "particles_" << std::setw(5) << std::setfill('0') << imageCount << ".vtu";
     XML.write_file(filename_oss.str());
+  }
 
-    if (_fields) {
-      std::fill(_numberField.begin(), _numberField.end(), 0);
-      std::fill(_massField.begin(), _massField.end(), 0.0);
-      std::fill(_momentumField.begin(), _momentumField.end(), Vector{0,0,0});
-      std::fill(_kineticEnergyField.begin(), _kineticEnergyField.end(), 0.0);
-
-      for (const Particle& p : Sim->particles) {
-	Vector  position = p.getPosition(),
-	  velocity = p.getVelocity();
-	Sim->BCs->applyBC(position, velocity);
-	
-	size_t cellID(0);
-	size_t factor(1);
-	for (size_t iDim(0); iDim < NDIM; ++iDim)
-	  {
-	    cellID += factor * static_cast<size_t>((position[iDim] + 0.5 * Sim->primaryCellSize[iDim]) / _binWidths[iDim]);
-	    factor *= _binCounts[iDim];
-	  }
+  void 
+  OPVTK::sampleFields()
+  {
+    const size_t N = Sim->N();
+    const size_t threads = samplingThreads(N);
+    const size_t tasks = std::max(size_t(1), threads);
+
+    //The first pass finds the lowest grid point each particle
+    //deposits onto, the fractional distance past it (used by the CIC
+    //weights), and the values to deposit.
+    std::vector<std::array<size_t, NDIM> > gridPoint(N);
+    std::vector<Vector> fraction(N);
+    std::vector<Vector> momentum(N);
+    std::vector<double> mass(N), kineticEnergy(N);
+
+    magnet::thread::ThreadPool pool;
+    pool.setThreadCount(threads);
+    for (size_t task(0); task < tasks; ++task)
+      pool.queueTask([&, task]() {
+	  for (size_t p(task * N / tasks); p < (task + 1) * N / tasks; ++p)
+	    {
+	      const Particle& part = Sim->particles[p];
+	      Vector position = part.getPosition(),
+		velocity = part.getVelocity();
+	      Sim->BCs->applyBC(position, velocity);
+
+	      for (size_t iDim(0); iDim < NDIM; ++iDim)
+		{
+		  const double x = (position[iDim] + 0.5 * Sim->primaryCellSize[iDim]) / _binWidths[iDim];
+		  const double point = std::floor(x);
+		  fraction[p][iDim] = x - point;
+		  //Wrapping also catches particles sitting exactly on the upper face
+		  const long count = _binCounts[iDim];
+		  gridPoint[p][iDim] = ((static_cast<long>(point) % count) + count) % count;
+		}
+
+	      mass[p] = Sim->species(part)->getMass(p);
+	      momentum[p] = mass[p] * velocity;
+	      kineticEnergy[p] = mass[p] * velocity.nrm2() / 2;
+	    }
+	});
+    pool.wait();
+
+    //The second pass deposits onto the grid. Each task owns a slab of
+    //z planes and only deposits into those, so no two tasks write to
+    //the same grid point and the fields need no reduction.
+    const size_t planes = _binCounts[2];
+    const size_t depositTasks = std::min(tasks, planes);
+    for (size_t task(0); task < depositTasks; ++task)
+      pool.queueTask([&, task]() {
+	  const size_t zStart = task * planes / depositTasks, zEnd = (task + 1) * planes / depositTasks;
+	  auto deposit = [&](const size_t p, const size_t x, const size_t y, const size_t z, const double weight) {
+	    const size_t id = x + _binCounts[0] * (y + _binCounts[1] * z);
+	    _numberField[id] += weight;
+	    _massField[id] += weight * mass[p];
+	    _momentumField[id] += weight * momentum[p];
+	    _kineticEnergyField[id] += weight * kineticEnergy[p];
+	  };
+
+	  for (size_t p(0); p < N; ++p)
+	    {
+	      const std::array<size_t, NDIM>& point = gridPoint[p];
+	      if (!_cic)
+		{
+		  if ((point[2] >= zStart) && (point[2] < zEnd))
+		    deposit(p, point[0], point[1], point[2], 1);
+		  continue;
+		}
+
+	      //Cloud in cell: the mass is shared between the eight
+	      //surrounding grid points, wrapping periodically
+	      for (size_t k(0); k < 2; ++k)
+		{
+		  const size_t z = (point[2] + k) % planes;
+		  if ((z < zStart) || (z >= zEnd)) continue;
+		  const double wz = k ? fraction[p][2] : 1 - fraction[p][2];
+		  for (size_t j(0); j < 2; ++j)
+		    {
+		      const size_t y = (point[1] + j) % _binCounts[1];
+		      const double wy = wz * (j ? fraction[p][1] : 1 - fraction[p][1]);
+		      for (size_t i(0); i < 2; ++i)
+			deposit(p, (point[0] + i) % _binCounts[0], y, z,
+				wy * (i ? fraction[p][0] : 1 - fraction[p][0]));
+		    }
+		}
+	    }
+	});
+    pool.wait();
+  }
 
-	const double mass = Sim->species(p)->getMass(p.getID());
-	++_numberField[cellID];
-	_massField[cellID] += mass;
-	_momentumField[cellID] += mass * velocity;
-	_kineticEnergyField[cellID] += mass * velocity.nrm2() / 2;
-      }
+  void 
+  OPVTK::writeFields()
+  {
+    std::unique_ptr<AppendedData> appended;
+    if (_format != ASCII)
+      appended.reset(new AppendedData(_format == ZLIB, samplingThreads(Sim->N())));
       
-      XmlStream XML;
-      XML << magnet::xml::tag("VTKFile")
-	  << magnet::xml::attr("type") << "ImageData"
-	  << magnet::xml::attr("version") << "0.1"
-	  << magnet::xml::attr("byte_order") << "LittleEndian"
-	  << magnet::xml::attr("compressor") << "vtkZLibDataCompressor"
-	  << magnet::xml::tag("ImageData")
-	  << magnet::xml::attr("WholeExtent");
+    magnet::xml::XmlStream XML;
+    XML << magnet::xml::tag("VTKFile")
+	<< magnet::xml::attr("type") << "ImageData"
+	<< magnet::xml::attr("version") << "0.1"
+	<< magnet::xml::attr("byte_order") << "LittleEndian"
+	<< magnet::xml::attr("header_type") << "UInt64";
+
+    if (_format == ZLIB)
+      XML << magnet::xml::attr("compressor") << "vtkZLibDataCompressor";
+
+    XML << magnet::xml::tag("ImageData")
+	<< magnet::xml::attr("WholeExtent");
   
-      for (size_t iDim(0); iDim < NDIM; ++iDim)
-	XML << " " << "0 " << _binCounts[iDim] - 1;
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      XML << " " << "0 " << _binCounts[iDim] - 1;
    
-      XML << magnet::xml::attr("Origin");
+    XML << magnet::xml::attr("Origin");
 
-      for (size_t iDim(0); iDim < NDIM; ++iDim)
-	XML << (Sim->primaryCellSize[iDim] * (-0.5))
-	  / Sim->units.unitLength()
-	    << " ";
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      XML << (Sim->primaryCellSize[iDim] * (-0.5))
+	/ Sim->units.unitLength()
+	  << " ";
   
-      XML << magnet::xml::attr("Spacing");
+    XML << magnet::xml::attr("Spacing");
   
-      for (size_t iDim(0); iDim < NDIM; ++iDim)
-	XML << _binWidths[iDim] / Sim->units.unitLength() << " ";
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      XML << _binWidths[iDim] / Sim->units.unitLength() << " ";
   
-      XML << magnet::xml::tag("Piece")
-	  << magnet::xml::attr("Extent");
+    XML << magnet::xml::tag("Piece")
+	<< magnet::xml::attr("Extent");
   
-      for (size_t iDim(0); iDim < NDIM; ++iDim)
-	XML << " " << "0 " << _binCounts[iDim] - 1;
-
-      double cellVol = 1;
-      for (size_t iDim(0); iDim < NDIM; ++iDim)
-	cellVol *= _binWidths[iDim];
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      XML << " " << "0 " << _binCounts[iDim] - 1;
+
+    //The densities are averaged over the samples taken since the
+    //last write
+    double cellVol = _fieldSamples;
+    for (size_t iDim(0); iDim < NDIM; ++iDim)
+      cellVol *= _binWidths[iDim];
       
-      XML << magnet::xml::tag("PointData");
+    XML << magnet::xml::tag("PointData");
 
-      ////////////Mass field
-      XML << magnet::xml::tag("DataArray")
-	  << magnet::xml::attr("type") << "Float32"
-	  << magnet::xml::attr("Name") << "Number density"
-	  << magnet::xml::attr("NumberOfComponents") << NDIM
-	  << magnet::xml::attr("format") << "ascii"
-	  << magnet::xml::chardata();
+    //The fields are converted into one buffer, which is reused
+    std::vector<double> values(NDIM * _numberField.size());
 
-      for (size_t id(0); id < _numberField.size(); ++id)
-	for (size_t iDim(0); iDim < NDIM; ++iDim)
-	  XML << _numberField[id] * Sim->units.unitVolume() / cellVol << " ";
+    ////////////Number field
+    for (size_t id(0); id < _numberField.size(); ++id)
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	values[NDIM * id + iDim] = _numberField[id] * Sim->units.unitVolume() / cellVol;
 
-      XML << "\n" << magnet::xml::endtag("DataArray");
+    dataArray(XML, appended.get(), "Number density", NDIM, values);
 
-      ////////////Mass field
-      XML << magnet::xml::tag("DataArray")
-	  << magnet::xml::attr("type") << "Float32"
-	  << magnet::xml::attr("Name") << "Mass density"
-	  << magnet::xml::attr("NumberOfComponents") << NDIM   
-	  << magnet::xml::attr("format") << "ascii"
-	  << magnet::xml::chardata();
+    ////////////Mass field
+    for (size_t id(0); id < _massField.size(); ++id)
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	values[NDIM * id + iDim] = _massField[id] * Sim->units.unitVolume() / (cellVol * Sim->units.unitMass());
 
-      for (size_t id(0); id < _massField.size(); ++id)
-	for (size_t iDim(0); iDim < NDIM; ++iDim)
-	  XML << _massField[id] * Sim->units.unitVolume() / (cellVol * Sim->units.unitMass()) << " ";
+    dataArray(XML, appended.get(), "Mass density", NDIM, values);
 
-      XML << "\n" << magnet::xml::endtag("DataArray");
+    ////////////Momentum field
+    for (size_t id(0); id < _momentumField.size(); ++id)
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	values[NDIM * id + iDim] = _momentumField[id][iDim]  * Sim->units.unitVolume() / (cellVol * Sim->units.unitMomentum());
 
-      ////////////Momentum field
-      XML << magnet::xml::tag("DataArray")
-	  << magnet::xml::attr("type") << "Float32"
-	  << magnet::xml::attr("Name") << "Momentum density"
-	  << magnet::xml::attr("NumberOfComponents") << NDIM   
-	  << magnet::xml::attr("format") << "ascii"
-	  << magnet::xml::chardata();
+    dataArray(XML, appended.get(), "Momentum density", NDIM, values);
 
-      for (size_t id(0); id < _momentumField.size(); ++id)
-	for (size_t iDim(0); iDim < NDIM; ++iDim)
-	  XML << _momentumField[id][iDim]  * Sim->units.unitVolume() / (cellVol * Sim->units.unitMomentum()) << " ";
+    ////////////Energy
+    values.resize(_kineticEnergyField.size());
+    for (size_t id(0); id < _kineticEnergyField.size(); ++id)
+      values[id] = 2 * _kineticEnergyField[id] / (NDIM * (_numberField[id] + (_numberField[id] == 0)) * Sim->units.unitEnergy());
 
-      XML << "\n" << magnet::xml::endtag("DataArray");
-  
+    dataArray(XML, appended.get(), "Temperature", 1, values);
 
-      ////////////Energy
-      XML << magnet::xml::tag("DataArray")
-	  << magnet::xml::attr("type") << "Float32"
-	  << magnet::xml::attr("Name") << "Temperature"
-	  << magnet::xml::attr("format") << "ascii"
-	  << magnet::xml::chardata();
+    ////////////Postamble
+    XML << magnet::xml::endtag("PointData")
+	<< magnet::xml::tag("CellData")
+	<< magnet::xml::endtag("CellData")
+	<< magnet::xml::endtag("Piece")
+	<< magnet::xml::endtag("ImageData");
 
-      for (size_t id(0); id < _kineticEnergyField.size(); ++id)
-	XML << 2 * _kineticEnergyField[id] / (NDIM * (_numberField[id] + (_numberField[id] == 1)) * Sim->units.unitEnergy()) << " ";
+    if (appended)
+      appended->write(XML);
 
-      XML << "\n" << magnet::xml::endtag("DataArray");
+    XML << magnet::xml::endtag("VTKFile");
 
-      ////////////Postamble
-      XML << magnet::xml::endtag("PointData")
-	  << magnet::xml::tag("CellData")
-	  << magnet::xml::endtag("CellData")
-	  << magnet::xml::endtag("Piece")
-	  << magnet::xml::endtag("ImageData")
-	  << magnet::xml::endtag("VTKFile");
+    std::ostringstream filename_oss;
+    filename_oss << "fields_" << std::setw(5) << std::setfill('0') << _fieldCount << ".vti";
+    XML.write_file(filename_oss.str());
 
-      std::ostringstream filename_oss;
-      filename_oss << "fields_" << std::setw(5) << std::setfill('0') << imageCount << ".vti";
-      XML.write_file(filename_oss.str());
-    }
-    ++imageCount;
+    std::fill(_numberField.begin(), _numberField.end(), 0.0);
+    std::fill(_massField.begin(), _massField.end(), 0.0);
+    std::fill(_momentumField.begin(), _momentumField.end(), Vector{0,0,0});
+    std::fill(_kineticEnergyField.begin(), _kineticEnergyField.end(), 0.0);
+    _fieldSamples = 0;
+    ++_fieldCount;
   }
 
   namespace {
@@ -327,6 +567,7 @@ namespace dynamo {
   {
     const double dt = getTickerTime();
     writePVDfile("particles", "vtu", imageCount, dt);
-    writePVDfile("fields", "vti", imageCount, dt);
+    if (_fields)
+      writePVDfile("fields", "vti", _fieldCount, dt * _fieldInterval);
   }
 }
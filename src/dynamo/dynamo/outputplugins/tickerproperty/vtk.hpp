@@ -18,9 +18,25 @@
 #pragma once
 #include <dynamo/outputplugins/tickerproperty/ticker.hpp>
 #include <magnet/math/vector.hpp>
+#include <array>
 #include <vector>
 
 namespace dynamo {
+  /*! \brief Writes the particles (and fields binned from them) as
+      VTK XML files, which may be loaded into ParaView.
+
+    The options are:
+    - MinBinWidth: The minimum width of the field bins.
+    - NoFields: If present, the fields are not written.
+    - CIC: If present, each particle is deposited onto the eight
+      nearest grid points with cloud-in-cell weights, instead of
+      onto the nearest grid point only.
+    - FieldInterval: The number of ticks the fields are averaged over
+      before they are written (the default is 1).
+    - Format: The encoding of the data arrays. Either "ascii" (the
+      default), "binary" for raw appended data, or "zlib" for zlib
+      compressed appended data.
+   */
   class OPVTK: public OPTicker
   {
   public:
@@ -37,15 +53,27 @@ namespace dynamo {
     virtual void output(magnet::xml::XmlStream&);
   
   protected:
+    void writeParticles();
+    void sampleFields();
+    void writeFields();
+
+
     Vector  _binWidths;
     std::array<size_t, 3>  _binCounts;
-    std::vector<size_t> _numberField;
+    std::vector<double> _numberField;
     std::vector<double> _massField;
     std::vector<Vector> _momentumField;
     std::vector<double> _kineticEnergyField;
     
     size_t imageCount;
     bool _fields;
+    bool _cic;
+    size_t _fieldInterval;
+    size_t _fieldSamples;
+    size_t _fieldCount;
+
+    enum Format { ASCII, BINARY, ZLIB };
+    Format _format;
     
   };
 }
@@ -20,6 +20,13 @@
 #include <fstream>
 
 namespace dynamo {
+  /*! \brief Writes a text description of every event to
+      trajectory.out.
+
+    This is very slow and produces large files, OPEventTape records
+    the same information in a compact binary form which dynatape can
+    convert to this format.
+   */
   class OPTrajectory: public OutputPlugin
   {
   public:
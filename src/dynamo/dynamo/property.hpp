@@ -112,6 +112,8 @@ namespace dynamo {
   
     //! Always returns a single value.
     inline virtual const double getProperty(size_t ID) const { return _val; }
+    //! Returns the value, without a virtual call.
+    inline double getValue() const { return _val; }
     //! Returns the value as a string.
     inline virtual std::string getName() const { return boost::lexical_cast<std::string>(_val); }
 
@@ -207,6 +209,12 @@ namespace dynamo {
 
     inline void outputParticleXMLData(magnet::xml::XmlStream& XML, const size_t pID) const
     { XML << magnet::xml::attr(_name) << getProperty(pID); }
+
+    //! \brief Direct access to the values of all particles.
+    inline std::vector<double>& getValues() { return _values; }
+
+    //! \brief Direct access to the values of all particles.
+    inline const std::vector<double>& getValues() const { return _values; }
   
   
   protected:
@@ -318,6 +326,13 @@ namespace dynamo {
       _namedProperties.push_back(property);
     }
 
+    //! Returns true if any per-particle properties are stored.
+    inline bool hasNamedProperties() const { return !_namedProperties.empty(); }
+
+    //! Iterators over the properties looked up by their name.
+    inline const_iterator begin() const { return _namedProperties.begin(); }
+    inline const_iterator end() const { return _namedProperties.end(); }
+
     inline friend magnet::xml::XmlStream& operator<<(magnet::xml::XmlStream& XML, const PropertyStore& propStore)
     {
       XML << magnet::xml::tag("Properties");
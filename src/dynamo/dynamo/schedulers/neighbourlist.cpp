@@ -24,7 +24,6 @@
 #include <dynamo/globals/cellsShearing.hpp>
 #include <dynamo/systems/nblistCompressionFix.hpp>
 #include <dynamo/locals/local.hpp>
-#include <dynamo/ranges/IDRangeRange.hpp>
 #include <dynamo/BC/include.hpp>
 #include <magnet/xmlreader.hpp>
 #include <cmath>
@@ -84,6 +83,7 @@ namespace dynamo {
 		<< Sim->getLongestInteraction() / Sim->units.unitLength();
 
     nblist->_sigNewNeighbour.connect<Scheduler, &Scheduler::addInteractionEvent>(this);
+    nblist->_sigNewLocalNeighbour.connect<Scheduler, &Scheduler::addLocalEvent>(this);
     nblist->_sigReInitialise.connect<SNeighbourList, &SNeighbourList::initialise>(this);
     Scheduler::initialise();
   }
@@ -154,6 +154,15 @@ namespace dynamo {
     
   std::unique_ptr<IDRange> 
   SNeighbourList::getParticleLocals(const Particle& part) const {
-    return std::unique_ptr<IDRange>(new IDRangeRange(0, Sim->locals.size() - 1));
+#ifdef DYNAMO_DEBUG
+    if (!std::dynamic_pointer_cast<GNeighbourList>(Sim->globals[NBListID]))
+      M_throw() << "Not a GNeighbourList!";
+#endif
+
+    //Only the Locals overlapping the particle's cell are tested
+    const GNeighbourList& nblist(*static_cast<const GNeighbourList*>(Sim->globals[NBListID].get()));
+    IDRangeList* range_ptr = new IDRangeList();
+    nblist.getLocalNeighbours(part, range_ptr->getContainer());
+    return std::unique_ptr<IDRange>(range_ptr);
   }
 }
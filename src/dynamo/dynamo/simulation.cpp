@@ -31,6 +31,8 @@
 #include <dynamo/globals/PBCSentinel.hpp>
 #include <boost/filesystem.hpp>
 #include <dynamo/BC/BC.hpp>
+#include <dynamo/checkpoint.hpp>
+#include <magnet/memUsage.hpp>
 #include <iomanip>
 #include <set>
 
@@ -77,6 +79,7 @@ namespace dynamo
     if (status != INITIALISED)
       M_throw() << "Cannot reinitialise an un-initialised simulation";
     status = START;
+    flushTickers();
     outputPlugins.clear();
     dynamics->updateAllParticles();
     systemTime = 0.0;
@@ -95,20 +98,8 @@ namespace dynamo
       ptr->initialise();
 
     dout << "Validating Species definitions" << std::endl;
-    unsigned int count = 0;
     //Now confirm that every species has only one species type!
-    for (const Particle& part : particles)
-      {
-	for (shared_ptr<Species>& ptr : species)
-	  if (ptr->isSpecies(part)) { count++; break; }
-	
-	if (count < 1)
-	  M_throw() << "Particle ID=" << part.getID() << " has no species";
-	
-	if (count > 1)
-	  M_throw() << "Particle ID=" << part.getID() << " has more than one species";
-	count = 0;
-      }
+    species.buildIndex(particles);
     
     //Now confirm that there are not more counts from each species
     //than there are particles
@@ -292,7 +283,7 @@ namespace dynamo
   }
 
   const shared_ptr<Species>& 
-  Simulation::SpeciesContainer::operator()(const Particle& p1) const 
+  Simulation::SpeciesContainer::search(const Particle& p1) const 
   {
     for (const shared_ptr<Species>& ptr : *this)
       if (ptr->isSpecies(p1)) return ptr;
@@ -301,11 +292,36 @@ namespace dynamo
 	      << p1.getID(); 
   }
 
+  void
+  Simulation::SpeciesContainer::buildIndex(const std::vector<Particle>& particles)
+  {
+    _index.clear();
+    std::vector<unsigned int> index(particles.size());
+    for (const Particle& part : particles)
+      {
+	size_t count = 0;
+	for (size_t i(0); i < size(); ++i)
+	  if ((*this)[i]->isSpecies(part))
+	    {
+	      index[part.getID()] = i;
+	      ++count;
+	    }
+	
+	if (count < 1)
+	  M_throw() << "Particle ID=" << part.getID() << " has no species";
+	
+	if (count > 1)
+	  M_throw() << "Particle ID=" << part.getID() << " has more than one species";
+      }
+    _index.swap(index);
+  }
+
   void Simulation::addSpecies(shared_ptr<Species> sp)
   {
     if (status >= INITIALISED)
       M_throw() << "Cannot add species after simulation initialisation";
     
+    species.clearIndex();
     species.push_back(sp);
   }
 
@@ -336,7 +352,17 @@ namespace dynamo
 		<< "\nPlease check the file exists.";
     dout << "Parsing the XML" << std::endl;
 
-    Document doc(fileName);
+    std::unique_ptr<Document> xmlDoc;
+    if (BinaryCheckpoint::isBinaryFile(fileName))
+      _checkpoint.reset(new BinaryCheckpoint(fileName));
+    else
+      xmlDoc.reset(new Document(fileName));
+    Document& doc = _checkpoint ? _checkpoint->getDocument() : *xmlDoc;
+
+    if (xmlDoc)
+      dout << "Parsed the XML in " << xmlDoc->getLoadTime() << "s"
+	   << (xmlDoc->isMapped() ? " (memory mapped)" : "")
+	   << ", peak memory usage " << magnet::process_mem_usage() / 1024 << "MB" << std::endl;
 
     dout << "Loading tags from the XML" << std::endl;
 
@@ -421,13 +447,21 @@ namespace dynamo
     _properties.rescaleUnit(Property::Units::M, units.unitMass());
 
     ensemble = dynamo::Ensemble::loadEnsemble(*this);
+
+    //Release the checkpoint (and its mapping of the file)
+    _checkpoint.reset();
   }
 
   void
   Simulation::writeXMLfile(std::string fileName, bool applyBC, bool round)
+  { prepareXMLfile(fileName, applyBC, round)(); }
+
+  std::function<void()>
+  Simulation::prepareXMLfile(std::string fileName, bool applyBC, bool round)
   {
     namespace xml = magnet::xml;
-    xml::XmlStream XML;
+    shared_ptr<xml::XmlStream> XMLptr(new xml::XmlStream);
+    xml::XmlStream& XML = *XMLptr;
     XML.setFormatXML(true);
 
     dynamics->updateAllParticles();
@@ -437,6 +471,8 @@ namespace dynamo
     _properties.rescaleUnit(Property::Units::T, 1.0 / units.unitTime());
     _properties.rescaleUnit(Property::Units::M, 1.0 / units.unitMass());
     
+    _checkpoint.reset(BinaryCheckpoint::isBinaryFile(fileName) ? new BinaryCheckpoint : NULL);
+
     XML << std::setprecision(std::numeric_limits<double>::digits10 + 2 - 4 * round)
 	<< xml::prolog()
 	<< xml::tag("DynamOconfig")
@@ -510,18 +546,38 @@ namespace dynamo
 	<< xml::endtag("Simulation")
 	<< _properties;
 
-    dynamics->outputParticleXMLData(XML, applyBC);
-
-    XML << xml::endtag("DynamOconfig");
-
-    dout << "Config written to " << fileName << std::endl;
+    //The binary checkpoint arrays are a cheap copy, so they are
+    //written immediately. Otherwise the particle data is copied
+    //and formatted later.
+    shared_ptr<Dynamics::ParticleXMLData> particleData;
+    if (_checkpoint)
+      dynamics->outputParticleXMLData(XML, applyBC);
+    else
+      particleData = dynamics->copyParticleXMLData(applyBC);
 
     //Rescale the properties back to the simulation units
     _properties.rescaleUnit(Property::Units::L, units.unitLength());
     _properties.rescaleUnit(Property::Units::T, units.unitTime());
     _properties.rescaleUnit(Property::Units::M, units.unitMass());
 
-    XML.write_file(fileName);
+    shared_ptr<BinaryCheckpoint> checkpoint;
+    std::swap(checkpoint, _checkpoint);
+
+    dout << "Config written to " << fileName << std::endl;
+
+    return [XMLptr, particleData, checkpoint, fileName]() {
+      if (checkpoint)
+	{
+	  *XMLptr << xml::endtag("DynamOconfig");
+	  checkpoint->write(fileName, XMLptr->str());
+	}
+      else
+	{
+	  Dynamics::outputParticleXMLData(*XMLptr, *particleData);
+	  *XMLptr << xml::endtag("DynamOconfig");
+	  XMLptr->write_file(fileName);
+	}
+    };
   }
   
   void 
@@ -720,17 +776,24 @@ namespace dynamo
 
   void
   Simulation::outputData(std::string filename)
+  { prepareOutputData(filename)(); }
+
+  std::function<void()>
+  Simulation::prepareOutputData(std::string filename)
   {
     if (status < INITIALISED)
       M_throw() << "Cannot output data when not initialised!";
 
     namespace xml = magnet::xml;
-    xml::XmlStream XML;
+    shared_ptr<xml::XmlStream> XMLptr(new xml::XmlStream);
+    xml::XmlStream& XML = *XMLptr;
     XML.setFormatXML(true);
     
     XML << std::setprecision(std::numeric_limits<double>::digits10 + 2)
 	<< xml::prolog() << xml::tag("OutputData");
   
+    flushTickers();
+
     //Output the data and delete the outputplugins
     for (shared_ptr<OutputPlugin> & Ptr : outputPlugins)
       Ptr->output(XML);
@@ -748,7 +811,7 @@ namespace dynamo
 
     dout << "Output written to " << filename << std::endl;
 
-    XML.write_file(filename);
+    return [XMLptr, filename]() { XMLptr->write_file(filename); };
   }
 
   void 
@@ -771,6 +834,14 @@ namespace dynamo
     ptr->setTickerPeriod(nP * ptr->getPeriod());
   }
 
+  void
+  Simulation::flushTickers()
+  {
+    for (shared_ptr<System>& ptr : systems)
+      if (std::dynamic_pointer_cast<SysTicker>(ptr))
+	static_cast<SysTicker&>(*ptr).flush();
+  }
+
   void 
   Simulation::addOutputPlugin(std::string Name)
   {
@@ -814,6 +885,11 @@ namespace dynamo
 		  << eventCount << "\n" << cep.what();
       }
 
-    return (eventCount < endEventCount);
+    if (eventCount < endEventCount)
+      return true;
+
+    //The run is over, so the results of the tickers may now be read
+    flushTickers();
+    return false;
   }
 }
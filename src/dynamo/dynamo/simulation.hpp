@@ -23,6 +23,7 @@
 #include <dynamo/property.hpp>
 #include <dynamo/units/units.hpp>
 #include <magnet/function/delegate.hpp>
+#include <functional>
 #include <random>
 #include <vector>
 
@@ -45,6 +46,7 @@ namespace dynamo
 
   class IDRange;
   class IDPairRange;
+  class BinaryCheckpoint;
 
 
   //! \brief Holds the different phases of the simulation initialisation
@@ -114,7 +116,35 @@ namespace dynamo
     */
     struct SpeciesContainer: public Container<Species>
     {
-      const shared_ptr<Species>& operator()(const Particle&) const;
+      /*! \brief Returns the Species of a particle.
+
+	Once the index has been built (see buildIndex) this is a
+	single array lookup, otherwise the Species are searched.
+       */
+      const shared_ptr<Species>& operator()(const Particle& p) const
+      {
+	const size_t ID = p.getID();
+	if (ID < _index.size())
+	  return Container<Species>::operator[](_index[ID]);
+	return search(p);
+      }
+
+      /*! \brief Build the per-particle Species index, checking
+	that every particle belongs to exactly one Species.
+
+	This must be called again if the particles or the ranges of
+	the Species are changed.
+       */
+      void buildIndex(const std::vector<Particle>& particles);
+
+      //! \brief Discard the per-particle Species index.
+      void clearIndex() { _index.clear(); }
+
+    private:
+      const shared_ptr<Species>& search(const Particle&) const;
+
+      //! \brief The position of each particle's Species in the container.
+      std::vector<unsigned int> _index;
     };
 
   public:
@@ -256,11 +286,22 @@ namespace dynamo
     */
     void outputData(std::string filename);
 
+    /*! \brief Serialises the results of the Simulation, but defers
+        writing them to the passed path.
+
+      \return A function which writes the file. This only accesses
+      data owned by the function, so it may be called on a background
+      thread while the Simulation continues.
+      \sa outputData
+    */
+    std::function<void()> prepareOutputData(std::string filename);
+
     /*! \brief Loads a Simulation from the passed XML file.
 
       \param filename The path to the XML file to load. The filename
       must end in either ".xml" (or ".xml.bz2" where bzip2 compressed
-      configuration files are supported).
+      configuration files are supported), or ".bin" for a
+      BinaryCheckpoint.
     */
     void loadXMLfile(std::string filename);
     
@@ -269,7 +310,8 @@ namespace dynamo
       \param filename The path to the XML file to write (this file
       will either be created or overwritten). The filename
       must end in either ".xml" (or ".xml.bz2" where bzip2 compressed
-      configuration files are supported).
+      configuration files are supported), or ".bin" to write a
+      BinaryCheckpoint.
 
       \param round If true, the data in the XML file will be written
       out at 2 s.f. lower precision to round all the values. This is
@@ -278,6 +320,21 @@ namespace dynamo
     */
     void writeXMLfile(std::string filename, bool applyBC = true, bool round = false);
 
+    /*! \brief Takes a copy of the Simulation configuration, but
+        defers serialising and writing it to the passed path.
+
+      All of the configuration except the particle data is serialised
+      immediately. The particle data is copied and is formatted when
+      the returned function is called. The output is identical to
+      writeXMLfile.
+
+      \return A function which formats and writes the file. This only
+      accesses data owned by the function, so it may be called on a
+      background thread while the Simulation continues.
+      \sa writeXMLfile
+    */
+    std::function<void()> prepareXMLfile(std::string filename, bool applyBC = true, bool round = false);
+
     /*! \brief The Ensemble of the Simulation. */
     shared_ptr<Ensemble> ensemble;
 
@@ -322,6 +379,14 @@ namespace dynamo
     //! Scales the frequency of the SysTicker event by the passed factor.
     void scaleTickerPeriod(double);
 
+    /*! \brief Complete the work of any ticker plugins running in the
+        background (see SysTicker::flush()).
+
+	This is called before the plugins are output, reset, or at
+	the end of a run.
+     */
+    void flushTickers();
+
 
     /*! \brief The current system time of the simulation. 
       
@@ -355,6 +420,15 @@ namespace dynamo
     /*! The property store, a list of properties the particles have. */
     PropertyStore _properties;
 
+    /*! \brief The BinaryCheckpoint being loaded or written.
+
+      This is only set inside loadXMLfile and writeXMLfile when the
+      binary format is used. Classes holding bulk per-particle data
+      (e.g., the particle data and capture maps) store it in the
+      arrays of the checkpoint instead of the XML when it is set.
+     */
+    shared_ptr<BinaryCheckpoint> _checkpoint;
+
     /*! \brief The size of the primary image/cell of the simulation. */
     Vector  primaryCellSize;
 
@@ -30,7 +30,7 @@ namespace dynamo {
   SpPoint::operator<<(const magnet::xml::Node& XML)
   {
     range = shared_ptr<IDRange>(IDRange::getClass(XML.getNode("IDRange"), Sim));
-    _mass = Sim->_properties.getProperty(XML.getAttribute("Mass"), Property::Units::Mass());
+    setMass(Sim->_properties.getProperty(XML.getAttribute("Mass"), Property::Units::Mass()));
     spName = XML.getAttribute("Name");
   }
 
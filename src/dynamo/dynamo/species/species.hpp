@@ -36,7 +36,13 @@ namespace dynamo {
     virtual ~Species();
 
     inline bool isSpecies(const Particle& p1) const { return range->isInRange(p1); }  
-    inline const double getMass(size_t ID) const { return _mass->getProperty(ID); }
+    /*! \brief Returns the mass of a particle.
+
+      Species with a single (numeric) mass avoid the virtual Property
+      lookup.
+     */
+    inline const double getMass(size_t ID) const 
+    { return _constMass ? _constMass->getValue() : _mass->getProperty(ID); }
     inline unsigned long getCount() const { return range->size(); }
     inline unsigned int getID() const { return ID; }
     inline const std::string& getName() const { return spName; }
@@ -59,15 +65,23 @@ namespace dynamo {
     template<class T1>
     Species(dynamo::Simulation* tmp, std::string name, IDRange* nr, T1 mass, std::string nName, unsigned int nID):
       SimBase(tmp, name),
-      _mass(Sim->_properties.getProperty(mass, Property::Units::Mass())),
       range(nr),
       spName(nName),
       ID(nID)
-    {}
+    { setMass(Sim->_properties.getProperty(mass, Property::Units::Mass())); }
+
+    //! \brief Set the mass Property of the Species.
+    void setMass(shared_ptr<Property> mass)
+    {
+      _mass = mass;
+      _constMass = dynamic_cast<const NumericProperty*>(_mass.get());
+    }
 
     virtual void outputXML(magnet::xml::XmlStream&) const = 0;
   
     shared_ptr<Property> _mass;
+    //! \brief The mass Property if it is a single value, otherwise NULL.
+    const NumericProperty* _constMass;
     shared_ptr<IDRange> range;
     std::string spName;
     unsigned int ID;
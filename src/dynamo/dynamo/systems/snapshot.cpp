@@ -79,6 +79,9 @@ namespace dynamo {
 
     Sim->dynamics->updateAllParticles();
 
+    //Bound the memory use to one pending snapshot
+    _writer.wait();
+
     std::string filename = magnet::string::search_replace("Snapshot."+_format+".xml", "%COUNT", boost::lexical_cast<std::string>(_saveCounter));
     
 #ifdef DYNAMO_bzip2_support
@@ -86,7 +89,7 @@ namespace dynamo {
 #endif
 
     filename = magnet::string::search_replace(filename, "%ID", boost::lexical_cast<std::string>(Sim->stateID));
-    Sim->writeXMLfile(filename, _applyBC);
+    std::function<void()> writeConfig = Sim->prepareXMLfile(filename, _applyBC);
     
     dout << "Printing SNAPSHOT" << std::endl;
     
@@ -96,7 +99,12 @@ namespace dynamo {
 #endif
 
     filename = magnet::string::search_replace(filename, "%ID", boost::lexical_cast<std::string>(Sim->stateID));
-    Sim->outputData(filename);
+    std::function<void()> writeOutput = Sim->prepareOutputData(filename);
+
+    _writer.queueTask([writeConfig, writeOutput]() {
+	writeConfig();
+	writeOutput();
+      });
     return NEventData();
   }
 
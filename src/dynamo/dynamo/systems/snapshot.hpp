@@ -17,9 +17,18 @@
 
 #pragma once
 #include <dynamo/systems/system.hpp>
+#include <magnet/thread/background.hpp>
 
 namespace dynamo {
-  //! \brief A System Event which periodically saves the state of the system.
+  /*! \brief A System Event which periodically saves the state of the system.
+
+    The configuration and output data are serialised into memory at
+    the snapshot event (the particle data is only copied), then
+    formatted, compressed and written on a background thread while
+    the simulation continues. Only one snapshot is held in memory at
+    a time, so a snapshot event first waits for the previous
+    snapshot to be written.
+   */
   class SysSnapshot: public System
   {
   public:
@@ -49,6 +58,10 @@ namespace dynamo {
 
     void setTickerPeriod(const double&);
 
+    /*! \brief Wait until the last snapshot has been written to
+        disk.*/
+    void flush() { _writer.wait(); }
+
   protected:
     void eventCallback(const NEventData&);
     virtual void outputXML(magnet::xml::XmlStream&) const {}
@@ -59,5 +72,7 @@ namespace dynamo {
     size_t _saveCounter;
     size_t _eventPeriod;
     size_t _lastEventCount;
+    //! \brief Writes the snapshots in the background.
+    magnet::thread::BackgroundTask _writer;
   };
 }
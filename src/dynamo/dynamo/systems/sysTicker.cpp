@@ -25,7 +25,8 @@
 
 namespace dynamo {
   SysTicker::SysTicker(dynamo::Simulation* nSim, double nPeriod, std::string nName):
-    System(nSim)
+    System(nSim),
+    _worker(2)
   {
     if (nPeriod <= 0.0)
       nPeriod = Sim->units.unitTime();
@@ -45,11 +46,40 @@ namespace dynamo {
     dt += period;  
     //This is done here as most ticker properties require it
     Sim->dynamics->updateAllParticles();
+
+    //The background tickers share a single snapshot
+    OPTicker::SnapshotNeeds needs = OPTicker::NO_SNAPSHOT;
     for (shared_ptr<OutputPlugin>& Ptr : Sim->outputPlugins)
       {
 	shared_ptr<OPTicker> ptr = std::dynamic_pointer_cast<OPTicker>(Ptr);
-	if (ptr) ptr->ticker();
+	if (ptr) needs = std::max(needs, ptr->snapshotNeeds());
       }
+
+    shared_ptr<const TickerSnapshot> snapshot;
+    if (needs != OPTicker::NO_SNAPSHOT)
+      snapshot = OPTicker::takeSnapshot(Sim, needs == OPTicker::NEIGHBOURS);
+
+    std::vector<std::function<void()> > tasks;
+    for (shared_ptr<OutputPlugin>& Ptr : Sim->outputPlugins)
+      {
+	shared_ptr<OPTicker> ptr = std::dynamic_pointer_cast<OPTicker>(Ptr);
+	if (!ptr) continue;
+
+	if (ptr->snapshotNeeds() == OPTicker::NO_SNAPSHOT)
+	  ptr->ticker();
+	else
+	  {
+	    std::function<void()> task = ptr->prepareTicker(snapshot);
+	    //The task holds the plugin, in case the plugin is removed
+	    //from the simulation before the task is run
+	    if (task)
+	      tasks.push_back([ptr, task]() { task(); });
+	  }
+      }
+
+    if (!tasks.empty())
+      _worker.queueTask([tasks]() { for (const std::function<void()>& task : tasks) task(); });
+
     return NEventData();
   }
 
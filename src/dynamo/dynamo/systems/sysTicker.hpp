@@ -17,8 +17,22 @@
 
 #pragma once
 #include <dynamo/systems/system.hpp>
+#include <magnet/thread/background.hpp>
 
 namespace dynamo {
+  /*! \brief The system event which periodically calls the
+      OPTicker output plugins.
+
+      Tickers which are run in the background (see
+      OPTicker::snapshotNeeds()) share a single snapshot of the
+      particles at each tick, and their work is queued on a worker
+      thread. Each tick's work is run in order, and at most a fixed
+      number of ticks may be pending at any time, after which the
+      simulation waits for the worker (so the memory held by the
+      snapshots is bounded). The results are identical to running
+      the tickers synchronously, once the pending ticks are completed
+      with flush().
+   */
   class SysTicker: public System
   {
   public:
@@ -38,8 +52,20 @@ namespace dynamo {
 
     const double& getPeriod() const { return period; }
 
+    /*! \brief Wait for the work of all background ticks to be
+        completed, this must be called before their results are read.
+     */
+    void flush() { _worker.wait(); }
+
+    /*! \brief Set the maximum number of ticks which may be pending
+        on the worker thread.
+     */
+    void setQueueDepth(size_t depth) { _worker.setDepth(depth); }
+
     virtual void replicaExchange(System& os) { 
       SysTicker& s = static_cast<SysTicker&>(os);
+      flush();
+      s.flush();
       std::swap(dt, s.dt);
       std::swap(period, s.period);
     }
@@ -48,5 +74,7 @@ namespace dynamo {
     virtual void outputXML(magnet::xml::XmlStream&) const {}
 
     double period;
+
+    magnet::thread::BackgroundTask _worker;
   };
 }
@@ -0,0 +1,110 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file dynatape.cpp
+ 
+  \brief Contains the main() function for dynatape, which reads the
+  binary event tapes written by the EventTape output plugin.
+*/
+
+#include <dynamo/outputplugins/eventtape.hpp>
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+/*! \brief Starting point for the dynatape program.
+ 
+  \param argc The number of command line arguments.
+  \param argv A pointer to the array of command line arguments.
+*/
+int main(int argc, char *argv[])
+{
+  try 
+    {      
+      namespace po = boost::program_options;
+      
+      po::variables_map vm;
+      po::options_description options("Program Options");
+      options.add_options()
+	("help", "Produces this message")   
+	("tape-file", po::value<std::string>()->default_value("eventtape.bin"), "The event tape to read")
+	("output,o", po::value<std::string>(), "The file to write the text to (default is the standard output)")
+	("from", po::value<uint64_t>()->default_value(0), "The event count of the first event to output")
+	("to", po::value<uint64_t>()->default_value(std::numeric_limits<uint64_t>::max()),
+	 "The event count of the last event to output")
+	("summary", "Only print the number of records and events in the range")
+	;
+
+      po::positional_options_description p;
+      p.add("tape-file", 1);
+
+      po::store(po::command_line_parser(argc, argv).options(options).positional(p).run(), vm);
+      po::notify(vm);
+    
+      if (vm.count("help")) 
+	{
+	  std::cout << "dynatape  Copyright (C) 2011  Marcus N Campbell Bannerman\n"
+		    << "This program comes with ABSOLUTELY NO WARRANTY.\n"
+		    << "This is free software, and you are welcome to redistribute it\n"
+		    << "under certain conditions. See the licence you obtained with\n"
+		    << "the code\n"
+		    << "Usage : dynatape <OPTION>...<tape-file>\n"
+		    << "Converts an event tape to the text format of the Trajectory plugin\n"
+		    << options << "\n";
+	  return 1;
+	}
+      
+      using namespace dynamo;
+
+      EventTapeReader tape(vm["tape-file"].as<std::string>());
+      tape.seekEvent(vm["from"].as<uint64_t>());
+      const uint64_t last = vm["to"].as<uint64_t>();
+
+      std::ofstream file;
+      if (vm.count("output"))
+	{
+	  file.open(vm["output"].as<std::string>());
+	  if (!file)
+	    M_throw() << "Could not open " << vm["output"].as<std::string>() << " for writing";
+	}
+      std::ostream& os = vm.count("output") ? file : std::cout;
+
+      std::vector<EventTapeRecord> records;
+      size_t events = 0, recordCount = 0;
+      while (tape.readEvent(records) && (records.front().eventCount <= last))
+	{
+	  ++events;
+	  recordCount += records.size();
+	  if (!vm.count("summary"))
+	    EventTapeReader::writeText(os, records);
+	}
+
+      if (vm.count("summary"))
+	os << "Particles: " << tape.getHeader().particles
+	   << "\nEvents: " << events
+	   << "\nRecords: " << recordCount << std::endl;
+    }
+  catch (std::exception& cep)
+    {
+      std::cout << cep.what() << std::endl;
+#ifndef DYNAMO_DEBUG
+      std::cout << "Try using the debugging executable for more information on the error." << std::endl;
+#endif
+      return 1;
+    }
+  return 0;
+}
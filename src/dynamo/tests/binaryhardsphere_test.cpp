@@ -163,3 +163,24 @@ BOOST_AUTO_TEST_CASE( Equilibrium_Simulation )
 //
 //  BOOST_CHECK_MESSAGE(Sim.checkSystem() <= 1, "After compression, there are more than one invalid states in the final configuration");
 //}
+
+BOOST_AUTO_TEST_CASE( Species_Index )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 1.4);
+  Sim.endEventCount = 0;
+  Sim.initialise();
+
+  //The indexed lookup must agree with the species ranges, even
+  //though both species were given the same ID
+  for (const dynamo::Particle& part : Sim.particles)
+    {
+      const dynamo::Species& sp = *Sim.species(part);
+      BOOST_REQUIRE(sp.isSpecies(part));
+      BOOST_REQUIRE_EQUAL(&sp, Sim.species[(part.getID() < 100) ? 0 : 1].get());
+    }
+
+  //The single valued masses are rescaled with the units
+  BOOST_CHECK_CLOSE(Sim.species(Sim.particles[0])->getMass(0), Sim.units.unitMass(), 1e-10);
+  BOOST_CHECK_CLOSE(Sim.species(Sim.particles[100])->getMass(100), 0.001 * Sim.units.unitMass(), 1e-10);
+}
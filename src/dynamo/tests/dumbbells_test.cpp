@@ -0,0 +1,108 @@
+#define BOOST_TEST_MODULE Dumbbells_test
+#include <boost/test/included/unit_test.hpp>
+#include <dynamo/simulation.hpp>
+#include <dynamo/BC/include.hpp>
+#include <dynamo/ranges/include.hpp>
+#include <dynamo/inputplugins/cells/include.hpp>
+#include <dynamo/species/sphericalTop.hpp>
+#include <dynamo/dynamics/newtonian.hpp>
+#include <dynamo/schedulers/include.hpp>
+#include <dynamo/schedulers/sorters/boundedPQFEL.hpp>
+#include <dynamo/schedulers/sorters/MinMaxPEL.hpp>
+#include <dynamo/inputplugins/include.hpp>
+#include <dynamo/interactions/dumbbells.hpp>
+#include <dynamo/outputplugins/misc.hpp>
+#include <chrono>
+#include <random>
+
+std::mt19937 RNG;
+typedef dynamo::BoundedPQFEL<dynamo::MinMaxPEL<3> > DefaultSorter;
+
+dynamo::Vector getRandVelVec()
+{
+  //See http://mathworld.wolfram.com/SpherePointPicking.html
+  std::normal_distribution<> normal_dist(0.0, (1.0 / sqrt(double(NDIM))));
+
+  dynamo::Vector tmpVec;
+  for (size_t iDim = 0; iDim < NDIM; iDim++)
+    tmpVec[iDim] = normal_dist(RNG);
+
+  return tmpVec;
+}
+
+void init(dynamo::Simulation& Sim, const double density)
+{
+  RNG.seed(std::random_device()());
+  Sim.ranGenerator.seed(std::random_device()());
+
+  const double elasticity = 1.0;
+  Sim.dynamics = dynamo::shared_ptr<dynamo::Dynamics>(new dynamo::DynNewtonian(&Sim));
+  Sim.BCs = dynamo::shared_ptr<dynamo::BoundaryCondition>(new dynamo::BCPeriodic(&Sim));
+  Sim.ptrScheduler = dynamo::shared_ptr<dynamo::SNeighbourList>(new dynamo::SNeighbourList(&Sim, new DefaultSorter()));
+
+  std::unique_ptr<dynamo::UCell> packptr(new dynamo::CUFCC(std::array<long, 3>{{5,5,5}}, dynamo::Vector{1,1,1}, new dynamo::UParticle()));
+  packptr->initialise();
+  std::vector<dynamo::Vector> latticeSites(packptr->placeObjects(dynamo::Vector{0,0,0}));
+
+  //Two touching spheres of equal size and mass (the "Snowmen"
+  //packer with a size and mass ratio of one)
+  const double sigma = std::cbrt(density / latticeSites.size());
+  const double L = 0.5 * sigma;
+  const double I = 0.5 * (2 * 0.1 * sigma * sigma + 2 * L * L);
+
+  dynamo::shared_ptr<dynamo::IDumbbells> interaction(new dynamo::IDumbbells(&Sim, elasticity, new dynamo::IDPairRangeAll(), "Bulk"));
+  Sim.interactions.push_back(interaction);
+  interaction->addSphere(L * dynamo::Vector{0, 0, 1}, sigma);
+  interaction->addSphere(-L * dynamo::Vector{0, 0, 1}, sigma);
+  Sim.addSpecies(dynamo::shared_ptr<dynamo::Species>(new dynamo::SpSphericalTop(&Sim, new dynamo::IDRangeAll(&Sim), 1.0, "Bulk", 0, I)));
+  Sim.units.setUnitLength(sigma);
+
+  unsigned long nParticles = 0;
+  Sim.particles.reserve(latticeSites.size());
+  for (const dynamo::Vector & position : latticeSites)
+    Sim.particles.push_back(dynamo::Particle(position, getRandVelVec() * Sim.units.unitVelocity(), nParticles++));
+
+  Sim.dynamics->initOrientations();
+
+  Sim.ensemble = dynamo::Ensemble::loadEnsemble(Sim);
+
+  dynamo::InputPlugin(&Sim, "Rescaler").zeroMomentum();
+  dynamo::InputPlugin(&Sim, "Rescaler").rescaleVels(1.0);
+
+  BOOST_CHECK_EQUAL(Sim.N(), 500);
+  BOOST_CHECK_CLOSE(Sim.getNumberDensity() * Sim.units.unitVolume(), density, 0.000000001);
+}
+
+BOOST_AUTO_TEST_CASE( Equilibrium_Simulation )
+{
+  const double density = 0.3;
+  //Create the sim and test save/loading
+  {
+    dynamo::Simulation Sim;
+    init(Sim, density);
+    Sim.writeXMLfile("dumbbells.xml");
+  }
+
+  dynamo::Simulation Sim;
+  Sim.loadXMLfile("dumbbells.xml");
+
+  Sim.eventPrintInterval = 10000;
+  Sim.endEventCount = 100000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  const double initialEnergy = Sim.dynamics->getSystemKineticEnergy();
+
+  const auto start = std::chrono::steady_clock::now();
+  while (Sim.runSimulationStep()) {}
+  const double runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  BOOST_TEST_MESSAGE(Sim.eventCount / runTime << " events per second");
+
+  //Check the collisions conserve energy and momentum
+  Sim.dynamics->updateAllParticles();
+  BOOST_CHECK_CLOSE(Sim.dynamics->getSystemKineticEnergy(), initialEnergy, 0.000001);
+  dynamo::Vector momentum = Sim.getOutputPlugin<dynamo::OPMisc>()->getCurrentMomentum();
+  BOOST_CHECK_SMALL(momentum.nrm() / Sim.units.unitMomentum(), 0.0000000001);
+
+  //Check that no dumbbells are overlapping
+  BOOST_CHECK_EQUAL(Sim.checkSystem(), 0);
+}
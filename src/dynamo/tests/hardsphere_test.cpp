@@ -14,6 +14,17 @@
 #include <dynamo/interactions/hardsphere.hpp>
 #include <dynamo/outputplugins/misc.hpp>
 #include <dynamo/outputplugins/msd.hpp>
+#include <dynamo/outputplugins/eventtape.hpp>
+#include <dynamo/outputplugins/tickerproperty/radialdist.hpp>
+#include <dynamo/outputplugins/tickerproperty/msdmultipletau.hpp>
+#include <dynamo/outputplugins/tickerproperty/SHcrystal.hpp>
+#include <dynamo/globals/cells.hpp>
+#include <dynamo/systems/sysTicker.hpp>
+#ifdef DYNAMO_zlib_support
+# include <zlib.h>
+#endif
+#include <cstring>
+#include <fstream>
 #include <random>
 
 std::mt19937 RNG;
@@ -149,3 +160,362 @@ BOOST_AUTO_TEST_CASE( Compression_Simulation )
 
   BOOST_CHECK_MESSAGE(Sim.checkSystem() <= 1, "After compression, there are more than one invalid states in the final configuration");
 }
+
+BOOST_AUTO_TEST_CASE( Deferred_Configuration_Write )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+  Sim.endEventCount = 20000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+
+  //Take a deferred copy, and write a synchronous copy at the same point
+  std::function<void()> deferred = Sim.prepareXMLfile("HSdeferred.xml");
+  Sim.writeXMLfile("HSsynchronous.xml");
+
+  //The simulation continues before the deferred copy is written
+  Sim.endEventCount = 40000;
+  while (Sim.runSimulationStep()) {}
+  deferred();
+
+  std::ifstream deferredFile("HSdeferred.xml"), synchronousFile("HSsynchronous.xml");
+  const std::string deferredText((std::istreambuf_iterator<char>(deferredFile)), std::istreambuf_iterator<char>());
+  const std::string synchronousText((std::istreambuf_iterator<char>(synchronousFile)), std::istreambuf_iterator<char>());
+  BOOST_CHECK(!deferredText.empty());
+  BOOST_CHECK_MESSAGE(deferredText == synchronousText, "The deferred configuration differs from the synchronous one");
+}
+
+BOOST_AUTO_TEST_CASE( Event_Tape )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+  Sim.endEventCount = 20000;
+  Sim.addOutputPlugin("EventTape:FileName=HStape.bin");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+  Sim.getOutputPlugin<dynamo::OPEventTape>()->flush();
+
+  dynamo::EventTapeReader tape("HStape.bin");
+  BOOST_CHECK_EQUAL(tape.getHeader().particles, Sim.N());
+  BOOST_CHECK(tape.records() >= 10000);
+
+  //Every hard sphere collision is a single pair record, with an
+  //impulse along the line of centres
+  std::vector<dynamo::EventTapeRecord> records;
+  uint64_t lastCount = 0, events = 0;
+  std::vector<uint64_t> counts;
+  while (tape.readEvent(records))
+    {
+      BOOST_REQUIRE_EQUAL(records.size(), 1u);
+      const dynamo::EventTapeRecord& record = records.front();
+      BOOST_REQUIRE((events == 0) || (record.eventCount > lastCount));
+      lastCount = record.eventCount;
+      counts.push_back(lastCount);
+      ++events;
+
+      BOOST_REQUIRE_EQUAL(record.kind, dynamo::EventTapeRecord::PAIR);
+      BOOST_REQUIRE_EQUAL(dynamo::EEventType(record.type), dynamo::CORE);
+      BOOST_REQUIRE(record.p1 < record.p2);
+      const dynamo::Vector impulse{record.impulse[0], record.impulse[1], record.impulse[2]};
+      const dynamo::Vector rij{record.r[0], record.r[1], record.r[2]};
+      BOOST_REQUIRE_SMALL((impulse ^ rij).nrm(), 1e-10 * impulse.nrm() * rij.nrm());
+    }
+  BOOST_CHECK_EQUAL(events, tape.records());
+
+  //Seeking (using the index) finds the requested events
+  for (size_t i : {size_t(0), counts.size() / 3, counts.size() - 1})
+    {
+      tape.seekEvent(counts[i]);
+      BOOST_REQUIRE(tape.readEvent(records));
+      BOOST_CHECK_EQUAL(records.front().eventCount, counts[i]);
+    }
+  tape.seekEvent(lastCount + 1);
+  BOOST_CHECK(!tape.readEvent(records));
+
+  //The text conversion uses the Trajectory plugin format
+  std::ostringstream os;
+  tape.seekRecord(0);
+  tape.readEvent(records);
+  dynamo::EventTapeReader::writeText(os, records);
+  BOOST_CHECK(os.str().find("Event Type=CORE") != std::string::npos);
+  BOOST_CHECK(os.str().find("2PEvent: p1=") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE( Radial_Distribution_Cells )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+  Sim.endEventCount = 10000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+
+  //The distribution is sampled once on initialisation. It is short
+  //enough for the cell list to be used.
+  Sim.reset();
+  Sim.addOutputPlugin("Misc");
+  Sim.addOutputPlugin("RadialDistribution:BinWidth=0.1,Length=30");
+  Sim.initialise();
+  const dynamo::OPRadialDistribution& rdf = *Sim.getOutputPlugin<dynamo::OPRadialDistribution>();
+  const std::vector<std::pair<double, double> > gr = rdf.getgrdata(0, 0);
+
+  //Compare against a direct count over all pairs
+  const double binWidth = rdf.getBinWidth();
+  std::vector<unsigned long> counts(gr.size(), 0);
+  for (const dynamo::Particle& p1 : Sim.particles)
+    for (const dynamo::Particle& p2 : Sim.particles)
+      {
+	dynamo::Vector rij = p1.getPosition() - p2.getPosition();
+	Sim.BCs->applyBC(rij);
+	const size_t i = static_cast<size_t>(rij.nrm() / binWidth + 0.5);
+	if (i < counts.size()) ++counts[i];
+      }
+
+  BOOST_CHECK_EQUAL(counts[0], Sim.N());
+  const double density = (Sim.N() - 1) / Sim.getSimVolume();
+  for (size_t i(1); i < counts.size(); ++i)
+    {
+      const double radius = binWidth * i;
+      const double volshell = M_PI * (4.0 * binWidth * radius * radius + binWidth * binWidth * binWidth / 3.0);
+      BOOST_CHECK_EQUAL(std::round(gr[i].second * density * Sim.N() * volshell), counts[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Background_Ticker )
+{
+  {
+    dynamo::Simulation Sim;
+    init(Sim, 0.5);
+    Sim.endEventCount = 10000;
+    Sim.addOutputPlugin("Misc");
+    Sim.initialise();
+    while (Sim.runSimulationStep()) {}
+    Sim.writeXMLfile("HSbackground.xml");
+  }
+
+  //Run the same trajectory with the distribution sampled
+  //synchronously and in the background. Only one tick may be queued
+  //in the second run, so the simulation is regularly held up by the
+  //worker thread.
+  std::vector<std::vector<std::pair<double, double> > > results;
+  for (const std::string plugin : {"RadialDistribution:BinWidth=0.1,Length=30", "RadialDistribution:BinWidth=0.1,Length=30,Background"})
+    {
+      dynamo::Simulation Sim;
+      Sim.loadXMLfile("HSbackground.xml");
+      Sim.endEventCount = 20000;
+      Sim.addOutputPlugin("Misc");
+      Sim.addOutputPlugin(plugin);
+      Sim.initialise();
+      Sim.setTickerPeriod(0.01);
+      dynamic_cast<dynamo::SysTicker&>(*Sim.systems["SystemTicker"]).setQueueDepth(1);
+      while (Sim.runSimulationStep()) {}
+      results.push_back(Sim.getOutputPlugin<dynamo::OPRadialDistribution>()->getgrdata(0, 0));
+    }
+
+  BOOST_REQUIRE_EQUAL(results[0].size(), results[1].size());
+  for (size_t i(0); i < results[0].size(); ++i)
+    BOOST_CHECK_EQUAL(results[0][i].second, results[1][i].second);
+}
+
+BOOST_AUTO_TEST_CASE( SH_Crystal_FCC )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+
+  //The nearest neighbours of the lattice are at sqrt(2) diameters,
+  //which is beyond the range of the scheduler's neighbour list
+  dynamo::shared_ptr<dynamo::GCells> cells(new dynamo::GCells(&Sim, "SHCells"));
+  cells->setMaxInteractionRange(1.6 * Sim.units.unitLength());
+  Sim.globals.push_back(cells);
+  Sim.endEventCount = 0;
+  Sim.addOutputPlugin("Misc");
+  Sim.addOutputPlugin("SHCrystal:CutOffR=1.6");
+
+  //The order is sampled once on initialisation, when the particles
+  //are still on the FCC lattice
+  Sim.initialise();
+  const dynamo::OPSHCrystal& sh = *Sim.getOutputPlugin<dynamo::OPSHCrystal>();
+  BOOST_CHECK_CLOSE(sh.getQ(4), 0.190941, 0.001);
+  BOOST_CHECK_CLOSE(sh.getQ(6), 0.574524, 0.001);
+
+  BOOST_REQUIRE_EQUAL(sh.getLocalOrder().size(), Sim.N());
+  for (const dynamo::OPSHCrystal::LocalOrder& order : sh.getLocalOrder())
+    {
+      BOOST_CHECK_EQUAL(order.bonds, 12u);
+      BOOST_CHECK_CLOSE(order.q4, 0.190941, 0.001);
+      BOOST_CHECK_CLOSE(order.q6, 0.574524, 0.001);
+      BOOST_CHECK_CLOSE(order.W6, -0.013161, 0.01);
+      BOOST_CHECK_EQUAL(order.cluster, Sim.N());
+    }
+}
+
+//Read the first array of the appended data of a VTK file
+std::vector<float> readAppendedArray(const std::string& filename, const bool compressed)
+{
+  std::ifstream file(filename, std::ios::binary);
+  const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  const size_t start = text.find("<AppendedData encoding=\"raw\">");
+  BOOST_REQUIRE(start != std::string::npos);
+  const char* data = text.data() + text.find('_', start) + 1;
+
+  std::vector<float> retval;
+  if (!compressed)
+    {
+      uint64_t size;
+      std::memcpy(&size, data, sizeof(size));
+      retval.resize(size / sizeof(float));
+      std::memcpy(retval.data(), data + sizeof(size), size);
+      return retval;
+    }
+
+#ifdef DYNAMO_zlib_support
+  uint64_t blocks, blockSize, lastSize;
+  std::memcpy(&blocks, data, sizeof(uint64_t));
+  std::memcpy(&blockSize, data + sizeof(uint64_t), sizeof(uint64_t));
+  std::memcpy(&lastSize, data + 2 * sizeof(uint64_t), sizeof(uint64_t));
+  const char* block = data + (3 + blocks) * sizeof(uint64_t);
+  std::string uncompressed;
+  for (size_t i(0); i < blocks; ++i)
+    {
+      uint64_t compressedSize;
+      std::memcpy(&compressedSize, data + (3 + i) * sizeof(uint64_t), sizeof(uint64_t));
+      uLongf size = ((i + 1 == blocks) && lastSize) ? lastSize : blockSize;
+      std::string out(size, '\0');
+      BOOST_REQUIRE_EQUAL(uncompress(reinterpret_cast<Bytef*>(&out[0]), &size, reinterpret_cast<const Bytef*>(block), compressedSize), Z_OK);
+      uncompressed.append(out, 0, size);
+      block += compressedSize;
+    }
+  retval.resize(uncompressed.size() / sizeof(float));
+  std::memcpy(retval.data(), uncompressed.data(), uncompressed.size());
+#endif
+  return retval;
+}
+
+BOOST_AUTO_TEST_CASE( VTK_Appended_Data )
+{
+  std::vector<std::string> formats{"binary"};
+#ifdef DYNAMO_zlib_support
+  formats.push_back("zlib");
+#endif
+
+  for (const std::string& format : formats)
+    {
+      dynamo::Simulation Sim;
+      init(Sim, 0.5);
+      Sim.endEventCount = 0;
+      Sim.addOutputPlugin("Misc");
+      Sim.addOutputPlugin("VTK:NoFields,Format=" + format);
+      //The particles are written on initialisation
+      Sim.initialise();
+
+      const std::vector<float> positions = readAppendedArray("particles_00000.vtu", format == "zlib");
+      BOOST_REQUIRE_EQUAL(positions.size(), 3 * Sim.N());
+      for (const dynamo::Particle& part : Sim.particles)
+	{
+	  dynamo::Vector r = part.getPosition();
+	  Sim.BCs->applyBC(r);
+	  for (size_t iDim(0); iDim < 3; ++iDim)
+	    BOOST_CHECK_EQUAL(positions[3 * part.getID() + iDim], float(r[iDim] / Sim.units.unitLength()));
+	}
+    }
+}
+
+BOOST_AUTO_TEST_CASE( VTK_Field_Deposition )
+{
+  //Both the nearest grid point and the cloud in cell deposition
+  //conserve the number of particles
+  for (const std::string& deposition : {"", ",CIC"})
+    {
+      dynamo::Simulation Sim;
+      init(Sim, 0.5);
+      Sim.endEventCount = 0;
+      Sim.addOutputPlugin("Misc");
+      Sim.addOutputPlugin("VTK:MinBinWidth=0.5,Format=binary" + deposition);
+      Sim.initialise();
+
+      //The number density is the first field, written with three
+      //identical components
+      const std::vector<float> density = readAppendedArray("fields_00000.vti", false);
+      BOOST_REQUIRE_EQUAL(density.size() % 3, 0u);
+      const size_t cells = density.size() / 3;
+      BOOST_REQUIRE(cells > 1000);
+
+      double volume = 1;
+      for (size_t iDim(0); iDim < 3; ++iDim)
+	volume *= Sim.primaryCellSize[iDim];
+
+      double sum = 0;
+      for (size_t i(0); i < cells; ++i)
+	sum += density[3 * i];
+
+      BOOST_CHECK_CLOSE(sum * volume / (cells * Sim.units.unitVolume()), double(Sim.N()), 1e-3);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( MSD_Multiple_Tau )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+  Sim.endEventCount = 10000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+
+  //Tick much faster than the mean free time, so the first lags are
+  //ballistic
+  Sim.reset();
+  Sim.endEventCount = 50000;
+  Sim.addOutputPlugin("Misc");
+  Sim.addOutputPlugin("MSDMultipleTau:Length=4");
+  Sim.initialise();
+  Sim.setTickerPeriod(0.002);
+  const double dt = dynamic_cast<const dynamo::SysTicker&>(*Sim.systems["SystemTicker"]).getPeriod();
+  while (Sim.runSimulationStep()) {}
+
+  const std::vector<std::array<double, 3> > corr = Sim.getOutputPlugin<dynamo::OPMSDMultipleTau>()->getCorrelators(0);
+  BOOST_REQUIRE(corr.size() > 10);
+
+  //The lags are 0,1,2,3 ticks, then 1,2,3 blocks of 4, 16, 64... ticks
+  BOOST_CHECK_EQUAL(corr[0][0], 0);
+  BOOST_CHECK_SMALL(corr[0][1], 1e-12);
+  for (size_t i(1); i < corr.size(); ++i)
+    {
+      const size_t level = (i - 1) / 3;
+      const double lag = ((i - 1) % 3 + 1) * std::pow(4.0, double(level));
+      BOOST_CHECK_CLOSE(corr[i][0], lag * dt, 1e-8);
+      BOOST_CHECK(corr[i][1] > corr[i - 1][1]);
+    }
+
+  //The VACF at zero lag is fixed by the temperature, and the first
+  //lag is ballistic
+  const double v2 = 3 * Sim.units.unitVelocity() * Sim.units.unitVelocity();
+  BOOST_CHECK_CLOSE(corr[0][2], v2, 1e-8);
+  BOOST_CHECK_CLOSE(corr[1][1], v2 * dt * dt, 2);
+}
+
+BOOST_AUTO_TEST_CASE( Transport_Correlators )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.5);
+  Sim.endEventCount = 20000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+  Sim.outputData("HStransport.xml");
+
+  Sim.reset();
+  Sim.endEventCount = 20000;
+  Sim.addOutputPlugin("Misc:NoTransport");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+  Sim.outputData("HSnotransport.xml");
+
+  std::ifstream transportFile("HStransport.xml"), noTransportFile("HSnotransport.xml");
+  const std::string transportText((std::istreambuf_iterator<char>(transportFile)), std::istreambuf_iterator<char>());
+  const std::string noTransportText((std::istreambuf_iterator<char>(noTransportFile)), std::istreambuf_iterator<char>());
+  BOOST_CHECK(transportText.find("<ThermalConductivity>") != std::string::npos);
+  BOOST_CHECK(transportText.find("<Viscosity>") != std::string::npos);
+  BOOST_CHECK(noTransportText.find("<Misc>") != std::string::npos);
+  BOOST_CHECK(noTransportText.find("<ThermalConductivity>") == std::string::npos);
+}
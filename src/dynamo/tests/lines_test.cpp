@@ -16,6 +16,7 @@
 #include <dynamo/interactions/lines.hpp>
 #include <dynamo/outputplugins/misc.hpp>
 #include <dynamo/outputplugins/msd.hpp>
+#include <chrono>
 #include <random>
 
 std::mt19937 RNG;
@@ -88,7 +89,10 @@ BOOST_AUTO_TEST_CASE( Equilibrium_Simulation )
     Sim.endEventCount = 100000;
     Sim.addOutputPlugin("Misc");
     Sim.initialise();
+    const auto start = std::chrono::steady_clock::now();
     while (Sim.runSimulationStep()) {}
+    const double runTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    BOOST_TEST_MESSAGE(Sim.eventCount / runTime << " events per second");
 
     const double expectedMFT = 1.0 / (1.237662399 * density);
 
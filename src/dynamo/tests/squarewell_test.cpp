@@ -169,3 +169,81 @@ BOOST_AUTO_TEST_CASE( Compression_Simulation )
   BOOST_CHECK_CLOSE(Sim.getPackingFraction(), Sim.getNumberDensity() * Sim.units.unitVolume() * M_PI / 6.0, 0.000000001);
   BOOST_CHECK_MESSAGE(Sim.checkSystem() <= 1, "After compression, there are more than one invalid states in the final configuration");
 }
+
+BOOST_AUTO_TEST_CASE( Binary_Checkpoint )
+{
+  dynamo::Simulation Sim;
+  init(Sim);
+  Sim.endEventCount = 20000;
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+  Sim.writeXMLfile("SWcheckpoint.bin");
+
+  dynamo::Simulation Sim2;
+  Sim2.loadXMLfile("SWcheckpoint.bin");
+
+  BOOST_REQUIRE_EQUAL(Sim2.N(), Sim.N());
+  for (size_t i(0); i < Sim.N(); ++i)
+    {
+      dynamo::Vector pos = Sim.particles[i].getPosition();
+      dynamo::Vector vel = Sim.particles[i].getVelocity();
+      Sim.BCs->applyBC(pos, vel);
+      //The configuration is reloaded in the units of the file
+      BOOST_CHECK_SMALL((pos / Sim.units.unitLength() - Sim2.particles[i].getPosition() / Sim2.units.unitLength()).nrm(), 1e-12);
+      BOOST_CHECK_SMALL((vel / Sim.units.unitVelocity() - Sim2.particles[i].getVelocity() / Sim2.units.unitVelocity()).nrm(), 1e-12);
+    }
+
+  //The capture map must be restored exactly
+  const dynamo::detail::CaptureMap& map1 = *std::dynamic_pointer_cast<dynamo::ICapture>(Sim.interactions[0]);
+  const dynamo::detail::CaptureMap& map2 = *std::dynamic_pointer_cast<dynamo::ICapture>(Sim2.interactions[0]);
+  BOOST_CHECK(map1.size() > 0);
+  BOOST_CHECK(map1 == map2);
+
+  Sim2.endEventCount = 20000;
+  Sim2.addOutputPlugin("Misc");
+  Sim2.initialise();
+  const double totalEinit = Sim2.getOutputPlugin<dynamo::OPMisc>()->getTotalEnergy();
+  while (Sim2.runSimulationStep()) {}
+  BOOST_CHECK_CLOSE(totalEinit, Sim2.getOutputPlugin<dynamo::OPMisc>()->getTotalEnergy(), 0.000000001);
+  BOOST_CHECK_MESSAGE(Sim2.checkSystem() <= 2, "There are more than two invalid states in the resumed configuration");
+}
+
+BOOST_AUTO_TEST_CASE( Capture_Map_Hash )
+{
+  using namespace dynamo::detail;
+  std::mt19937 gen;
+  std::uniform_int_distribution<size_t> particle(0, 30), state(0, 3);
+
+  //Apply random changes to a map, the incrementally maintained hash
+  //must only depend on the contents of the map
+  CaptureMap map;
+  std::unordered_map<CaptureMapKey, size_t, CaptureMapKeyHash> seen;
+  for (size_t i(0); i < 5000; ++i)
+    {
+      const size_t p1 = particle(gen), p2 = particle(gen);
+      if (p1 == p2) continue;
+      const PairKey key(p1, p2);
+      const size_t value = state(gen);
+
+      //A view of the change must match the map after the change
+      const CaptureMapKey change = CaptureMapKey::view(map, key, value);
+      map[key] = value;
+      BOOST_REQUIRE_EQUAL(change.hash(), map.hash());
+      BOOST_REQUIRE_EQUAL(change.size(), map.size());
+
+      CaptureMap rebuilt;
+      for (const CaptureMap::value_type& entry : map)
+	rebuilt[entry.first] = entry.second;
+      BOOST_REQUIRE_EQUAL(rebuilt.hash(), map.hash());
+
+      const CaptureMapKey copy(map);
+      BOOST_REQUIRE(copy == CaptureMapKey::view(map));
+      BOOST_REQUIRE(change == copy);
+      seen.insert(std::make_pair(copy, i));
+      BOOST_REQUIRE(seen.find(CaptureMapKey::view(map)) != seen.end());
+    }
+
+  map.clear();
+  BOOST_CHECK_EQUAL(map.hash(), 0u);
+  BOOST_CHECK(CaptureMapKey(map) == CaptureMapKey::view(map));
+}
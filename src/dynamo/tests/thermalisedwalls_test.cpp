@@ -15,6 +15,7 @@
 #include <dynamo/outputplugins/misc.hpp>
 #include <dynamo/locals/lwall.hpp>
 #include <random>
+#include <set>
 
 std::mt19937 RNG;
 typedef dynamo::BoundedPQFEL<dynamo::MinMaxPEL<3> > DefaultSorter;
@@ -117,3 +118,41 @@ BOOST_AUTO_TEST_CASE( Simulation )
   BOOST_CHECK_MESSAGE(Sim.checkSystem() <= 1, "There are more than two invalid states in the final configuration");
 }
 
+
+BOOST_AUTO_TEST_CASE( Local_Neighbours )
+{
+  dynamo::Simulation Sim;
+  init(Sim, 0.1);
+  Sim.endEventCount = 10000;
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  while (Sim.runSimulationStep()) {}
+
+  //Every wall a particle is within reach of must be in its
+  //neighbourhood, and the walls far from a particle should not be
+  size_t filtered = 0;
+  for (dynamo::Particle& part : Sim.particles)
+    {
+      Sim.dynamics->updateParticle(part);
+      std::unique_ptr<dynamo::IDRange> ids(Sim.ptrScheduler->getParticleLocals(part));
+      std::set<size_t> locals;
+      for (const size_t id : *ids)
+	locals.insert(id);
+
+      if (locals.size() < Sim.locals.size())
+	++filtered;
+
+      for (const dynamo::shared_ptr<dynamo::Local>& local : Sim.locals)
+	{
+	  const std::pair<dynamo::Vector, dynamo::Vector> bounds = local->getBounds();
+	  bool inside = true;
+	  for (size_t iDim(0); iDim < NDIM; ++iDim)
+	    inside = inside && (part.getPosition()[iDim] >= bounds.first[iDim]) && (part.getPosition()[iDim] <= bounds.second[iDim]);
+
+	  if (inside)
+	    BOOST_CHECK_MESSAGE(locals.count(local->getID()), "Particle " << part.getID() << " is missing the Local " << local->getName());
+	}
+    }
+
+  BOOST_CHECK(filtered > 0);
+}
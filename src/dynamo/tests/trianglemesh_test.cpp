@@ -0,0 +1,186 @@
+#define BOOST_TEST_MODULE TriangleMesh_test
+#include <boost/test/included/unit_test.hpp>
+#include <dynamo/simulation.hpp>
+#include <dynamo/BC/include.hpp>
+#include <dynamo/ranges/include.hpp>
+#include <dynamo/inputplugins/cells/include.hpp>
+#include <dynamo/species/point.hpp>
+#include <dynamo/dynamics/newtonian.hpp>
+#include <dynamo/schedulers/include.hpp>
+#include <dynamo/schedulers/sorters/boundedPQFEL.hpp>
+#include <dynamo/schedulers/sorters/MinMaxPEL.hpp>
+#include <dynamo/inputplugins/include.hpp>
+#include <dynamo/interactions/hardsphere.hpp>
+#include <dynamo/outputplugins/misc.hpp>
+#include <dynamo/locals/trianglemesh.hpp>
+#include <chrono>
+#include <random>
+
+std::mt19937 RNG;
+typedef dynamo::BoundedPQFEL<dynamo::MinMaxPEL<3> > DefaultSorter;
+typedef dynamo::LTriangleMesh::TriangleElements TriangleElements;
+
+//The side length of the cubic mesh the particles are held in
+const double cubeSide = 12;
+
+dynamo::Vector getRandVelVec()
+{
+  //See http://mathworld.wolfram.com/SpherePointPicking.html
+  std::normal_distribution<> normal_dist(0.0, (1.0 / sqrt(double(NDIM))));
+
+  dynamo::Vector tmpVec;
+  for (size_t iDim = 0; iDim < NDIM; iDim++)
+    tmpVec[iDim] = normal_dist(RNG);
+
+  return tmpVec;
+}
+
+//A closed cube centred on the origin, with each face split into n x
+//n squares of two triangles (12 n^2 triangles in total)
+void buildCube(std::vector<dynamo::Vector>& vertices, std::vector<TriangleElements>& elements, const size_t n)
+{
+  for (size_t axis(0); axis < 3; ++axis)
+    for (const double side : {-0.5, 0.5})
+      {
+	const size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+	const size_t base = vertices.size();
+	for (size_t i(0); i <= n; ++i)
+	  for (size_t j(0); j <= n; ++j)
+	    {
+	      dynamo::Vector vertex;
+	      vertex[axis] = side * cubeSide;
+	      vertex[u] = cubeSide * (double(i) / n - 0.5);
+	      vertex[v] = cubeSide * (double(j) / n - 0.5);
+	      vertices.push_back(vertex);
+	    }
+
+	auto index = [&](const size_t i, const size_t j) { return base + i * (n + 1) + j; };
+	for (size_t i(0); i < n; ++i)
+	  for (size_t j(0); j < n; ++j)
+	    {
+	      elements.push_back(TriangleElements(index(i, j), index(i + 1, j), index(i + 1, j + 1)));
+	      elements.push_back(TriangleElements(index(i, j), index(i + 1, j + 1), index(i, j + 1)));
+	    }
+      }
+}
+
+void init(dynamo::Simulation& Sim, const bool periodic, const size_t n, std::vector<dynamo::Vector>& vertices, std::vector<TriangleElements>& elements)
+{
+  RNG.seed(std::random_device()());
+  Sim.ranGenerator.seed(std::random_device()());
+
+  const double elasticity = 1.0;
+
+  Sim.dynamics = dynamo::shared_ptr<dynamo::Dynamics>(new dynamo::DynNewtonian(&Sim));
+  if (periodic)
+    Sim.BCs = dynamo::shared_ptr<dynamo::BoundaryCondition>(new dynamo::BCPeriodic(&Sim));
+  else
+    Sim.BCs = dynamo::shared_ptr<dynamo::BoundaryCondition>(new dynamo::BCNone(&Sim));
+  Sim.ptrScheduler = dynamo::shared_ptr<dynamo::SNeighbourList>(new dynamo::SNeighbourList(&Sim, new DefaultSorter()));
+
+  std::unique_ptr<dynamo::UCell> packptr(new dynamo::CUFCC(std::array<long, 3>{{5,5,5}}, dynamo::Vector{1,1,1}, new dynamo::UParticle()));
+  packptr->initialise();
+  std::vector<dynamo::Vector> latticeSites(packptr->placeObjects(dynamo::Vector{0,0,0}));
+  Sim.primaryCellSize = dynamo::Vector{cubeSide + 1, cubeSide + 1, cubeSide + 1};
+
+  Sim.interactions.push_back(dynamo::shared_ptr<dynamo::Interaction>(new dynamo::IHardSphere(&Sim, 1.0, elasticity, new dynamo::IDPairRangeAll(), "Bulk")));
+  Sim.addSpecies(dynamo::shared_ptr<dynamo::Species>(new dynamo::SpPoint(&Sim, new dynamo::IDRangeAll(&Sim), 1.0, "Bulk", 0)));
+
+  buildCube(vertices, elements, n);
+  Sim.locals.push_back(dynamo::shared_ptr<dynamo::Local>(new dynamo::LTriangleMesh(&Sim, elasticity, 1.0, "Cube", new dynamo::IDRangeAll(&Sim), vertices, elements)));
+
+  unsigned long nParticles = 0;
+  Sim.particles.reserve(latticeSites.size());
+  for (const dynamo::Vector & position : latticeSites)
+    Sim.particles.push_back(dynamo::Particle(10 * position, getRandVelVec(), nParticles++));
+
+  Sim.ensemble = dynamo::Ensemble::loadEnsemble(Sim);
+  dynamo::InputPlugin(&Sim, "Rescaler").zeroMomentum();
+  dynamo::InputPlugin(&Sim, "Rescaler").rescaleVels(1.0);
+
+  BOOST_CHECK_EQUAL(Sim.N(), 500);
+  BOOST_CHECK_EQUAL(elements.size(), 12 * n * n);
+}
+
+//Compare the events found through the grid against those found by
+//testing every triangle, timing both.
+void checkEvents(dynamo::Simulation& Sim, const std::vector<dynamo::Vector>& vertices, const std::vector<TriangleElements>& elements)
+{
+  const dynamo::Local& mesh = *Sim.locals.front();
+  std::vector<dynamo::Event> events;
+  events.reserve(Sim.N());
+  const auto gridStart = std::chrono::steady_clock::now();
+  for (const dynamo::Particle& part : Sim.particles)
+    events.push_back(mesh.getEvent(part));
+  const double gridTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - gridStart).count();
+
+  std::vector<double> expected;
+  expected.reserve(Sim.N());
+  const auto allStart = std::chrono::steady_clock::now();
+  for (const dynamo::Particle& part : Sim.particles)
+    {
+      double tmin = std::numeric_limits<float>::infinity();
+      for (const TriangleElements& elem : elements)
+	tmin = std::min(tmin, Sim.dynamics->getSphereTriangleEvent(part, vertices[std::get<0>(elem)], vertices[std::get<1>(elem)], vertices[std::get<2>(elem)], 0.5).first);
+      expected.push_back(tmin);
+    }
+  const double allTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - allStart).count();
+
+  BOOST_TEST_MESSAGE(elements.size() << " triangles: " << 1e6 * gridTime / Sim.N() << "us per particle with the grid, "
+		     << 1e6 * allTime / Sim.N() << "us per particle testing every triangle");
+
+  for (size_t i(0); i < Sim.N(); ++i)
+    {
+      //A virtual event must be before the collision with the mesh
+      if (events[i]._type == dynamo::VIRTUAL)
+	BOOST_CHECK(events[i]._dt <= expected[i]);
+      else
+	{
+	  BOOST_CHECK_EQUAL(events[i]._type, dynamo::WALL);
+	  BOOST_CHECK_EQUAL(events[i]._dt, expected[i]);
+	}
+    }
+}
+
+//Run the simulation and check no particle leaves the cube
+void checkContained(dynamo::Simulation& Sim)
+{
+  Sim.endEventCount = 20000;
+  while (Sim.runSimulationStep()) {}
+
+  for (dynamo::Particle& part : Sim.particles)
+    {
+      Sim.dynamics->updateParticle(part);
+      dynamo::Vector pos = part.getPosition();
+      Sim.BCs->applyBC(pos);
+      for (size_t iDim(0); iDim < NDIM; ++iDim)
+	BOOST_CHECK(std::abs(pos[iDim]) < 0.5 * cubeSide);
+    }
+
+  BOOST_CHECK_CLOSE(Sim.getOutputPlugin<dynamo::OPMisc>()->getCurrentkT() / Sim.units.unitEnergy(), 1.0, 0.000001);
+}
+
+BOOST_AUTO_TEST_CASE( Grid_Benchmark )
+{
+  //A mesh of 101568 triangles
+  std::vector<dynamo::Vector> vertices;
+  std::vector<TriangleElements> elements;
+  dynamo::Simulation Sim;
+  init(Sim, false, 92, vertices, elements);
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  checkEvents(Sim, vertices, elements);
+  checkContained(Sim);
+}
+
+BOOST_AUTO_TEST_CASE( Grid_Periodic )
+{
+  std::vector<dynamo::Vector> vertices;
+  std::vector<TriangleElements> elements;
+  dynamo::Simulation Sim;
+  init(Sim, true, 20, vertices, elements);
+  Sim.addOutputPlugin("Misc");
+  Sim.initialise();
+  checkEvents(Sim, vertices, elements);
+  checkContained(Sim);
+}
@@ -257,8 +257,136 @@ namespace magnet {
       double _current_time;
     };
 
-    /*! \brief An extension of the TimeCorrelator class allowing full
-        resolution of the correlation functions during a simulation.
+    /*! \brief A streaming multiple-tau form of the Correlator class.
+
+      This collects the same Einstein correlation as the Correlator
+      class, but at logarithmically spaced values of \f$j\f$ which
+      cover the whole length of the simulation. This is the "order-n"
+      algorithm of Frenkel and Smit ("Understanding Molecular
+      Simulation", 2nd ed., 2002).
+
+      The \f$\Delta W\f$ values are stored in levels. Level \f$k\f$
+      holds the last \f$p\f$ values, each summed over a block of
+      \f$p^k\f$ samples, and is correlated for \f$j = p^k, 2p^k,
+      \ldots, p^{k+1}\f$. A level is only updated once per block of
+      the level below it, so a push() costs \f$O(p)\f$ amortised and
+      the memory is \f$O(p)\f$ per level.
+
+      \tparam T See \ref Correlator.
+    */
+    template<class T>
+    class MultipleTauCorrelator
+    {
+    public:
+      /*! \brief Create a MultipleTauCorrelator.
+
+	 \param length The number of values (\f$p\f$) stored at each
+	 level, this is also the block size between the levels.
+	 \param max_levels The maximum number of levels, which bounds
+	 the memory used.
+       */
+      MultipleTauCorrelator(size_t length = 16, size_t max_levels = 24):
+	_length(length), _max_levels(max_levels)
+      {
+	if ((length < 2) || (max_levels == 0))
+	  M_throw() << "MultipleTauCorrelator requires a length of at least 2 and at least one level, length=" << length
+		    << ", max_levels=" << max_levels;
+      }
+
+      /*! \brief Add a new pair of \f$\Delta W^{(1)}\f$ and \f$\Delta
+          W^{(2)}\f$ values to the correlator (see \ref Correlator::push()).
+       */
+      void push(const T& W1, const T& W2) { push(0, W1, W2); }
+
+      /*! \brief Clear the correlator. */
+      void clear() { _levels.clear(); }
+
+      /*! \brief The returned data type for the
+          getAveragedCorrelator() function.
+       */
+      struct Data
+      {
+	Data(size_t l, size_t sc, T v): lag(l), sample_count(sc), value(v) {}
+
+	size_t lag;
+	size_t sample_count;
+	T value;
+      };
+
+      /*! \brief Returns the averaged correlation for each value of
+          \f$j\f$ (the lag, in samples) collected so far.
+
+	  The first level is returned in its entirety, followed by the
+	  non-overlapping parts of every other level.
+       */
+      std::vector<Data> getAveragedCorrelator() const
+      {
+	std::vector<Data> avg_correlator;
+	size_t block = 1;
+	for (size_t level(0); level < _levels.size(); ++level, block *= _length)
+	  {
+	    const Level& current = _levels[level];
+	    for (size_t j(level ? 1 : 0); j < current.history.size(); ++j)
+	      avg_correlator.push_back(Data((j + 1) * block, current.count[j], current.correlator[j] / current.count[j]));
+	  }
+	return avg_correlator;
+      }
+
+    protected:
+      struct Level
+      {
+	boost::circular_buffer<std::pair<T, T> > history;
+	std::vector<T> correlator;
+	std::vector<size_t> count;
+	//! \brief The sum of the values pushed since the last block was passed on.
+	std::pair<T, T> block;
+	size_t block_count;
+      };
+
+      void push(const size_t level, const T& W1, const T& W2)
+      {
+	if (level == _levels.size())
+	  {
+	    _levels.push_back(Level());
+	    _levels.back().history.set_capacity(_length);
+	    _levels.back().correlator.resize(_length);
+	    _levels.back().count.resize(_length, 0);
+	    _levels.back().block_count = 0;
+	  }
+
+	Level& current = _levels[level];
+	current.history.push_front(std::pair<T, T>(W1, W2));
+
+	std::pair<T, T> sum = std::pair<T, T>();
+	for (size_t j(0); j < current.history.size(); ++j)
+	  {
+	    sum.first += current.history[j].first;
+	    sum.second += current.history[j].second;
+	    current.correlator[j] += elementwiseMultiply(sum.first, sum.second);
+	    ++current.count[j];
+	  }
+
+	current.block.first += W1;
+	current.block.second += W2;
+	if (++current.block_count == _length)
+	  {
+	    //Pass the block on to the next level. The reference to this
+	    //level is not used after this, as adding a level may move it.
+	    const std::pair<T, T> block = current.block;
+	    current.block = std::pair<T, T>();
+	    current.block_count = 0;
+	    if (level + 1 < _max_levels)
+	      push(level + 1, block.first, block.second);
+	  }
+      }
+
+      std::vector<Level> _levels;
+      size_t _length;
+      size_t _max_levels;
+    };
+
+    /*! \brief A TimeCorrelator which resolves all of the time scales
+        of a simulation.
 
 	The main problem of collecting Correlators is that you need to
 	pick a fixed sample_time and correlator length. You can't
@@ -268,44 +396,42 @@ namespace magnet {
 	to capture all relaxation times to ensure you are reaching the
 	hydrodynamic limit.
 
-	This class dynamically adds more correlators at exponentially
-	growing sample_times to ensure that all time scales are
-	monitored without a great computational or memory overhead.
+	Here, the impulsive and free streaming contributions are
+	integrated over a single sample_time (as in TimeCorrelator)
+	and each sample is passed to a MultipleTauCorrelator, which
+	spaces the correlation times logarithmically. Each event
+	(addImpulse() or setFreeStreamValue()) is \f$O(1)\f$ and each
+	sample is \f$O(1)\f$ amortised, and the memory is bounded.
      */
     template<class T>
     class LogarithmicTimeCorrelator
     {
-      typedef TimeCorrelator<T> Correlator;
-      typedef std::vector<Correlator> Container;
     public:
-      /*! \brief Resets the TimeCorrelator before data collection.
-	
+      LogarithmicTimeCorrelator(): _sample_time(1), _current_time(0) {}
+
+      /*! \brief Resets the correlator before data collection.
+
 	\param sample_time See \ref TimeCorrelator for this parameter.
-	
-	\param length See \ref Correlator for this parameter.
-	
-	\param scaling This parameter controls how exponentially fast
-	the correlators grow. By default, the correlators double in
-	sample_time whenever a new one is added.
+
+	\param length The number of correlation times stored for each
+	power of length (see \ref MultipleTauCorrelator).
        */
-      void resize(double sample_time, size_t length, size_t scaling = 2)
+      void resize(double sample_time, size_t length)
       {
-	if ((sample_time <= 0) || (length == 0))
-	  M_throw() << "LogarithmicTimeCorrelator requires a positive, non-zero sample time and a non-zero length, sample_time=" << sample_time
+	if ((sample_time <= 0) || (length < 2))
+	  M_throw() << "LogarithmicTimeCorrelator requires a positive, non-zero sample time and a length of at least 2, sample_time=" << sample_time
 		    << ", length=" << length;
-	
+
 	_sample_time = sample_time;
-	_length = length;
-	_scaling = scaling;
+	_correlator = MultipleTauCorrelator<T>(length);
 	clear();
       }
 
       void clear()
       {
 	_current_time = 0;
-	_freestream_values = _freestream_sum = _impulse_sum= std::pair<T,T>();
-	_sample_time /= (1 << _correlators.size());
-	_correlators.clear();
+	_freestream_values = _W_sums = std::pair<T,T>();
+	_correlator.clear();
       }
 
       /*! \brief See \ref TimeCorrelator::addImpulse(). */
@@ -314,11 +440,8 @@ namespace magnet {
       /*! \brief See \ref TimeCorrelator::addImpulse(). */
       void addImpulse(const T& val1, const T& val2)
       {
-	_impulse_sum.first += val1; 
-	_impulse_sum.second += val2;
-
-	for (Correlator& correlator : _correlators)
-	  correlator.addImpulse(val1, val2);
+	_W_sums.first += val1;
+	_W_sums.second += val2;
       }
 
       const T& getFreeStreamValue() const { return _freestream_values.first; }
@@ -332,50 +455,25 @@ namespace magnet {
       void setFreeStreamValue(const T& val1, const T& val2)
       {
 	_freestream_values = std::pair<T,T>(val1, val2);
-
-	for (Correlator& correlator : _correlators)
-	  correlator.setFreeStreamValue(val1, val2);
       }
 
       /*! \brief See \ref TimeCorrelator::freeStream(). */
-      void freeStream(const double dt)
+      void freeStream(double dt)
       {
-	//Check if we need to add a new correlators as we've accessed
-	//longer time scales
 	while ((_current_time + dt) >= _sample_time)
 	  {
-	    //Add a new correlator
-	    _correlators.push_back(Correlator(_sample_time, _length));
-	    _sample_time *= _scaling;
-	    
-	    //Pretend the correlator has actually been here all along, gathering impulse data
-	    Correlator& new_correlator = _correlators.back();
-	    new_correlator.addImpulse(_impulse_sum.first, _impulse_sum.second);
-
-	    //Also fake a freestream integration, it is fine to fake
-	    //this as the correlators cant resolve smaller than a
-	    //_sample_time.
-	    new_correlator.setFreeStreamValue(_freestream_sum.first / _current_time, _freestream_sum.second / _current_time);
-	    new_correlator.freeStream(_current_time);
-
-	    //Set the correct free streaming value
-	    new_correlator.setFreeStreamValue(_freestream_values.first, _freestream_values.second);
-	  }
-
-	//Free stream the correlators
-	for (auto correlator_ptr = _correlators.begin(); correlator_ptr != _correlators.end(); ++correlator_ptr )
-	  {
-	    const size_t loopcount = correlator_ptr->freeStream(dt);
+	    const double deltat = _sample_time - _current_time;
+	    _W_sums.first += _freestream_values.first * deltat;
+	    _W_sums.second += _freestream_values.second * deltat;
+	    _correlator.push(_W_sums.first, _W_sums.second);
 
-	    //Check that no correlator is doing too much work per
-	    //freestream and needs to be discarded (e.g. the system
-	    //mean free time is increasing, causing the correlators to
-	    //bottleneck the calculations).
-	    if (loopcount > 5) correlator_ptr = _correlators.erase(correlator_ptr);
+	    _W_sums = std::pair<T,T>();
+	    _current_time = 0;
+	    dt -= deltat;
 	  }
 
-	_freestream_sum.first += _freestream_values.first * dt;
-	_freestream_sum.second += _freestream_values.second * dt;
+	_W_sums.first += _freestream_values.first * dt;
+	_W_sums.second += _freestream_values.second * dt;
 	_current_time += dt;
       }
 
@@ -391,52 +489,23 @@ namespace magnet {
 	T value;
       };
 
-      /*! \brief A method to calculate and combine the average
-          correlators from all of the contained generated Correlator
-          classes.
-	  
-	  The first correlator (one with the smallest _sample_time) is
-	  outputted in its entirety, followed by the non-overlapping
-	  parts of every other correlator.
+      /*! \brief Returns the averaged correlator at each of the
+          correlation times collected.
        */
-      std::vector<Data> getAveragedCorrelator()
+      std::vector<Data> getAveragedCorrelator() const
       {
 	std::vector<Data> avg_correlator;
-
-	if (!_correlators.empty())
-	  {
-	    {
-	      std::vector<T> result = _correlators.front().getAveragedCorrelator();
-	      
-	      for (size_t i(0); i < result.size(); ++i)
-		avg_correlator.push_back(Data(_correlators.front().getSampleTime() * (i+1), 
-					      _correlators.front().getSampleCount(i), result[i]));
-	    }
-
-	    //Now copy the rest of the correlators
-	    for (size_t i(1); i < _correlators.size(); ++i)
-	      {
-		std::vector<T> result = _correlators[i].getAveragedCorrelator();
-		for (size_t j(_length / _scaling); j < result.size(); ++j) 
-		  avg_correlator.push_back(Data(_correlators[i].getSampleTime() * (j+1),
-						_correlators[i].getSampleCount(j), result[j]));
-	      }
-	  }
+	for (const typename MultipleTauCorrelator<T>::Data& data : _correlator.getAveragedCorrelator())
+	  avg_correlator.push_back(Data(_sample_time * data.lag, data.sample_count, data.value));
 	return avg_correlator;
       }
 
-
     protected:
       double _sample_time;
       double _current_time;
-      size_t _length;
-      size_t _scaling;
       std::pair<T,T> _freestream_values;
-      std::pair<T,T> _impulse_sum;
-      std::pair<T,T> _freestream_sum;
-      
-      Container _correlators;
+      std::pair<T,T> _W_sums;
+      MultipleTauCorrelator<T> _correlator;
     };
   }
 }
-
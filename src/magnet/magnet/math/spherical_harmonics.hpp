@@ -0,0 +1,121 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <magnet/math/vector.hpp>
+#include <magnet/exception.hpp>
+#include <complex>
+#include <cmath>
+#include <vector>
+
+namespace magnet {
+  namespace math {
+    /*! \brief Evaluates every spherical harmonic \f$Y_l^m\f$ with
+        \f$l<L\f$ for a direction.
+
+      The harmonics are generated together using the recurrence
+      relations of the normalised associated Legendre functions, and
+      \f$e^{im\phi}\sin^m\theta\f$ is built from powers of \f$x+iy\f$,
+      so no trigonometric functions are evaluated. The polar axis is
+      the z axis, and the Condon-Shortley phase is included (matching
+      boost::math::spherical_harmonic).
+
+      Only \f$m\ge0\f$ is stored, the others are given by
+      \f$Y_l^{-m}=(-1)^m\,{Y_l^m}^*\f$.
+    */
+    class SphericalHarmonics
+    {
+    public:
+      /*! \brief Constructor.
+
+	\param L The number of degrees to evaluate (\f$l=0\ldots L-1\f$).
+       */
+      SphericalHarmonics(size_t L):
+	_L(L), _values(size(L)), _a(size(L)), _b(size(L)), _diag(L)
+      {
+	if (!L)
+	  M_throw() << "At least one degree of spherical harmonic must be evaluated";
+
+	for (size_t m(1); m < L; ++m)
+	  _diag[m] = -std::sqrt((2.0 * m + 1.0) / (2.0 * m));
+
+	for (size_t l(1); l < L; ++l)
+	  for (size_t m(0); m < l; ++m)
+	    {
+	      const double l2 = l * l, m2 = m * m;
+	      _a[index(l, m)] = std::sqrt((4.0 * l2 - 1.0) / (l2 - m2));
+	      _b[index(l, m)] = std::sqrt(((l - 1.0) * (l - 1.0) - m2) / (4.0 * (l - 1.0) * (l - 1.0) - 1.0));
+	    }
+      }
+
+      //! \brief The number of values stored for L degrees.
+      static size_t size(size_t L) { return L * (L + 1) / 2; }
+
+      //! \brief The position of \f$Y_l^m\f$ (with \f$m\ge0\f$) in values().
+      static size_t index(size_t l, size_t m) { return l * (l + 1) / 2 + m; }
+
+      /*! \brief Evaluate the harmonics for a direction.
+	
+	\param r A unit vector.
+       */
+      void evaluate(const Vector& r)
+      {
+	const std::complex<double> xy(r[0], r[1]);
+	const double z = r[2];
+
+	//The sectoral harmonics, l = m
+	_values[0] = std::complex<double>(0.5 / std::sqrt(M_PI), 0);
+	for (size_t m(1); m < _L; ++m)
+	  _values[index(m, m)] = _diag[m] * xy * _values[index(m - 1, m - 1)];
+
+	//The recurrence in l for each m
+	for (size_t m(0); m + 1 < _L; ++m)
+	  {
+	    _values[index(m + 1, m)] = std::sqrt(2.0 * m + 3.0) * z * _values[index(m, m)];
+	    for (size_t l(m + 2); l < _L; ++l)
+	      {
+		const size_t i = index(l, m);
+		_values[i] = _a[i] * (z * _values[index(l - 1, m)] - _b[i] * _values[index(l - 2, m)]);
+	      }
+	  }
+      }
+
+      //! \brief The harmonics, in the order given by index().
+      const std::vector<std::complex<double> >& values() const { return _values; }
+
+      //! \brief The harmonic \f$Y_l^m\f$ for any \f$m\f$.
+      std::complex<double> operator()(size_t l, int m) const
+      {
+	if (m >= 0)
+	  return _values[index(l, m)];
+	const std::complex<double> val = std::conj(_values[index(l, -m)]);
+	return (m % 2) ? -val : val;
+      }
+
+      size_t getL() const { return _L; }
+
+    private:
+      size_t _L;
+      std::vector<std::complex<double> > _values;
+      //! \brief The coefficients of the recurrence in l.
+      std::vector<double> _a;
+      std::vector<double> _b;
+      //! \brief The coefficients of the recurrence along l = m.
+      std::vector<double> _diag;
+    };
+  }
+}
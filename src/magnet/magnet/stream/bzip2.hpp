@@ -0,0 +1,221 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file bzip2.hpp
+ * \brief Block-parallel bzip2 compression and decompression.
+ */
+
+#pragma once
+
+#include <magnet/exception.hpp>
+#include <magnet/thread/threadpool.hpp>
+#include <bzlib.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace magnet {
+  namespace stream {
+    namespace detail {
+      /*! \brief The number of worker threads to use for bzip2
+	  blocks, zero means the calling thread does all the work.*/
+      inline size_t bzip2Threads()
+      {
+	const size_t threads = std::thread::hardware_concurrency();
+	return (threads > 1) ? threads : 0;
+      }
+
+      /*! \brief Decompress a single bzip2 stream from the start of
+	  the passed data, appending the result to out.
+
+	\param compressedSize If not NULL, set to the number of bytes
+	of the stream (the remaining data may hold further streams).
+	Otherwise the stream must use all of the passed data.
+	\return false if the data is not a valid bzip2 stream.
+       */
+      inline bool bzip2DecompressStream(const char* data, const size_t size, std::string& out,
+					size_t* compressedSize = NULL)
+      {
+	bz_stream strm;
+	std::memset(&strm, 0, sizeof(strm));
+	if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK)
+	  return false;
+
+	strm.next_in = const_cast<char*>(data);
+	strm.avail_in = std::min(size, size_t(1) << 30);
+	size_t length = out.size();
+	int status = BZ_OK;
+	while (status == BZ_OK)
+	  {
+	    if (length == out.size())
+	      out.resize(std::max(2 * out.size(), length + 4 * size + 1024 * 1024));
+
+	    const size_t request = std::min(out.size() - length, size_t(1) << 30);
+	    strm.next_out = &out[length];
+	    strm.avail_out = request;
+	    status = BZ2_bzDecompress(&strm);
+	    length += request - strm.avail_out;
+
+	    //Refill the input (only for streams over 1GB)
+	    if ((status == BZ_OK) && (strm.avail_in == 0))
+	      {
+		const size_t used = strm.next_in - data;
+		if (used == size) break;
+		strm.avail_in = std::min(size - used, size_t(1) << 30);
+	      }
+	  }
+
+	const size_t used = strm.next_in - data;
+	BZ2_bzDecompressEnd(&strm);
+	out.resize(length);
+
+	if (status != BZ_STREAM_END)
+	  return false;
+
+	if (compressedSize)
+	  *compressedSize = used;
+	else if (used != size)
+	  return false;
+	return true;
+      }
+
+      /*! \brief Test for the start of a bzip2 stream ("BZh" and the
+	  block size, followed by the block header magic).*/
+      inline bool isBzip2StreamStart(const unsigned char* p)
+      {
+	return (p[0] == 'B') && (p[1] == 'Z') && (p[2] == 'h') && (p[3] >= '1') && (p[3] <= '9')
+	  && (p[4] == 0x31) && (p[5] == 0x41) && (p[6] == 0x59) && (p[7] == 0x26) && (p[8] == 0x53) && (p[9] == 0x59);
+      }
+    }
+
+    /*! \brief Compress data into a bzip2 file in parallel.
+
+      In the style of pbzip2, the data is split into 900kB blocks
+      which are compressed concurrently into independent bzip2
+      streams. The streams are concatenated in order, which is a valid
+      bzip2 file for any bzip2 decompressor.
+
+      \param data The data to compress.
+      \param size The number of bytes of data.
+      \return The compressed file.
+     */
+    inline std::string bzip2_compress(const char* data, const size_t size)
+    {
+      const size_t blockSize = 900000;
+      const size_t blocks = std::max(size_t(1), (size + blockSize - 1) / blockSize);
+      std::vector<std::string> compressed(blocks);
+      std::vector<int> errors(blocks, BZ_OK);
+
+      magnet::thread::ThreadPool pool;
+      pool.setThreadCount(std::min(blocks, detail::bzip2Threads()));
+      for (size_t i(0); i < blocks; ++i)
+	pool.queueTask([&, i]() {
+	    const size_t start = i * blockSize;
+	    const size_t length = std::min(blockSize, size - std::min(size, start));
+	    //The bzip2 documented upper bound on the compressed size
+	    unsigned int destLength = length + length / 100 + 600;
+	    compressed[i].resize(destLength);
+	    errors[i] = BZ2_bzBuffToBuffCompress(&compressed[i][0], &destLength, const_cast<char*>(data + start),
+						 length, 9, 0, 0);
+	    compressed[i].resize(destLength);
+	  });
+      pool.wait();
+
+      size_t total = 0;
+      for (size_t i(0); i < blocks; ++i)
+	{
+	  if (errors[i] != BZ_OK)
+	    M_throw() << "bzip2 compression failed (bzerror=" << errors[i] << ")";
+	  total += compressed[i].size();
+	}
+
+      std::string retval;
+      retval.reserve(total);
+      for (const std::string& block : compressed)
+	retval.append(block);
+      return retval;
+    }
+
+    /*! \brief Decompress a bzip2 file, in parallel where possible.
+
+      Files made from several concatenated streams (such as those of
+      bzip2_compress and pbzip2) are split at the stream headers and
+      the streams are decompressed concurrently. A stream header may
+      also appear by chance inside the compressed data, so if any
+      stream fails to decompress the whole file is decompressed
+      serially instead.
+
+      \param data The compressed file.
+      \param size The number of bytes of compressed data.
+      \param out The decompressed data.
+     */
+    inline void bzip2_decompress(const char* data, const size_t size, std::string& out)
+    {
+      const unsigned char* udata = reinterpret_cast<const unsigned char*>(data);
+      std::vector<size_t> starts;
+      for (size_t i(0); i + 10 <= size; ++i)
+	{
+	  const void* next = std::memchr(udata + i, 'B', size - i);
+	  if (!next) break;
+	  i = static_cast<const unsigned char*>(next) - udata;
+	  if ((i + 10 <= size) && detail::isBzip2StreamStart(udata + i))
+	    starts.push_back(i);
+	}
+
+      if ((starts.size() > 1) && (starts.front() == 0))
+	{
+	  starts.push_back(size);
+	  const size_t streams = starts.size() - 1;
+	  std::vector<std::string> blocks(streams);
+	  std::vector<char> valid(streams, false);
+
+	  magnet::thread::ThreadPool pool;
+	  pool.setThreadCount(std::min(streams, detail::bzip2Threads()));
+	  for (size_t i(0); i < streams; ++i)
+	    pool.queueTask([&, i]() {
+		valid[i] = detail::bzip2DecompressStream(data + starts[i], starts[i + 1] - starts[i], blocks[i]);
+	      });
+	  pool.wait();
+
+	  if (std::find(valid.begin(), valid.end(), false) == valid.end())
+	    {
+	      size_t total = 0;
+	      for (const std::string& block : blocks)
+		total += block.size();
+	      out.clear();
+	      out.reserve(total);
+	      for (const std::string& block : blocks)
+		out.append(block);
+	      return;
+	    }
+	}
+
+      //Serial decompression, one stream after another. The output is
+      //pre-sized from the compressed size.
+      out.clear();
+      out.reserve(std::max(8 * size, size_t(1024 * 1024)));
+      size_t offset = 0;
+      do {
+	size_t used;
+	if (!detail::bzip2DecompressStream(data + offset, size - offset, out, &used))
+	  M_throw() << "Failed while decompressing bzip2 data (stream at byte " << offset << " is corrupt)";
+	offset += used;
+      } while (offset < size);
+    }
+  }
+}
@@ -0,0 +1,311 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace magnet {
+  namespace string {
+    namespace detail {
+      /*! \brief The powers of ten which are exactly representable
+	  as doubles (0 <= exponent <= 22).*/
+      inline double pow10(const int exponent)
+      {
+	static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+					1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+					1e20, 1e21, 1e22};
+	return powers[exponent];
+      }
+    }
+
+    /*! \brief Parse a double from a character range without
+        allocating.
+
+      This is a replacement for boost::lexical_cast<double> in the
+      bulk XML loading paths. Plain decimal values with at most 15
+      significant digits and a small exponent are converted exactly
+      using a single multiplication or division (Clinger's fast path),
+      all other values are passed to strtod. In both cases the result
+      is the correctly rounded value of the text.
+
+      \param first The start of the text.
+      \param last One past the end of the text.
+      \param value Set to the parsed value on success.
+      \return true if the whole range was a valid number.
+     */
+    inline bool parse_double(const char* first, const char* last, double& value)
+    {
+      const char* p = first;
+      const bool negative = (p != last) && (*p == '-');
+      if ((p != last) && ((*p == '-') || (*p == '+'))) ++p;
+
+      uint64_t mantissa = 0;
+      int significant = 0, exponent = 0;
+      bool digits = false;
+      for (; (p != last) && (*p >= '0') && (*p <= '9'); ++p, digits = true)
+	{
+	  mantissa = mantissa * 10 + (*p - '0');
+	  significant += (mantissa != 0);
+	}
+
+      if ((p != last) && (*p == '.'))
+	for (++p; (p != last) && (*p >= '0') && (*p <= '9'); ++p, digits = true)
+	  {
+	    mantissa = mantissa * 10 + (*p - '0');
+	    significant += (mantissa != 0);
+	    --exponent;
+	  }
+
+      if (digits && (p != last) && ((*p == 'e') || (*p == 'E')))
+	{
+	  ++p;
+	  const bool negExp = (p != last) && (*p == '-');
+	  if ((p != last) && ((*p == '-') || (*p == '+'))) ++p;
+	  int e = 0;
+	  bool expDigits = false;
+	  for (; (p != last) && (*p >= '0') && (*p <= '9') && (e < 10000); ++p, expDigits = true)
+	    e = e * 10 + (*p - '0');
+	  if (!expDigits) return false;
+	  exponent += negExp ? -e : e;
+	}
+
+      if (digits && (p == last) && (significant <= 15) && (exponent >= -22) && (exponent <= 22))
+	{
+	  value = double(mantissa);
+	  value = (exponent < 0) ? value / detail::pow10(-exponent) : value * detail::pow10(exponent);
+	  if (negative) value = -value;
+	  return true;
+	}
+
+      //Slow path, this also handles long mantissas, large exponents,
+      //inf and nan. Leading whitespace is rejected to match
+      //boost::lexical_cast.
+      char buf[64];
+      const size_t length = last - first;
+      if ((length == 0) || (length >= sizeof(buf)) || (*first == ' ') || (*first == '\t') || (*first == '\n'))
+	return false;
+      std::memcpy(buf, first, length);
+      buf[length] = '\0';
+      char* end;
+      value = std::strtod(buf, &end);
+      return end == buf + length;
+    }
+
+    /*! \brief Parse an unsigned integer from a character range
+        without allocating.
+
+      \return true if the whole range was a plain decimal integer
+      which fits in T.
+     */
+    template<class T>
+    inline bool parse_unsigned(const char* first, const char* last, T& value)
+    {
+      if (first == last) return false;
+      T result = 0;
+      for (const char* p = first; p != last; ++p)
+	{
+	  if ((*p < '0') || (*p > '9')) return false;
+	  const T digit = *p - '0';
+	  if (result > (std::numeric_limits<T>::max() - digit) / 10) return false;
+	  result = result * 10 + digit;
+	}
+      value = result;
+      return true;
+    }
+
+    namespace detail {
+      /*! \brief Write a decimal significand and exponent using the
+	  printf %g style.
+
+	\param digits The significant digits (without trailing zeros).
+	\param count The number of digits.
+	\param exponent The decimal exponent of the first digit.
+	\param precision The %g precision, which decides between
+	fixed and scientific notation.
+       */
+      inline int write_general(char* buf, const bool negative, const char* digits, int count,
+			       const int exponent, const int precision)
+      {
+	char* out = buf;
+	if (negative) *out++ = '-';
+
+	if ((exponent < -4) || (exponent >= precision))
+	  {
+	    *out++ = digits[0];
+	    if (count > 1)
+	      {
+		*out++ = '.';
+		for (int i(1); i < count; ++i) *out++ = digits[i];
+	      }
+	    out += std::sprintf(out, "e%c%02d", (exponent < 0) ? '-' : '+', std::abs(exponent));
+	    return out - buf;
+	  }
+
+	if (exponent < 0)
+	  {
+	    *out++ = '0';
+	    *out++ = '.';
+	    for (int i(-1); i > exponent; --i) *out++ = '0';
+	    for (int i(0); i < count; ++i) *out++ = digits[i];
+	  }
+	else
+	  {
+	    for (int i(0); i <= exponent; ++i) *out++ = (i < count) ? digits[i] : '0';
+	    if (count > exponent + 1)
+	      {
+		*out++ = '.';
+		for (int i(exponent + 1); i < count; ++i) *out++ = digits[i];
+	      }
+	  }
+	*out = '\0';
+	return out - buf;
+      }
+    }
+
+#ifdef __SIZEOF_INT128__
+    namespace detail {
+      /*! \brief Exact shortest formatting for doubles with
+	  magnitudes in [1e-5, 1e15], using 128 bit integer arithmetic.
+
+	The value m 2^e is scaled by 10^k so that it has 17 integer
+	digits. The numerator of the scaled value, and the half-width
+	of the interval of reals which round to the value, both fit in
+	128 bits over this range of magnitudes. The 15 and 16 digit
+	roundings are tested against the interval exactly.
+
+	\return The number of characters written, or 0 if the value is
+	outside the supported range.
+       */
+      inline int format_shortest_exact(char* buf, const double value)
+      {
+	typedef unsigned __int128 uint128;
+	const double magnitude = std::abs(value);
+	if (!((magnitude >= 1e-5) && (magnitude <= 1e15)))
+	  return 0;
+
+	int e;
+	const uint64_t m = uint64_t(std::ldexp(std::frexp(magnitude, &e), 53));
+	e -= 53;
+	//The interval below a power of two is asymmetric
+	if (m == (uint64_t(1) << 52))
+	  return 0;
+
+	int X = int(std::floor(std::log10(magnitude)));
+	uint128 N, D, halfGap;
+	for (;;)
+	  {
+	    const int k = 16 - X;
+	    uint128 p10 = 1;
+	    for (int i(0); i < k; ++i) p10 *= 10;
+	    N = uint128(m) * p10;
+	    if (e < 0)
+	      {
+		D = uint128(1) << -e;
+		halfGap = p10;
+	      }
+	    else
+	      {
+		N <<= e;
+		D = 1;
+		halfGap = p10 << e;
+	      }
+
+	    const uint128 q = N / D;
+	    if (q >= uint128(100000000000000000ull)) ++X;
+	    else if (q < uint128(10000000000000000ull)) --X;
+	    else break;
+	  }
+
+	char digits[24];
+	int count = 0;
+	for (int n = std::numeric_limits<double>::digits10; ; ++n)
+	  {
+	    uint128 scale = 1;
+	    for (int i(n); i < 17; ++i) scale *= 10;
+	    const uint128 divisor = D * scale;
+	    uint128 r = N / divisor;
+	    if (2 * (N - r * divisor) >= divisor) ++r;
+
+	    //The candidate round trips if it is strictly within the
+	    //half-gap of the value
+	    const uint128 candidate = 2 * r * divisor;
+	    const uint128 twoN = 2 * N;
+	    const uint128 distance = (candidate > twoN) ? candidate - twoN : twoN - candidate;
+	    if ((distance < halfGap) || (n == 17))
+	      {
+		uint64_t integer = uint64_t(r);
+		char reversed[24];
+		while (integer) { reversed[count++] = '0' + integer % 10; integer /= 10; }
+		for (int i(0); i < count; ++i) digits[i] = reversed[count - 1 - i];
+		const int exponent = X + (count - n);
+		while ((count > 1) && (digits[count - 1] == '0')) --count;
+		return write_general(buf, value < 0, digits, count, exponent, n);
+	      }
+	  }
+      }
+    }
+#endif
+
+    /*! \brief Format a double into a character buffer.
+
+      If precision is at least max_digits10 (17), the shortest
+      representation (of 15, 16, or 17 significant digits) which
+      parses back to exactly the same value is written. Otherwise the
+      value is written with the requested number of significant
+      digits, matching iostream formatting with the default
+      floatfield.
+
+      Values with magnitudes in [1e-5, 1e15] (the vast majority of
+      simulation data) are formatted exactly using integer
+      arithmetic, other values fall back to printf.
+
+      \param buf The output buffer, which must hold at least 32
+      characters.
+      \return The number of characters written (excluding the
+      terminating zero).
+     */
+    inline int format_double(char* buf, const double value, const int precision)
+    {
+      const int maxDigits = std::numeric_limits<double>::max_digits10;
+      if ((precision < maxDigits) || !(std::abs(value) <= std::numeric_limits<double>::max()))
+	return std::snprintf(buf, 32, "%.*g", precision, value);
+
+#ifdef __SIZEOF_INT128__
+      if (value == 0)
+	return std::sprintf(buf, std::signbit(value) ? "-0" : "0");
+
+      if (const int length = detail::format_shortest_exact(buf, value))
+	return length;
+#endif
+
+      //Outside the range of the exact method, try each precision in
+      //turn
+      for (int digits = std::numeric_limits<double>::digits10; digits < maxDigits; ++digits)
+	{
+	  const int length = std::snprintf(buf, 32, "%.*g", digits, value);
+	  if (std::strtod(buf, NULL) == value)
+	    return length;
+	}
+      return std::snprintf(buf, 32, "%.*g", maxDigits, value);
+    }
+  }
+}
@@ -0,0 +1,186 @@
+/*  dynamo:- Event driven molecular dynamics simulator
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file background.hpp
+ * \brief Contains the definition of BackgroundTask
+ */
+
+#pragma once
+
+#include <magnet/exception.hpp>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace magnet {
+  namespace thread {
+    /*! \brief Runs tasks in order on a single background thread.
+
+      This is intended for work (e.g., periodic snapshots) which
+      should overlap with the calculation. The tasks are run one at a
+      time, in the order they were queued. At most depth tasks may be
+      queued or running at any time, and queueing a task waits until
+      there is space. This back-pressure bounds the memory held by
+      pending tasks. With the default depth of one, queueing a task
+      first waits for the previous task to complete.
+
+      Any exception thrown by a task is rethrown by the next call to
+      wait() or queueTask().
+     */
+    class BackgroundTask
+    {
+    public:
+      /*! \brief Constructor.
+	
+	\param depth The maximum number of tasks which may be queued
+	or running at any time.
+       */
+      BackgroundTask(size_t depth = 1):
+	_depth(depth), _running(false), _stop(false)
+      {
+	if (!_depth)
+	  M_throw() << "A BackgroundTask requires a depth of at least one";
+      }
+
+      /*! \brief Waits for all queued tasks to complete.
+
+        Exceptions cannot be thrown from here, so they are reported
+        on std::cerr.
+       */
+      ~BackgroundTask()
+      {
+	try { wait(); }
+	catch (std::exception& err)
+	  { std::cerr << "\nBackground task failed:-" << err.what() << std::endl; }
+
+	{
+	  std::lock_guard<std::mutex> lock(_mutex);
+	  _stop = true;
+	}
+	_queued.notify_all();
+
+	if (_thread.joinable())
+	  _thread.join();
+      }
+
+      /*! \brief Wait for all queued tasks to complete and rethrow any
+        exception they raised.
+       */
+      void wait()
+      {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this]() { return _tasks.empty() && !_running; });
+	rethrow();
+      }
+
+      /*! \brief Queue a task to run in the background, after the
+        previously queued tasks.
+
+	If depth tasks are already queued or running, this waits for
+	the oldest to complete.
+       */
+      void queueTask(std::function<void()> task)
+      {
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this]() { return _tasks.size() + _running < _depth; });
+	rethrow();
+
+	_tasks.push_back(task);
+	//The worker thread is only started once it is needed
+	if (!_thread.joinable())
+	  _thread = std::thread([this]() { worker(); });
+	_queued.notify_one();
+      }
+
+      /*! \brief Test if a task is currently queued or running. */
+      bool busy() const
+      {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return !_tasks.empty() || _running;
+      }
+
+      /*! \brief Set the maximum number of tasks which may be queued
+        or running at any time.
+       */
+      void setDepth(size_t depth)
+      {
+	if (!depth)
+	  M_throw() << "A BackgroundTask requires a depth of at least one";
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_depth = depth;
+      }
+
+      size_t getDepth() const { return _depth; }
+
+    private:
+      BackgroundTask(const BackgroundTask&) = delete;
+      BackgroundTask& operator=(const BackgroundTask&) = delete;
+
+      //! \brief Rethrow a stored exception, the mutex must be held.
+      void rethrow()
+      {
+	if (_error)
+	  {
+	    std::exception_ptr error;
+	    std::swap(error, _error);
+	    std::rethrow_exception(error);
+	  }
+      }
+
+      void worker()
+      {
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true)
+	  {
+	    _queued.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+	    if (_tasks.empty()) return;
+
+	    std::function<void()> task = std::move(_tasks.front());
+	    _tasks.pop_front();
+	    _running = true;
+	    lock.unlock();
+
+	    std::exception_ptr error;
+	    try { task(); }
+	    catch (...) { error = std::current_exception(); }
+	    //The task is destroyed outside of the lock
+	    task = std::function<void()>();
+
+	    lock.lock();
+	    if (error && !_error)
+	      _error = error;
+	    _running = false;
+	    _done.notify_all();
+	  }
+      }
+
+      std::thread _thread;
+      mutable std::mutex _mutex;
+      std::condition_variable _queued;
+      std::condition_variable _done;
+      std::deque<std::function<void()> > _tasks;
+      std::exception_ptr _error;
+      size_t _depth;
+      bool _running;
+      bool _stop;
+    };
+  }
+}
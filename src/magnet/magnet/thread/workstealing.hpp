@@ -0,0 +1,516 @@
+/*  dynamo:- Event driven molecular dynamics simulator 
+    http://www.dynamomd.org
+    Copyright (C) 2011  Marcus N Campbell Bannerman <m.bannerman@gmail.com>
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    version 3 as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*! \file workstealing.hpp
+ * \brief Contains the definition of WorkStealingPool
+ */
+
+#pragma once
+
+#include <magnet/thread/threadgroup.hpp>
+#include <magnet/exception.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace magnet {
+  namespace thread {
+    class WorkStealingPool;
+    class TaskGroup;
+
+    namespace detail {
+      /*! \brief A unit of work for the WorkStealingPool.
+       */
+      struct StealableTask
+      {
+	std::function<void()> func;
+	TaskGroup* group;
+      };
+
+      /*! \brief A lock-free Chase-Lev work-stealing deque.
+	
+	The owning thread pushes and takes from the bottom of the
+	deque, while any other thread may steal from the top. This
+	implements the C11 memory model version of the algorithm
+	described in "Correct and Efficient Work-Stealing for Weak
+	Memory Models" (Le, Pop, Cohen and Zappa Nardelli, PPoPP
+	2013).
+
+	When the deque is full the storage is doubled. The old arrays
+	may still be read by concurrent thieves, so they are only freed
+	when the deque is destroyed.
+       */
+      class WorkStealingDeque
+      {
+	struct Array
+	{
+	  Array(int64_t cap): capacity(cap), data(new std::atomic<StealableTask*>[cap]) {}
+	  
+	  StealableTask* get(int64_t i) const 
+	  { return data[i & (capacity - 1)].load(std::memory_order_relaxed); }
+
+	  void put(int64_t i, StealableTask* task) 
+	  { data[i & (capacity - 1)].store(task, std::memory_order_relaxed); }
+
+	  const int64_t capacity;
+	  std::unique_ptr<std::atomic<StealableTask*>[]> data;
+	};
+
+      public:
+	WorkStealingDeque(int64_t capacity = 256):
+	  _top(0), _bottom(0)
+	{
+	  _arrays.emplace_back(new Array(capacity));
+	  _array.store(_arrays.back().get(), std::memory_order_relaxed);
+	}
+
+	/*! \brief Push a task onto the bottom of the deque (owner only). */
+	void push(StealableTask* task)
+	{
+	  const int64_t b = _bottom.load(std::memory_order_relaxed);
+	  const int64_t t = _top.load(std::memory_order_acquire);
+	  Array* a = _array.load(std::memory_order_relaxed);
+
+	  if (b - t > a->capacity - 1)
+	    {
+	      Array* na = new Array(a->capacity * 2);
+	      for (int64_t i(t); i < b; ++i)
+		na->put(i, a->get(i));
+	      _arrays.emplace_back(na);
+	      _array.store(na, std::memory_order_release);
+	      a = na;
+	    }
+
+	  a->put(b, task);
+	  std::atomic_thread_fence(std::memory_order_release);
+	  _bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	/*! \brief Take a task from the bottom of the deque (owner only).
+	  
+	  \return The task or nullptr if the deque is empty.
+	 */
+	StealableTask* take()
+	{
+	  const int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+	  Array* a = _array.load(std::memory_order_relaxed);
+	  _bottom.store(b, std::memory_order_relaxed);
+	  std::atomic_thread_fence(std::memory_order_seq_cst);
+	  int64_t t = _top.load(std::memory_order_relaxed);
+
+	  if (t > b)
+	    {
+	      //Empty
+	      _bottom.store(b + 1, std::memory_order_relaxed);
+	      return nullptr;
+	    }
+
+	  StealableTask* task = a->get(b);
+	  if (t == b)
+	    {
+	      //Last item, race the thieves for it
+	      if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		task = nullptr;
+	      _bottom.store(b + 1, std::memory_order_relaxed);
+	    }
+	  return task;
+	}
+
+	/*! \brief Steal a task from the top of the deque (any thread).
+	  
+	  \return The task or nullptr if the deque is empty or the steal
+	  lost a race.
+	 */
+	StealableTask* steal()
+	{
+	  int64_t t = _top.load(std::memory_order_acquire);
+	  std::atomic_thread_fence(std::memory_order_seq_cst);
+	  const int64_t b = _bottom.load(std::memory_order_acquire);
+	  
+	  if (t >= b) return nullptr;
+
+	  Array* a = _array.load(std::memory_order_acquire);
+	  StealableTask* task = a->get(t);
+	  if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	    return nullptr;
+	  return task;
+	}
+
+	/*! \brief A (racy) test if the deque is empty. */
+	bool empty() const
+	{ return _bottom.load(std::memory_order_seq_cst) <= _top.load(std::memory_order_seq_cst); }
+
+      private:
+	std::atomic<int64_t> _top;
+	std::atomic<int64_t> _bottom;
+	std::atomic<Array*> _array;
+	std::vector<std::unique_ptr<Array> > _arrays;
+
+	WorkStealingDeque(const WorkStealingDeque&);
+	WorkStealingDeque& operator=(const WorkStealingDeque&);
+      };
+    }
+
+    /*! \brief A set of tasks which can be waited on together.
+
+      Tasks are added to a group using TaskGroup::run(). Waiting on
+      the group does not block the calling thread, instead it helps to
+      execute queued tasks until every task of the group (including
+      any tasks they spawn into the group) has completed.
+     */
+    class TaskGroup
+    {
+    public:
+      inline TaskGroup(WorkStealingPool& pool): _pool(pool), _pending(0) {}
+
+      inline ~TaskGroup() throw();
+
+      /*! \brief Queue a task as part of this group. */
+      inline void run(std::function<void()> func);
+
+      /*! \brief Wait for all tasks in the group to complete.
+
+	Any exceptions thrown by the tasks are rethrown here.
+       */
+      inline void wait();
+
+      /*! \brief Test if all tasks of this group have completed. */
+      inline bool done() const { return _pending.load() == 0; }
+
+    private:
+      friend class WorkStealingPool;
+
+      inline void taskComplete() { --_pending; }
+
+      inline void taskFailed(const std::string& what)
+      {
+	std::lock_guard<std::mutex> lock(_exception_mutex);
+	_exception_data << "\nTHREAD: Task threw an exception:-" << what;
+      }
+
+      WorkStealingPool& _pool;
+      std::atomic<size_t> _pending;
+      std::mutex _exception_mutex;
+      std::ostringstream _exception_data;
+
+      TaskGroup(const TaskGroup&);
+      TaskGroup& operator=(const TaskGroup&);
+    };
+
+    /*! \brief A pool of worker threads using work stealing to
+      distribute tasks.
+
+      Each worker thread owns a lock-free deque of tasks. Tasks
+      spawned by a worker are pushed onto its own deque and idle
+      workers steal from the other deques, so fine-grained tasks do
+      not contend on a single shared queue like the ThreadPool. Tasks
+      queued from outside the pool go into a mutex protected
+      injection queue.
+
+      The queueTask()/queueTasks()/wait() interface is the same as the
+      ThreadPool, and it also supports running in 0 thread mode,
+      where the thread calling wait() executes the tasks.
+
+      For structured parallelism, see TaskGroup and parallel_for().
+     */
+    class WorkStealingPool
+    {
+    public:
+      inline WorkStealingPool():
+	_default_group(*this),
+	_stop_flag(false),
+	_sleeping(0)
+      {}
+
+      inline ~WorkStealingPool() throw() { stop(); }
+
+      /*! \brief Set the number of worker threads in the pool.
+
+	Changing the number of threads waits for all queued tasks to
+	complete, stops all the threads, then starts the new set.
+       */
+      inline void setThreadCount(size_t x)
+      {
+	if (x == _workers.size()) return;
+
+	_default_group.wait();
+	stop();
+	_stop_flag = false;
+
+	_workers.clear();
+	for (size_t i(0); i < x; ++i)
+	  _workers.emplace_back(new detail::WorkStealingDeque);
+
+	for (size_t i(0); i < x; ++i)
+	  _threads.create_thread(std::function<void()>(std::bind(&WorkStealingPool::beginThread, this, i)));
+      }
+
+      /*! \brief The current number of threads in the pool */
+      inline size_t getThreadCount() const { return _workers.size(); }
+
+      /*! \brief Queue a task (ThreadPool compatible interface). */
+      inline void queueTask(std::function<void()> threadfunc)
+      { _default_group.run(threadfunc); }
+
+      /*! \brief Queue several tasks (ThreadPool compatible interface). */
+      inline void queueTasks(std::vector<std::function<void()> >& threadfuncs)
+      {
+	for (auto& func : threadfuncs)
+	  _default_group.run(func);
+	threadfuncs.clear();
+      }
+
+      /*! \brief Wait for all tasks queued with queueTask() or
+	queueTasks() to complete (ThreadPool compatible interface).
+       */
+      inline void wait() { _default_group.wait(); }
+
+      /*! \brief Execute func(i) for every i in [begin, end) in parallel.
+
+	The range is recursively split in half until the pieces are
+	no larger than grain, each split being a separate stealable
+	task. This allows idle threads to steal large pieces of work
+	while keeping the per-task overhead low.
+
+	\param grain The maximum number of indices executed in a single
+	task. If zero, a grain size is chosen to create approximately 8
+	tasks per thread.
+       */
+      template<class F>
+      inline void parallel_for(size_t begin, size_t end, F func, size_t grain = 0)
+      {
+	if (end <= begin) return;
+
+	if (!grain)
+	  grain = std::max(size_t(1), (end - begin) / (8 * std::max(size_t(1), getThreadCount())));
+
+	TaskGroup group(*this);
+	parallel_for_range(group, begin, end, func, grain);
+	group.wait();
+      }
+
+    private:
+      friend class TaskGroup;
+
+      template<class F>
+      inline void parallel_for_range(TaskGroup& group, size_t begin, size_t end, F func, size_t grain)
+      {
+	while (end - begin > grain)
+	  {
+	    const size_t mid = begin + (end - begin) / 2;
+	    group.run([this, &group, mid, end, func, grain]() { parallel_for_range(group, mid, end, func, grain); });
+	    end = mid;
+	  }
+
+	for (size_t i(begin); i < end; ++i)
+	  func(i);
+      }
+
+      /*! \brief The index of the worker deque owned by the current
+	thread, or -1 for threads outside this pool.
+       */
+      inline int& workerID()
+      {
+	static thread_local int id = -1;
+	return id;
+      }
+
+      inline WorkStealingPool*& workerPool()
+      {
+	static thread_local WorkStealingPool* pool = nullptr;
+	return pool;
+      }
+
+      inline int localWorker() { return (workerPool() == this) ? workerID() : -1; }
+
+      /*! \brief Add a task to the pool. */
+      inline void submit(detail::StealableTask* task)
+      {
+	const int id = localWorker();
+	if (id >= 0)
+	  _workers[id]->push(task);
+	else
+	  {
+	    std::lock_guard<std::mutex> lock(_inject_mutex);
+	    _injected.push_back(task);
+	  }
+
+	if (_sleeping.load())
+	  {
+	    std::lock_guard<std::mutex> lock(_sleep_mutex);
+	    _sleep_condition.notify_one();
+	  }
+      }
+
+      /*! \brief Find a task for the current thread to execute.
+
+	The thread's own deque is checked first, then the injection
+	queue, then the other workers are stolen from.
+       */
+      inline detail::StealableTask* findTask()
+      {
+	const int id = localWorker();
+	detail::StealableTask* task = nullptr;
+	
+	if (id >= 0)
+	  {
+	    task = _workers[id]->take();
+	    if (task) return task;
+	  }
+
+	{
+	  std::lock_guard<std::mutex> lock(_inject_mutex);
+	  if (!_injected.empty())
+	    {
+	      task = _injected.front();
+	      _injected.pop_front();
+	      return task;
+	    }
+	}
+
+	const size_t N = _workers.size();
+	const size_t start = (id >= 0) ? id + 1 : 0;
+	for (size_t i(0); i < N; ++i)
+	  {
+	    const size_t victim = (start + i) % N;
+	    if (int(victim) == id) continue;
+	    task = _workers[victim]->steal();
+	    if (task) return task;
+	  }
+	
+	return nullptr;
+      }
+
+      inline bool workAvailable()
+      {
+	{
+	  std::lock_guard<std::mutex> lock(_inject_mutex);
+	  if (!_injected.empty()) return true;
+	}
+
+	for (const auto& worker : _workers)
+	  if (!worker->empty()) return true;
+	return false;
+      }
+
+      inline void execute(detail::StealableTask* task)
+      {
+	try { task->func(); }
+	catch (std::exception& cep)
+	  { task->group->taskFailed(cep.what()); }
+	
+	TaskGroup* group = task->group;
+	delete task;
+	group->taskComplete();
+      }
+
+      /*! \brief Thread worker loop. */
+      inline void beginThread(size_t id)
+      {
+	workerID() = id;
+	workerPool() = this;
+
+	while (!_stop_flag)
+	  {
+	    detail::StealableTask* task = findTask();
+	    if (task)
+	      {
+		execute(task);
+		continue;
+	      }
+
+	    //Nothing to do, go to sleep. The sleeping counter is
+	    //incremented before the final check for work, so a
+	    //submitting thread will always see it and notify us.
+	    std::unique_lock<std::mutex> lock(_sleep_mutex);
+	    ++_sleeping;
+	    if (!_stop_flag && !workAvailable())
+	      _sleep_condition.wait_for(lock, std::chrono::milliseconds(10));
+	    --_sleeping;
+	  }
+
+	workerPool() = nullptr;
+	workerID() = -1;
+      }
+
+      inline void stop()
+      {
+	{
+	  std::lock_guard<std::mutex> lock(_sleep_mutex);
+	  _stop_flag = true;
+	}
+	_sleep_condition.notify_all();
+	_threads.join_all();
+      }
+
+      TaskGroup _default_group;
+      std::vector<std::unique_ptr<detail::WorkStealingDeque> > _workers;
+      std::deque<detail::StealableTask*> _injected;
+      std::mutex _inject_mutex;
+      std::mutex _sleep_mutex;
+      std::condition_variable _sleep_condition;
+      std::atomic<bool> _stop_flag;
+      std::atomic<size_t> _sleeping;
+      magnet::thread::ThreadGroup _threads;
+
+      WorkStealingPool(const WorkStealingPool&);
+      WorkStealingPool& operator=(const WorkStealingPool&);
+    };
+
+    inline TaskGroup::~TaskGroup() throw() 
+    { 
+      //Tasks hold a pointer to the group, so it cannot be destroyed
+      //while they are outstanding.
+      try { wait(); } catch (...) {}
+    }
+
+    inline void TaskGroup::run(std::function<void()> func)
+    {
+      ++_pending;
+      _pool.submit(new detail::StealableTask{func, this});
+    }
+
+    inline void TaskGroup::wait()
+    {
+      while (!done())
+	{
+	  detail::StealableTask* task = _pool.findTask();
+	  if (task)
+	    _pool.execute(task);
+	  else
+	    std::this_thread::yield();
+	}
+
+      std::lock_guard<std::mutex> lock(_exception_mutex);
+      const std::string errors = _exception_data.str();
+      if (!errors.empty())
+	{
+	  _exception_data.str("");
+	  M_throw() << "Thread Exception found while waiting for tasks/threads to finish"
+		    << errors;
+	}
+    }
+  }
+}
@@ -19,10 +19,20 @@
 
 #include <rapidXML/rapidxml.hpp>
 #include <magnet/exception.hpp>
+#include <magnet/string/numeric.hpp>
 #include <boost/lexical_cast.hpp>
 #ifdef DYNAMO_bzip2_support
-# include <bzlib.h>
+# include <magnet/stream/bzip2.hpp>
 #endif
+#ifdef __unix__
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -74,14 +84,7 @@ namespace magnet {
     public:
       //! \brief Converts the attributes value to a type.
       template<class T> inline T as() const 
-      { 
-	try {
-	  return boost::lexical_cast<T>(getValue());
-	} catch (boost::bad_lexical_cast&)
-	  {
-	    M_throw() << "The value \"" << getValue() << "\" will not cast to the correct type. Please check the attribute at the following XMLPath: " << getPath();
-	  }
-      }
+      { return lexicalCast<T>(); }
 
       /*! \brief Returns the value of the attribute.
        */
@@ -119,6 +122,19 @@ namespace magnet {
     private:
       friend class Node;
 
+      /*! \brief Converts the attributes value to a type using
+          boost::lexical_cast.
+       */
+      template<class T> inline T lexicalCast() const
+      {
+	try {
+	  return boost::lexical_cast<T>(getValue());
+	} catch (boost::bad_lexical_cast&)
+	  {
+	    M_throw() << "The value \"" << getValue() << "\" will not cast to the correct type. Please check the attribute at the following XMLPath: " << getPath();
+	  }
+      }
+
       /*! \brief Hidden default constructor to stop its use.
        */
       Attribute();
@@ -132,6 +148,29 @@ namespace magnet {
       rapidxml::xml_node<> *_parent;
     };
 
+    /*! \brief Fast conversion of doubles, which avoids the string
+        copy and locale handling of boost::lexical_cast. This is the
+        bulk of the work when loading large configurations.
+     */
+    template<> inline double Attribute::as<double>() const
+    {
+      double value;
+      if (valid() && magnet::string::parse_double(_attr->value(), _attr->value() + _attr->value_size(), value))
+	return value;
+      return lexicalCast<double>();
+    }
+
+    /*! \brief Fast conversion of unsigned integers (e.g., particle
+        IDs).
+     */
+    template<> inline size_t Attribute::as<size_t>() const
+    {
+      size_t value;
+      if (valid() && magnet::string::parse_unsigned(_attr->value(), _attr->value() + _attr->value_size(), value))
+	return value;
+      return lexicalCast<size_t>();
+    }
+
     /*! \brief Represents a Node of an XML Document.
      */
     class Node {
@@ -314,43 +353,42 @@ namespace magnet {
     */
     class Document {
     public:
-      /*! \brief Decompress (if needed) and parse an XML file. */
-      Document(std::string filename) {
-	_data.clear();
-	
-	if (std::string(filename.end() - 4, filename.end()) == ".bz2") {
+      /*! \brief Decompress (if needed) and parse an XML file.
+
+        Uncompressed files are memory mapped copy-on-write
+        (MAP_PRIVATE) where available, so the file text is parsed in
+        place without being copied into memory first. Compressed files
+        made of several bzip2 streams (as written by XmlStream or
+        pbzip2) are decompressed in parallel, otherwise they are
+        decompressed into a single buffer pre-sized from the
+        compressed file size.
+       */
+      Document(std::string filename):
+	_text(NULL), _map(NULL), _mapSize(0)
+      {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if ((filename.size() >= 4) && (std::string(filename.end() - 4, filename.end()) == ".bz2")) {
 #ifdef DYNAMO_bzip2_support
-	  FILE* f = fopen (filename.c_str(), "r");
-	  if (!f) {
+	  std::ifstream t(filename, std::ios::binary);
+	  if (!t.is_open())
 	    M_throw() << "Failed to open " << filename << " for reading." ;
-	  }
-	  int bzerror;
-	  BZFILE* b = BZ2_bzReadOpen(&bzerror, f, 0, 0, NULL, 0);
-	  if (bzerror != BZ_OK) {
-	    BZ2_bzReadClose(&bzerror, b);
-	    fclose(f);
-	    M_throw() << "Failed beginning decompression of " << filename << " for reading." ;
-	  }
-	  char buf[1024 * 10];
-	  bzerror = BZ_OK;
-	  while (bzerror == BZ_OK) {
-	    size_t nBuf = BZ2_bzRead(&bzerror, b, buf, sizeof(buf));
-	    if ((bzerror == BZ_OK) || (bzerror == BZ_STREAM_END))
-	      _data.append(buf, nBuf);
-	  }
-	  
-	  if (bzerror != BZ_STREAM_END ) {
-	    BZ2_bzReadClose (&bzerror, b);
-	    fclose(f);
-	    M_throw() << "Failed while decompressing " << filename << " for reading. (bzerror=" << bzerror << ")";
-	  } else {
-	    BZ2_bzReadClose ( &bzerror, b );
-	    fclose(f);
+	  t.seekg(0, std::ios::end);
+	  std::vector<char> compressed(t.tellg());
+	  t.seekg(0, std::ios::beg);
+	  t.read(compressed.data(), compressed.size());
+	  if (!t)
+	    M_throw() << "Failed while reading " << filename;
+
+	  try {
+	    magnet::stream::bzip2_decompress(compressed.data(), compressed.size(), _data);
+	  } catch (magnet::exception& err) {
+	    M_throw() << "Failed while decompressing " << filename << " for reading.\n" << err.what();
 	  }
 #else
 	  M_throw() << "bz2 compressed file support was not built in! (only available on linux)";
 #endif
-	} else {
+	} else if (!mapFile(filename)) {
 	  std::ifstream t(filename);
 	  if (!t.is_open())
 	    M_throw() << "Failed to open " << filename << " for reading." ;
@@ -359,8 +397,39 @@ namespace magnet {
 	  t.seekg(0, std::ios::beg);
 	  _data.assign((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
 	}
+
+	if (!_text) _text = &_data[0];
+	parseData();
+	_loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      /*! \brief Parse an XML document held in memory.
+
+	\param data The start of the XML text (a copy is taken).
+	\param length The number of characters of XML text.
+      */
+      Document(const char* data, const size_t length):
+	_data(data, length), _text(&_data[0]), _map(NULL), _mapSize(0)
+      {
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 	parseData();
+	_loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      }
+
+      ~Document()
+      {
+#ifdef __unix__
+	if (_map) munmap(_map, _mapSize);
+#endif
       }
+
+      /*! \brief The time taken (in seconds) to read, decompress and
+        parse the Document.*/
+      double getLoadTime() const { return _loadTime; }
+
+      /*! \brief True if the Document text is a memory mapping of the
+        file.*/
+      bool isMapped() const { return _map != NULL; }
       
       /*! \brief Return the first root node with a certain name in the
         Document.
@@ -382,20 +451,20 @@ namespace magnet {
       { 
 	try {
 	  //Parse in non-destructive mode to allow verbose error reporting
-	  _doc.parse<rapidxml::parse_non_destructive | rapidxml::parse_validate_closing_tags | rapidxml::parse_trim_whitespace>(&_data[0]);
+	  _doc.parse<rapidxml::parse_non_destructive | rapidxml::parse_validate_closing_tags | rapidxml::parse_trim_whitespace>(_text);
 	} catch (rapidxml::parse_error& err)
 	  {
 	    const char* error_loc_ptr = err.where<char>();
 
 	    //Find the line of the error
 	    size_t line_num = 1;
-	    for (const char* ptr = &_data[0]; ptr < error_loc_ptr; ++ptr)
+	    for (const char* ptr = _text; ptr < error_loc_ptr; ++ptr)
 	      if (*ptr == '\n') 
 		++line_num;
 
 	    //Determine the start of the error line
 	    const char* error_line_start = error_loc_ptr;
-	    while ((*error_line_start != '\n') && (error_line_start != &_data[0]))
+	    while ((*error_line_start != '\n') && (error_line_start != _text))
 	      --error_line_start;
 	    ++error_line_start;
 
@@ -410,7 +479,63 @@ namespace magnet {
 	  }
       }
 
+      /*! \brief Memory map a file for parsing.
+
+        The file is mapped copy-on-write so that the parser may write
+        to the text without modifying the file. The mapping is placed
+        at the start of an anonymous mapping at least one byte larger
+        than the file, which provides the zero terminator rapidxml
+        requires.
+
+	\return false if the file could not be mapped, the caller
+	should fall back to reading the file.
+       */
+      inline bool mapFile(const std::string& filename)
+      {
+#ifdef __unix__
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size == 0))
+	  { close(fd); return false; }
+
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	const size_t fileSize = st.st_size;
+	_mapSize = (fileSize + 1 + pageSize - 1) / pageSize * pageSize;
+
+	void* region = mmap(NULL, _mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (region == MAP_FAILED)
+	  { close(fd); return false; }
+
+	if (mmap(region, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+	  {
+	    munmap(region, _mapSize);
+	    close(fd);
+	    return false;
+	  }
+	close(fd);
+	madvise(region, fileSize, MADV_SEQUENTIAL);
+
+	_map = region;
+	_text = static_cast<char*>(region);
+	return true;
+#else
+	return false;
+#endif
+      }
+
+      Document(const Document&) = delete;
+      Document& operator=(const Document&) = delete;
+
+      //! \brief Storage for the text of decompressed or read files.
       std::string _data;
+      //! \brief The zero terminated text being parsed.
+      char* _text;
+      //! \brief The memory mapping of the file (if used).
+      void* _map;
+      size_t _mapSize;
+      double _loadTime;
       rapidxml::xml_document<> _doc;
     };
 
@@ -19,13 +19,13 @@
 #pragma once
 #include <memory>
 #include <magnet/exception.hpp>
+#include <magnet/string/numeric.hpp>
 #include <stack>
 #include <string>
 #include <sstream>
 #include <fstream>
 #ifdef DYNAMO_bzip2_support
-# include <bzlib.h>
-# include <vector>
+# include <magnet/stream/bzip2.hpp>
 #endif
 
 namespace magnet {
@@ -52,7 +52,7 @@ namespace magnet {
       };
     
       inline XmlStream():
-	state(stateNone), prologWritten(false), FormatXML(false)
+	state(stateNone), prologWritten(false), FormatXML(false), _indent(0)
       {}
         
       inline ~XmlStream() {
@@ -62,16 +62,15 @@ namespace magnet {
       inline void write_file(std::string filename) {
 	if (std::string(filename.end() - 4, filename.end()) == ".bz2") {
 #ifdef DYNAMO_bzip2_support
-	  BZFILE* f = BZ2_bzopen(filename.c_str(), "w");
-	  if (!f)
+	  //Compress the XML in parallel blocks
+	  const std::string text = s.str();
+	  const std::string compressed = magnet::stream::bzip2_compress(text.data(), text.size());
+	  std::ofstream of(filename, std::ios::binary);
+	  if (!of)
 	    M_throw() << "Failed to open compressed file " << filename << " for writing.";
-
-	  std::vector<char> buf((std::istreambuf_iterator<char>(s)), std::istreambuf_iterator<char>());
-	  
-	  int nWritten = BZ2_bzwrite(f, buf.data(), buf.size());
-	  if (nWritten <= 0)
+	  of.write(compressed.data(), compressed.size());
+	  if (!of)
 	    M_throw() << "Failed to while writing contents of compressed file " << filename << ".";
-	  BZ2_bzclose(f);
 #else
 	  M_throw() << "bz2 compressed file support was not built in! (only available on linux)";
 #endif
@@ -88,6 +87,34 @@ namespace magnet {
       void clear() {
 	s.str("");
       }
+
+      //! \brief Returns a copy of the XML written so far.
+      inline std::string str() const { return s.str(); }
+
+      /*! \brief Prepare this (empty) stream to hold a fragment of
+        XML which will be inserted into parent at its current
+        position using appendFragment().
+
+        The formatting and indentation of parent are copied. This
+        allows large sections of XML to be written concurrently into
+        separate fragments.
+       */
+      inline void beginFragment(const XmlStream& parent) {
+	s.copyfmt(parent.s);
+	_indent = parent.tags.size() + parent._indent;
+      }
+
+      /*! \brief Insert the XML of a fragment at the current
+        position, closing any open tag first.
+       */
+      inline void appendFragment(const XmlStream& fragment) {
+	if (!fragment.tags.empty())
+	  M_throw() << "Cannot append an XML fragment with unclosed tags";
+	closeTagStart();
+	state = stateNone;
+	const std::string text = fragment.s.str();
+	s.write(text.data(), text.size());
+      }
       
       /*! \brief Main insertion operator which changes the state of
         the XmlStream.
@@ -103,7 +130,7 @@ namespace magnet {
 	  break;
 	case Controller::Tag:
 	  closeTagStart();
-	  for (size_t i(0); i < tags.size(); ++i) s << "  ";
+	  for (size_t i(0); i < tags.size() + _indent; ++i) s << "  ";
 	  s << '<' << controller._str;
 	  tags.push(controller._str);
 	  state = stateTag;
@@ -135,6 +162,21 @@ namespace magnet {
 	return XML;
       }
 
+      /*! \brief Overload for doubles, which avoids the iostream
+	formatting machinery. At full precision (max_digits10) the
+	shortest text which reads back to the same value is written.
+       */
+      friend XmlStream& operator<<(XmlStream& XML, const double& value) {
+	if (XML.s.flags() & std::ios::floatfield)
+	  XML.s << value;
+	else
+	  {
+	    char buf[32];
+	    XML.s.write(buf, magnet::string::format_double(buf, value, XML.s.precision()));
+	  }
+	return XML;
+      }
+
       /*! \brief Specialisation for pointers. */
       template<class T>
       friend XmlStream& operator<<(XmlStream& XML, const std::shared_ptr<T>& value) {
@@ -168,6 +210,8 @@ namespace magnet {
       bool	prologWritten;
       std::ostringstream	tagName;
       bool        FormatXML;
+      //! \brief Extra indentation for fragments of a parent stream.
+      size_t      _indent;
     
       //! \brief Closes the current tag.
       inline void closeTagStart(bool self_closed = false)
@@ -192,7 +236,7 @@ namespace magnet {
 	while (tags.size() > 0 && !brk) {
 	  if (state == stateNone)
 	    {
-	      for (size_t i(1); i < tags.size(); ++i)
+	      for (size_t i(1); i < tags.size() + _indent; ++i)
 		s << "  ";
 	      s << "</" << tags.top() << ">\n";
 	    }
@@ -0,0 +1,111 @@
+#define BOOST_TEST_MODULE Correlator_test
+#include <boost/test/included/unit_test.hpp>
+#include <magnet/math/correlators.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace magnet::math;
+
+BOOST_AUTO_TEST_CASE( MultipleTau_first_level )
+{
+  //The first level is identical to a Correlator of the same length
+  std::mt19937 RNG(42);
+  std::normal_distribution<double> dist;
+  const size_t length = 8;
+  Correlator<double> direct(length);
+  MultipleTauCorrelator<double> multitau(length);
+  for (size_t i(0); i < 1000; ++i)
+    {
+      const double W1 = dist(RNG), W2 = dist(RNG);
+      direct.push(W1, W2);
+      multitau.push(W1, W2);
+    }
+
+  const std::vector<double> expected = direct.getAveragedCorrelator();
+  const std::vector<MultipleTauCorrelator<double>::Data> result = multitau.getAveragedCorrelator();
+  BOOST_REQUIRE(result.size() > length);
+  for (size_t j(0); j < length; ++j)
+    {
+      BOOST_CHECK_EQUAL(result[j].lag, j + 1);
+      BOOST_CHECK_EQUAL(result[j].sample_count, direct.getSampleCount(j));
+      BOOST_CHECK_CLOSE(result[j].value, expected[j], 1e-10);
+    }
+}
+
+BOOST_AUTO_TEST_CASE( MultipleTau_levels )
+{
+  std::mt19937 RNG(7);
+  std::normal_distribution<double> dist;
+  const size_t length = 4, levels = 3, samples = 1000;
+  std::vector<double> W(samples);
+  MultipleTauCorrelator<double> multitau(length, levels);
+  for (double& val : W)
+    {
+      val = dist(RNG);
+      multitau.push(val, val);
+    }
+
+  //Compare each lag against a direct sum over the blocks of its
+  //level. The first level has the lags 1 to length, later levels
+  //have the lags 2 to length blocks.
+  const std::vector<MultipleTauCorrelator<double>::Data> result = multitau.getAveragedCorrelator();
+  BOOST_REQUIRE_EQUAL(result.size(), length + (levels - 1) * (length - 1));
+  for (size_t idx(0); idx < result.size(); ++idx)
+    {
+      const MultipleTauCorrelator<double>::Data& data = result[idx];
+      size_t block = 1, j = idx + 1;
+      if (idx >= length)
+	{
+	  for (size_t level(0); level < 1 + (idx - length) / (length - 1); ++level)
+	    block *= length;
+	  j = 2 + (idx - length) % (length - 1);
+	}
+      BOOST_CHECK_EQUAL(data.lag, j * block);
+
+      std::vector<double> blocks(samples / block, 0);
+      for (size_t i(0); i < blocks.size() * block; ++i)
+	blocks[i / block] += W[i];
+
+      double sum = 0;
+      size_t count = 0;
+      for (size_t m(j - 1); m < blocks.size(); ++m, ++count)
+	{
+	  double W_sum = 0;
+	  for (size_t i(m + 1 - j); i <= m; ++i)
+	    W_sum += blocks[i];
+	  sum += W_sum * W_sum;
+	}
+
+      BOOST_CHECK_EQUAL(data.sample_count, count);
+      BOOST_CHECK_CLOSE(data.value, sum / count, 1e-10);
+    }
+
+  //The number of levels is bounded
+  BOOST_CHECK_EQUAL(result.back().lag, length * length * length);
+}
+
+BOOST_AUTO_TEST_CASE( LogarithmicTime_freestream )
+{
+  //A constant flux gives W = flux * t for every time origin
+  LogarithmicTimeCorrelator<Vector> correlator;
+  correlator.resize(0.5, 4);
+  const Vector flux{1, 2, 3};
+  correlator.setFreeStreamValue(flux);
+  for (size_t i(0); i < 300; ++i)
+    correlator.freeStream(0.3);
+
+  const std::vector<LogarithmicTimeCorrelator<Vector>::Data> data = correlator.getAveragedCorrelator();
+  BOOST_REQUIRE(data.size() > 4);
+  for (const LogarithmicTimeCorrelator<Vector>::Data& point : data)
+    for (size_t i(0); i < 3; ++i)
+      BOOST_CHECK_CLOSE(point.value[i], std::pow(flux[i] * point.time, 2), 1e-8);
+
+  //Impulses are only counted in the sample they occur in
+  correlator.clear();
+  correlator.addImpulse(flux);
+  correlator.freeStream(1.0);
+  BOOST_CHECK_EQUAL(correlator.getAveragedCorrelator().size(), 2u);
+  BOOST_CHECK_CLOSE(correlator.getAveragedCorrelator()[0].value[2], 4.5, 1e-8);
+  BOOST_CHECK_CLOSE(correlator.getAveragedCorrelator()[1].value[2], 9, 1e-8);
+}
@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE Numeric_test
+#include <boost/test/included/unit_test.hpp>
+#include <magnet/string/numeric.hpp>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace magnet::string;
+
+namespace {
+  bool parse(const std::string& text, double& value)
+  { return parse_double(text.data(), text.data() + text.size(), value); }
+}
+
+BOOST_AUTO_TEST_CASE( parse_double_values )
+{
+  const char* values[] = {"0", "-0", "1", "+2.5", "0.1", "-1.25e-3", "1E10", "123456789012345",
+			  "0.12345678901234567", "4.9406564584124654e-324", "1.7976931348623157e308",
+			  "2.2250738585072014e-308", "1e23", "9007199254740993", ".5", "5."};
+  for (const char* text : values)
+    {
+      double value;
+      BOOST_CHECK(parse(text, value));
+      BOOST_CHECK_EQUAL(value, std::strtod(text, NULL));
+    }
+
+  double value;
+  BOOST_CHECK(parse("-0", value) && std::signbit(value));
+  BOOST_CHECK(parse("inf", value) && std::isinf(value));
+  BOOST_CHECK(parse("nan", value) && std::isnan(value));
+}
+
+BOOST_AUTO_TEST_CASE( parse_double_invalid )
+{
+  const char* values[] = {"", "-", ".", "e5", "1e", "1e+", " 1", "1 ", "1.0x", "0x", "--1"};
+  for (const char* text : values)
+    {
+      double value;
+      BOOST_CHECK_MESSAGE(!parse(text, value), "\"" << text << "\" should not parse");
+    }
+}
+
+BOOST_AUTO_TEST_CASE( parse_unsigned_values )
+{
+  size_t value;
+  const std::string max = std::to_string(std::numeric_limits<size_t>::max());
+  BOOST_CHECK(parse_unsigned(max.data(), max.data() + max.size(), value));
+  BOOST_CHECK_EQUAL(value, std::numeric_limits<size_t>::max());
+
+  const std::string overflow = max + "0";
+  BOOST_CHECK(!parse_unsigned(overflow.data(), overflow.data() + overflow.size(), value));
+
+  const char negative[] = "-1";
+  BOOST_CHECK(!parse_unsigned(negative, negative + 2, value));
+}
+
+BOOST_AUTO_TEST_CASE( format_double_round_trip )
+{
+  std::mt19937 RNG;
+  std::uniform_int_distribution<uint64_t> bits;
+  std::normal_distribution<double> normal;
+  std::uniform_real_distribution<double> decade(-6, 16);
+  for (size_t i(0); i < 100000; ++i)
+    {
+      double value;
+      if (i % 3 == 1)
+	value = normal(RNG);
+      else if (i % 3 == 2)
+	value = std::pow(10.0, decade(RNG));
+      else
+	{
+	  const uint64_t b = bits(RNG);
+	  std::memcpy(&value, &b, sizeof(value));
+	  if (!std::isfinite(value)) continue;
+	}
+
+      char buf[32];
+      const int length = format_double(buf, value, 17);
+      BOOST_REQUIRE_EQUAL(int(std::strlen(buf)), length);
+
+      double result;
+      BOOST_REQUIRE(parse_double(buf, buf + length, result));
+      BOOST_REQUIRE_EQUAL(result, value);
+
+      //Check against the shortest of the printf representations
+      //which round trip
+      for (int digits(15); digits <= 17; ++digits)
+	{
+	  char reference[32];
+	  std::snprintf(reference, sizeof(reference), "%.*g", digits, value);
+	  if (std::strtod(reference, NULL) == value)
+	    {
+	      BOOST_REQUIRE_MESSAGE(length <= int(std::strlen(reference)), buf << " is longer than " << reference);
+	      break;
+	    }
+	}
+    }
+
+  //Shortest output for exactly representable values
+  char buf[32];
+  format_double(buf, 0.5, 17);
+  BOOST_CHECK_EQUAL(std::string(buf), "0.5");
+  format_double(buf, 0.1, 17);
+  BOOST_CHECK_EQUAL(std::string(buf), "0.1");
+
+  //Reduced precision matches printf
+  format_double(buf, 1.0 / 3, 13);
+  BOOST_CHECK_EQUAL(std::string(buf), "0.3333333333333");
+}
@@ -0,0 +1,44 @@
+#define BOOST_TEST_MODULE SphericalHarmonics_test
+#include <boost/test/included/unit_test.hpp>
+#include <boost/math/special_functions/spherical_harmonic.hpp>
+#include <magnet/math/spherical_harmonics.hpp>
+#include <cmath>
+#include <random>
+
+std::mt19937 RNG;
+std::normal_distribution<double> normal_dist(0, 1);
+using namespace magnet::math;
+
+BOOST_AUTO_TEST_CASE( SphericalHarmonics_boost )
+{
+  const size_t L = 13;
+  SphericalHarmonics Y(L);
+  for (size_t i(0); i < 100; ++i)
+    {
+      Vector r{normal_dist(RNG), normal_dist(RNG), normal_dist(RNG)};
+      r /= r.nrm();
+      Y.evaluate(r);
+
+      const double theta = std::acos(r[2]);
+      const double phi = std::atan2(r[1], r[0]);
+      for (size_t l(0); l < L; ++l)
+	for (int m(-int(l)); m <= int(l); ++m)
+	  {
+	    const std::complex<double> expected = boost::math::spherical_harmonic(l, m, theta, phi);
+	    BOOST_CHECK_SMALL(std::abs(Y(l, m) - expected), 1e-12);
+	  }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( SphericalHarmonics_poles )
+{
+  //Only the m=0 harmonics are non-zero along the polar axis
+  SphericalHarmonics Y(8);
+  Y.evaluate(Vector{0, 0, -1});
+  for (size_t l(0); l < 8; ++l)
+    {
+      BOOST_CHECK_CLOSE(Y(l, 0).real(), std::sqrt((2 * l + 1) / (4 * M_PI)) * ((l % 2) ? -1 : 1), 1e-12);
+      for (size_t m(1); m <= l; ++m)
+	BOOST_CHECK_EQUAL(std::abs(Y(l, m)), 0);
+    }
+}
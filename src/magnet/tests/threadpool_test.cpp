@@ -2,6 +2,9 @@
 #include <vector>
 #include <stdexcept>
 #include <magnet/thread/threadpool.hpp>
+#include <magnet/thread/workstealing.hpp>
+#include <atomic>
+#include <chrono>
 
 std::vector<float> sums;
 
@@ -33,8 +36,82 @@ struct A
   { std::cerr << "Inside memberfunc3, i=" << i << ", j=" << j << "\n"; }
 };
 
+//A tiny task, used to measure the per-task overhead of the pools
+std::atomic<size_t> counter;
+void tinyTask() { ++counter; }
+
+template<class Pool>
+double taskThroughput(Pool& pool, size_t tasks)
+{
+  counter = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t i(0); i < tasks; ++i)
+    pool.queueTask(tinyTask);
+  pool.wait();
+  double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+  if (counter != tasks)
+    throw std::runtime_error("Not all tasks were executed");
+
+  return tasks / seconds;
+}
+
+void testWorkStealing(size_t threads)
+{
+  magnet::thread::WorkStealingPool wspool;
+  wspool.setThreadCount(threads);
+  magnet::thread::ThreadPool pool;
+  pool.setThreadCount(threads);
+
+  const size_t tasks = 200000;
+  std::cerr << threads << " threads, ThreadPool throughput " << taskThroughput(pool, tasks) << " tasks/s\n";
+  std::cerr << threads << " threads, WorkStealingPool throughput " << taskThroughput(wspool, tasks) << " tasks/s\n";
+
+  //Test parallel_for covers the range exactly once, for a variety of grain sizes
+  const size_t N = 100000;
+  for (size_t grain : {0, 1, 7, 1000, 1000000})
+    {
+      std::vector<int> visits(N, 0);
+      auto start = std::chrono::high_resolution_clock::now();
+      wspool.parallel_for(0, N, [&](size_t i) { ++visits[i]; }, grain);
+      double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+      for (size_t i(0); i < N; ++i)
+	if (visits[i] != 1)
+	  throw std::runtime_error("parallel_for did not visit every index exactly once");
+
+      std::cerr << threads << " threads, parallel_for grain=" << grain << " throughput " << N / seconds << " indices/s\n";
+    }
+
+  //Test nested task groups, where tasks spawn and wait on their own groups
+  counter = 0;
+  {
+    magnet::thread::TaskGroup outer(wspool);
+    for (size_t i(0); i < 100; ++i)
+      outer.run([&]() {
+	  magnet::thread::TaskGroup inner(wspool);
+	  for (size_t j(0); j < 100; ++j)
+	    inner.run(tinyTask);
+	  inner.wait();
+	});
+    outer.wait();
+  }
+  if (counter != 100 * 100)
+    throw std::runtime_error("Nested task groups did not execute all tasks");
+
+  //Test exceptions are passed to the waiting thread
+  bool caught = false;
+  wspool.queueTask([]() { throw std::runtime_error("Test exception"); });
+  try { wspool.wait(); } catch (std::exception&) { caught = true; }
+  if (!caught)
+    throw std::runtime_error("Exception was not passed to the waiting thread");
+}
+
 int main()
 {
+  for (size_t threads : {0, 1, 4})
+    testWorkStealing(threads);
+
   int N = 1000;
   sums.resize(N);
 
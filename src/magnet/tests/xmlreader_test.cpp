@@ -0,0 +1,117 @@
+#define BOOST_TEST_MODULE XMLReader_test
+#include <boost/test/included/unit_test.hpp>
+#include <magnet/xmlreader.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace magnet::xml;
+
+namespace {
+  //Write a document with a single attribute whose file is exactly
+  //the requested size (padded with a comment).
+  std::string writeDocument(const std::string& filename, const size_t size)
+  {
+    const std::string head = "<Root Value=\"42\"><Child/></Root><!--";
+    const std::string tail = "-->";
+    std::string text = head + std::string(size - head.size() - tail.size(), 'x') + tail;
+    std::ofstream of(filename, std::ios::binary);
+    of << text;
+    return text;
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Document_mapped_page_sized )
+{
+  //A file which exactly fills its pages has no trailing zero in the
+  //file mapping, check the terminator is still provided.
+  const std::string filename = "xmlreader_test_page.xml";
+  writeDocument(filename, sysconf(_SC_PAGESIZE));
+  {
+    Document doc(filename);
+    BOOST_CHECK(doc.isMapped());
+    BOOST_CHECK_EQUAL(doc.getNode("Root").getAttribute("Value").as<int>(), 42);
+    BOOST_CHECK(doc.getNode("Root").hasNode("Child"));
+    BOOST_CHECK(doc.getLoadTime() >= 0);
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( Document_mapped_matches_memory )
+{
+  const std::string filename = "xmlreader_test_odd.xml";
+  const std::string text = writeDocument(filename, 1000);
+  {
+    Document mapped(filename);
+    Document memory(text.data(), text.size());
+    BOOST_CHECK(mapped.isMapped());
+    BOOST_CHECK(!memory.isMapped());
+    BOOST_CHECK_EQUAL(mapped.getNode("Root").getAttribute("Value").getValue(),
+		      memory.getNode("Root").getAttribute("Value").getValue());
+  }
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE( Document_parse_error )
+{
+  const std::string filename = "xmlreader_test_bad.xml";
+  {
+    std::ofstream of(filename);
+    of << "<Root>\n<Child>\n</Root>";
+  }
+  BOOST_CHECK_THROW(Document doc(filename), std::exception);
+  std::remove(filename.c_str());
+}
+
+#ifdef DYNAMO_bzip2_support
+#include <magnet/xmlwriter.hpp>
+#include <magnet/stream/bzip2.hpp>
+
+BOOST_AUTO_TEST_CASE( bzip2_block_parallel )
+{
+  //Several 900kB blocks of compressible, but not trivial, data
+  std::string data;
+  for (size_t i(0); data.size() < 3000000; ++i)
+    data += std::to_string(i * 7919 % 100003) + ' ';
+
+  const std::string compressed = magnet::stream::bzip2_compress(data.data(), data.size());
+  std::string result;
+  magnet::stream::bzip2_decompress(compressed.data(), compressed.size(), result);
+  BOOST_CHECK(result == data);
+
+  //A single stream file (as written by bzip2) is decompressed serially
+  unsigned int length = data.size();
+  std::string single(length, '\0');
+  BOOST_REQUIRE_EQUAL(BZ2_bzBuffToBuffCompress(&single[0], &length, const_cast<char*>(data.data()), data.size(), 9, 0, 0), BZ_OK);
+  single.resize(length);
+  magnet::stream::bzip2_decompress(single.data(), single.size(), result);
+  BOOST_CHECK(result == data);
+
+  //Corrupt data is reported
+  std::string corrupt = compressed;
+  corrupt[compressed.size() / 2] ^= 0xFF;
+  BOOST_CHECK_THROW(magnet::stream::bzip2_decompress(corrupt.data(), corrupt.size(), result), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE( Document_bzip2 )
+{
+  const std::string filename = "xmlreader_test.xml.bz2";
+  {
+    XmlStream XML;
+    XML << tag("Root") << attr("Value") << 42;
+    for (size_t i(0); i < 100000; ++i)
+      XML << tag("Pt") << attr("ID") << i << endtag("Pt");
+    XML << endtag("Root");
+    XML.write_file(filename);
+  }
+  {
+    Document doc(filename);
+    BOOST_CHECK_EQUAL(doc.getNode("Root").getAttribute("Value").as<int>(), 42);
+    size_t count = 0;
+    for (Node node = doc.getNode("Root").findNode("Pt"); node.valid(); ++node, ++count)
+      BOOST_REQUIRE_EQUAL(node.getAttribute("ID").as<size_t>(), count);
+    BOOST_CHECK_EQUAL(count, 100000u);
+  }
+  std::remove(filename.c_str());
+}
+#endif